@@ -15,18 +15,27 @@ LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/BufferFile.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/File.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/FSFile.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/MemoryFile.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Epoch.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/MsgThread.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Queue.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Semaphore.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Thread.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/BufferedStream.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/HostNameResolver.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/IPAddress.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/Lib.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/Socket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/TCPListenerGroup.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/TCPServerSocket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/TCPSocket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UDPSocket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UnixDatagramSocket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UnixServerSocket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UnixSocket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UnixStreamSocket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/timer.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/TimingWheel.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/WaitableTimer.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/WaitSet.cpp
 
 #LOCAL_CFLAGS := -DDEBUG
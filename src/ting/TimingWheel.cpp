@@ -0,0 +1,224 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+
+
+
+using namespace ting::timer;
+
+
+
+namespace{
+
+inline unsigned CountTrailingZeros(std::uint64_t v)NOEXCEPT{
+	ASSERT(v != 0)
+#if M_COMPILER == M_COMPILER_GCC
+	return unsigned(__builtin_ctzll(v));
+#else
+	unsigned ret = 0;
+	for(; (v & 1) == 0; v >>= 1){
+		++ret;
+	}
+	return ret;
+#endif
+}
+
+}//~namespace
+
+
+
+TimingWheel::TimingWheel(std::uint64_t ticks)NOEXCEPT :
+		curTicks(ticks)
+{
+	for(auto& s : this->slots){
+		s.prev = &s;
+		s.next = &s;
+	}
+	this->occupied.fill(0);
+}
+
+
+
+unsigned TimingWheel::FindOccupied(unsigned begin, unsigned end)const NOEXCEPT{
+	while(begin < end){
+		std::uint64_t word = this->occupied[begin / 64] >> (begin % 64);
+		if(word != 0){
+			unsigned ret = begin + CountTrailingZeros(word);
+			return ret < end ? ret : end;
+		}
+		begin = (begin / 64 + 1) * 64;
+	}
+	return end;
+}
+
+
+
+void TimingWheel::Place(Node& node)NOEXCEPT{
+	ASSERT(node.expiration >= this->curTicks)
+	std::uint64_t delta = node.expiration - this->curTicks;
+
+	unsigned slot;
+	if(delta < DLevel0Size){
+		slot = unsigned(node.expiration % DLevel0Size);
+	}else{
+		unsigned level = 1;
+		unsigned shift = DLevel0Bits;
+		for(; level != DNumUpperLevels; ++level, shift += DLevelBits){
+			if((delta >> (shift + DLevelBits)) == 0){
+				break;
+			}
+		}
+		slot = DLevel0Size + (level - 1) * DLevelSize + unsigned((node.expiration >> shift) % DLevelSize);
+	}
+
+	Link(this->slots[slot], node);
+	node.slot = slot;
+	this->SetOccupied(slot);
+}
+
+
+
+void TimingWheel::Insert(Node& node, std::uint64_t expiration)NOEXCEPT{
+	ASSERT(!node.IsInserted())
+
+	if(expiration <= this->curTicks){
+		expiration = this->curTicks + 1;
+	}
+
+	node.expiration = expiration;
+	this->Place(node);
+	++this->size;
+}
+
+
+
+void TimingWheel::Remove(Node& node)NOEXCEPT{
+	ASSERT(node.IsInserted())
+	ASSERT(this->size != 0)
+
+	node.prev->next = node.next;
+	node.next->prev = node.prev;
+
+	Node& head = this->slots[node.slot];
+	if(head.next == &head){
+		this->ClearOccupied(node.slot);
+	}
+
+	node.prev = nullptr;
+	node.next = nullptr;
+	--this->size;
+}
+
+
+
+void TimingWheel::Cascade()NOEXCEPT{
+	if(this->curTicks % DLevel0Size != 0){
+		return;
+	}
+
+	//lowest level has made a full turn, cascade corresponding slots of higher levels
+	unsigned shift = DLevel0Bits;
+	for(unsigned level = 1; level <= DNumUpperLevels; ++level, shift += DLevelBits){
+		unsigned index = unsigned((this->curTicks >> shift) % DLevelSize);
+		unsigned slot = DLevel0Size + (level - 1) * DLevelSize + index;
+
+		Node& head = this->slots[slot];
+		if(head.next != &head){
+			//detach the list from the slot and redistribute its nodes
+			Node* n = head.next;
+			head.prev->next = nullptr;
+			head.prev = &head;
+			head.next = &head;
+			this->ClearOccupied(slot);
+
+			while(n){
+				Node* next = n->next;
+				this->Place(*n);
+				n = next;
+			}
+		}
+
+		if(index != 0){
+			break;//this level has not made a full turn
+		}
+	}
+}
+
+
+
+std::uint64_t TimingWheel::NextEventTicks()const NOEXCEPT{
+	if(this->size == 0){
+		return std::uint64_t(-1);
+	}
+
+	//returns distance from 'cur' slot to next occupied slot in the level, or 0 if level is empty
+	auto distance = [this](unsigned base, unsigned levelSize, unsigned cur) -> unsigned{
+		unsigned s = this->FindOccupied(base + cur + 1, base + levelSize);
+		if(s != base + levelSize){
+			return s - (base + cur);
+		}
+		s = this->FindOccupied(base, base + cur + 1);
+		if(s != base + cur + 1){
+			return s + levelSize - (base + cur);
+		}
+		return 0;
+	};
+
+	std::uint64_t ret = std::uint64_t(-1);
+
+	if(unsigned d = distance(0, DLevel0Size, unsigned(this->curTicks % DLevel0Size))){
+		ret = this->curTicks + d;
+
+		//higher levels are only cascaded when lowest level makes a full turn
+		if(ret % DLevel0Size != 0 && ret / DLevel0Size == this->curTicks / DLevel0Size){
+			return ret;
+		}
+	}
+
+	unsigned shift = DLevel0Bits;
+	for(unsigned level = 1; level <= DNumUpperLevels; ++level, shift += DLevelBits){
+		unsigned d = distance(
+				DLevel0Size + (level - 1) * DLevelSize,
+				DLevelSize,
+				unsigned((this->curTicks >> shift) % DLevelSize)
+			);
+		if(d == 0){
+			continue;
+		}
+
+		//the slot is cascaded when lower levels make a full turn
+		std::uint64_t turns = (this->curTicks >> shift) + d;
+		if(turns > (std::uint64_t(-1) >> shift)){
+			continue;//overflow, the slot is too far
+		}
+		ret = std::min(ret, turns << shift);
+	}
+
+	return ret;
+}
@@ -0,0 +1,237 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @file TimingWheel.hpp
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Hierarchical timing wheel.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "util.hpp"
+
+
+
+namespace ting{
+namespace timer{
+
+
+
+/**
+ * @brief Hierarchical timing wheel.
+ * Container of timeouts which provides O(1) insertion and removal of timeouts
+ * and bounded cost of processing expired timeouts.
+ * The wheel consists of several levels. Lowest level has 256 slots, each slot
+ * corresponds to one tick. Each of the higher levels has 64 slots, and each slot of the
+ * level spans the whole lower level. When the lower level makes a full turn the
+ * corresponding slot of the higher level is cascaded, i.e. its timeouts are redistributed
+ * to the lower levels. Thus, each timeout is moved between levels at most a few times
+ * during its life time. The wheel covers the whole 64 bit range of ticks.
+ * Timeouts are intrusive nodes, so no memory allocation is done by the wheel.
+ * The wheel is not thread-safe, user should do all the necessary synchronization.
+ */
+class TimingWheel{
+public:
+	/**
+	 * @brief Timeout node which can be inserted to the wheel.
+	 */
+	class Node{
+		friend class TimingWheel;
+
+		Node* prev = nullptr;
+		Node* next = nullptr;
+
+		std::uint64_t expiration = 0;
+
+		std::uint32_t slot = 0;
+
+	public:
+		Node() = default;
+
+		Node(const Node&) = delete;
+		Node& operator=(const Node&) = delete;
+
+		/**
+		 * @brief Check if node is inserted to a wheel.
+		 * @return true if node is inserted to a wheel.
+		 */
+		bool IsInserted()const NOEXCEPT{
+			return this->next != nullptr;
+		}
+
+		/**
+		 * @brief Get expiration ticks.
+		 * @return ticks value at which the node will expire.
+		 */
+		std::uint64_t Expiration()const NOEXCEPT{
+			return this->expiration;
+		}
+	};
+
+private:
+	static const unsigned DLevel0Bits = 8;
+	static const unsigned DLevelBits = 6;
+	static const unsigned DLevel0Size = 1 << DLevel0Bits;
+	static const unsigned DLevelSize = 1 << DLevelBits;
+	static const unsigned DNumUpperLevels = (64 - DLevel0Bits + DLevelBits - 1) / DLevelBits;
+	static const unsigned DNumSlots = DLevel0Size + DNumUpperLevels * DLevelSize;
+
+	//slot lists are circular lists with sentinel nodes
+	std::array<Node, DNumSlots> slots;
+
+	//bitmap of non-empty slots, used to find next non-empty slot quickly
+	std::array<std::uint64_t, DNumSlots / 64> occupied;
+
+	std::uint64_t curTicks;
+
+	size_t size = 0;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param ticks - initial ticks value.
+	 */
+	TimingWheel(std::uint64_t ticks = 0)NOEXCEPT;
+
+	TimingWheel(const TimingWheel&) = delete;
+	TimingWheel& operator=(const TimingWheel&) = delete;
+
+	~TimingWheel()NOEXCEPT{
+		ASSERT_INFO(this->size == 0, "TimingWheel is destroyed while it still contains nodes")
+	}
+
+	/**
+	 * @brief Get current ticks.
+	 * @return ticks value to which the wheel has been advanced.
+	 */
+	std::uint64_t Ticks()const NOEXCEPT{
+		return this->curTicks;
+	}
+
+	/**
+	 * @brief Get number of nodes in the wheel.
+	 * @return number of nodes in the wheel.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->size;
+	}
+
+	/**
+	 * @brief Insert node.
+	 * Complexity is O(1).
+	 * @param node - node to insert. Node must not be inserted to any wheel.
+	 * @param expiration - ticks value at which the node expires. If it is not greater than
+	 *                     current ticks of the wheel, the node will expire on next tick.
+	 */
+	void Insert(Node& node, std::uint64_t expiration)NOEXCEPT;
+
+	/**
+	 * @brief Remove node.
+	 * Complexity is O(1).
+	 * @param node - node to remove. Node must be inserted to this wheel.
+	 */
+	void Remove(Node& node)NOEXCEPT;
+
+	/**
+	 * @brief Get ticks of next event.
+	 * Returns the nearest ticks value at which the wheel needs to be advanced to,
+	 * either to expire some nodes or to cascade nodes from a higher level to lower ones.
+	 * Thus, returned value is not greater than expiration of any node in the wheel.
+	 * @return ticks of the next event.
+	 * @return std::uint64_t(-1) if there are no nodes in the wheel.
+	 */
+	std::uint64_t NextEventTicks()const NOEXCEPT;
+
+	/**
+	 * @brief Advance the wheel.
+	 * Moves the wheel forward to the given ticks value and removes all the nodes
+	 * which have expired by that moment. Ticks without any events are skipped
+	 * without processing, so it is cheap to advance the wheel by large ticks interval.
+	 * @param ticks - ticks value to advance the wheel to.
+	 * @param onExpired - functor which is called for every expired node, the node is removed
+	 *                    from the wheel before the call. Nodes are reported in order of their expiration.
+	 *                    The functor is allowed to insert nodes to the wheel, e.g. to re-insert
+	 *                    the expired node, but it is not allowed to remove nodes.
+	 */
+	template <class T_OnExpired> void Advance(std::uint64_t ticks, T_OnExpired&& onExpired){
+		while(this->curTicks < ticks){
+			std::uint64_t next = this->NextEventTicks();
+			if(next > ticks){
+				//no events until given ticks, just jump there
+				this->curTicks = ticks;
+				return;
+			}
+
+			ASSERT(next > this->curTicks)
+			this->curTicks = next;
+
+			this->Cascade();
+
+			Node& head = this->slots[this->curTicks % DLevel0Size];
+			while(head.next != &head){
+				Node& n = *head.next;
+				ASSERT(n.expiration <= this->curTicks)
+				this->Remove(n);
+				onExpired(n);
+			}
+		}
+	}
+
+private:
+	void Place(Node& node)NOEXCEPT;
+
+	void Cascade()NOEXCEPT;
+
+	static void Link(Node& head, Node& node)NOEXCEPT{
+		node.prev = head.prev;
+		node.next = &head;
+		head.prev->next = &node;
+		head.prev = &node;
+	}
+
+	void SetOccupied(unsigned slot)NOEXCEPT{
+		this->occupied[slot / 64] |= (std::uint64_t(1) << (slot % 64));
+	}
+
+	void ClearOccupied(unsigned slot)NOEXCEPT{
+		this->occupied[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+	}
+
+	//returns first occupied slot in [begin, end) or 'end' if all are free
+	unsigned FindOccupied(unsigned begin, unsigned end)const NOEXCEPT;
+};
+
+
+
+}//~namespace
+}//~namespace
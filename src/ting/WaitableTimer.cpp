@@ -0,0 +1,346 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "WaitableTimer.hpp"
+
+#include <sstream>
+#include <cstring>
+
+#if M_OS == M_OS_LINUX
+#	include <sys/timerfd.h>
+#	include <unistd.h>
+#elif M_OS == M_OS_MACOSX
+#	include <sys/types.h>
+#	include <sys/event.h>
+#	include <unistd.h>
+#endif
+
+
+
+using namespace ting;
+
+
+
+#if M_OS == M_OS_LINUX
+namespace{
+timespec ToTimespec(std::chrono::nanoseconds ns){
+	timespec ret;
+	ret.tv_sec = time_t(ns.count() / 1000000000);
+	ret.tv_nsec = long(ns.count() % 1000000000);
+	return ret;
+}
+}
+#endif
+
+
+
+WaitableTimer::WaitableTimer(){
+#if M_OS == M_OS_WINDOWS
+	this->handle = CreateWaitableTimer(
+			NULL, //security attributes
+			TRUE, //manual-reset
+			NULL //no name
+		);
+	if(this->handle == NULL){
+		throw ting::Exc("WaitableTimer::WaitableTimer(): could not create waitable timer (Win32)");
+	}
+#elif M_OS == M_OS_MACOSX
+	this->queue = kqueue();
+	if(this->queue < 0){
+		std::stringstream ss;
+		ss << "WaitableTimer::WaitableTimer(): could not create kqueue (*nix),"
+				<< " error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#elif M_OS == M_OS_LINUX
+	this->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(this->fd < 0){
+		std::stringstream ss;
+		ss << "WaitableTimer::WaitableTimer(): could not create timerfd (linux),"
+				<< " error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+WaitableTimer::~WaitableTimer()NOEXCEPT{
+#if M_OS == M_OS_WINDOWS
+	CloseHandle(this->handle);
+#elif M_OS == M_OS_MACOSX
+	close(this->queue);
+#elif M_OS == M_OS_LINUX
+	close(this->fd);
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+#if M_OS == M_OS_MACOSX
+void WaitableTimer::ArmKqueueTimer(std::chrono::nanoseconds timeout, bool oneShot){
+	struct kevent e;
+	EV_SET(
+			&e,
+			0, //timer identifier
+			EVFILT_TIMER,
+			EV_ADD | EV_ENABLE | (oneShot ? EV_ONESHOT : 0),
+			NOTE_NSECONDS,
+			timeout.count() == 0 ? 1 : timeout.count(),
+			0
+		);
+	if(kevent(this->queue, &e, 1, 0, 0, 0) < 0){
+		std::stringstream ss;
+		ss << "WaitableTimer::Start(): kevent() failed, error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+}
+#endif
+
+
+
+#if M_OS == M_OS_WINDOWS
+void WaitableTimer::Arm(std::chrono::steady_clock::time_point expiration){
+	std::chrono::nanoseconds timeout = expiration - std::chrono::steady_clock::now();
+
+	//relative due time is negative and is measured in 100 nanosecond intervals
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -LONGLONG(timeout.count() / 100);
+	if(dueTime.QuadPart >= 0){
+		dueTime.QuadPart = -1;
+	}
+
+	if(SetWaitableTimer(this->handle, &dueTime, 0, NULL, NULL, FALSE) == 0){
+		throw ting::Exc("WaitableTimer::Start(): SetWaitableTimer() failed");
+	}
+}
+#endif
+
+
+
+void WaitableTimer::Start(std::chrono::nanoseconds timeout, std::chrono::nanoseconds period){
+	ASSERT(timeout.count() >= 0)
+	ASSERT(period.count() >= 0)
+
+	//pending expirations are discarded, so timer is not readable anymore
+	this->ClearCanReadFlag();
+
+#if M_OS == M_OS_WINDOWS
+	this->nextExpiration = std::chrono::steady_clock::now() + timeout;
+	this->period = period;
+	this->Arm(this->nextExpiration);
+	this->isArmed = true;
+#elif M_OS == M_OS_MACOSX
+	this->Stop();
+
+	//kqueue timer has same first timeout and period, so in case they differ
+	//arm the timer as one-shot first and re-arm it with the period upon first expiration.
+	if(period.count() != 0 && period == timeout){
+		this->ArmKqueueTimer(period, false);
+		this->pendingPeriod = std::chrono::nanoseconds::zero();
+	}else{
+		this->ArmKqueueTimer(timeout, true);
+		this->pendingPeriod = period;
+	}
+#elif M_OS == M_OS_LINUX
+	//zero it_value disarms timerfd, so use minimal possible timeout instead
+	if(timeout.count() == 0){
+		timeout = std::chrono::nanoseconds(1);
+	}
+
+	itimerspec spec;
+	spec.it_value = ToTimespec(timeout);
+	spec.it_interval = ToTimespec(period);
+
+	if(timerfd_settime(this->fd, 0, &spec, 0) < 0){
+		std::stringstream ss;
+		ss << "WaitableTimer::Start(): timerfd_settime() failed, error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+void WaitableTimer::Stop()NOEXCEPT{
+	this->ClearCanReadFlag();
+
+#if M_OS == M_OS_WINDOWS
+	if(!this->isArmed){
+		return;
+	}
+	this->isArmed = false;
+
+	//CancelWaitableTimer() does not change the signaled state of the timer,
+	//so re-arm it first, this will reset the state to non-signaled.
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -LONGLONG(10000000); //1 second
+	SetWaitableTimer(this->handle, &dueTime, 0, NULL, NULL, FALSE);
+	CancelWaitableTimer(this->handle);
+#elif M_OS == M_OS_MACOSX
+	this->pendingPeriod = std::chrono::nanoseconds::zero();
+
+	//deleting the timer also removes its pending events from the kqueue
+	struct kevent e;
+	EV_SET(&e, 0, EVFILT_TIMER, EV_DELETE, 0, 0, 0);
+	kevent(this->queue, &e, 1, 0, 0, 0); //ignore error, the timer may be not added
+#elif M_OS == M_OS_LINUX
+	itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+
+	//disarming the timer also resets the expirations counter
+	if(timerfd_settime(this->fd, 0, &spec, 0) < 0){
+		ASSERT(false)
+	}
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+std::uint64_t WaitableTimer::NumExpirations(){
+	this->ClearCanReadFlag();
+
+#if M_OS == M_OS_WINDOWS
+	if(!this->isArmed){
+		return 0;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	if(now < this->nextExpiration){
+		//re-arm to reset signaled state in case the timer has fired a bit earlier than steady clock says
+		this->Arm(this->nextExpiration);
+		return 0;
+	}
+
+	if(this->period.count() == 0){
+		this->Stop();
+		return 1;
+	}
+
+	std::uint64_t ret = 1 + std::uint64_t((now - this->nextExpiration) / this->period);
+	this->nextExpiration += this->period * ret;
+	this->Arm(this->nextExpiration);
+	return ret;
+#elif M_OS == M_OS_MACOSX
+	const timespec timeout = {0, 0}; //0 to make effect of polling
+
+	struct kevent e;
+	int res = kevent(this->queue, 0, 0, &e, 1, &timeout);
+	if(res < 0){
+		std::stringstream ss;
+		ss << "WaitableTimer::NumExpirations(): kevent() failed, error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+	if(res == 0){
+		return 0;
+	}
+	ASSERT(e.filter == EVFILT_TIMER)
+
+	if(this->pendingPeriod.count() != 0){
+		//first expiration of the timer with period different from first timeout
+		this->ArmKqueueTimer(this->pendingPeriod, false);
+		this->pendingPeriod = std::chrono::nanoseconds::zero();
+	}
+
+	return std::uint64_t(e.data);
+#elif M_OS == M_OS_LINUX
+	std::uint64_t ret;
+	for(;;){
+		if(read(this->fd, &ret, sizeof(ret)) == sizeof(ret)){
+			return ret;
+		}
+		if(errno == EINTR){
+			continue;
+		}
+		if(errno == EAGAIN){
+			return 0;
+		}
+		std::stringstream ss;
+		ss << "WaitableTimer::NumExpirations(): read() failed, error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+#if M_OS == M_OS_WINDOWS
+//override
+HANDLE WaitableTimer::GetHandle(){
+	return this->handle;
+}
+
+
+
+//override
+void WaitableTimer::SetWaitingEvents(std::uint32_t flagsToWaitFor){
+	//It is only possible to wait for timer expiration, i.e. for READ.
+	if(flagsToWaitFor != 0 && flagsToWaitFor != ting::Waitable::READ){
+		ASSERT_INFO(false, "flagsToWaitFor = " << flagsToWaitFor)
+		throw ting::Exc("WaitableTimer::SetWaitingEvents(): flagsToWaitFor should be ting::Waitable::READ or 0, other values are not allowed");
+	}
+
+	this->flagsMask = flagsToWaitFor;
+}
+
+
+
+//returns true if signaled
+//override
+bool WaitableTimer::CheckSignaled(){
+	if(WaitForSingleObject(this->handle, 0) == WAIT_OBJECT_0){
+		this->SetCanReadFlag();
+	}
+
+	return (this->readinessFlags & this->flagsMask) != 0;
+}
+
+#elif M_OS == M_OS_MACOSX
+//override
+int WaitableTimer::GetHandle(){
+	//kqueue descriptor becomes readable when there are pending timer events
+	return this->queue;
+}
+
+#elif M_OS == M_OS_LINUX
+//override
+int WaitableTimer::GetHandle(){
+	return this->fd;
+}
+
+#else
+#	error "Unsupported OS"
+#endif
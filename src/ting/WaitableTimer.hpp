@@ -0,0 +1,159 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @file WaitableTimer.hpp
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Timer which can be waited for in a WaitSet.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "Exc.hpp"
+#include "WaitSet.hpp"
+
+
+#if M_OS == M_OS_WINDOWS
+#	include "windows.hpp"
+#endif
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Timer which implements Waitable interface.
+ * Unlike ting::timer::Timer, this timer does not call any callbacks from a separate thread.
+ * Instead, it becomes readable when it expires, so it can be added to a WaitSet
+ * and handled from the thread which waits on that WaitSet, without any thread switching.
+ * On Linux it is implemented using timerfd, on Mac OS X using kqueue timer,
+ * on Windows using waitable timer object.
+ * The timer shall only be waited for READ. If you are trying to wait for WRITE the behavior will be
+ * undefined.
+ */
+class WaitableTimer : public ting::Waitable{
+#if M_OS == M_OS_WINDOWS
+	HANDLE handle;
+
+	std::uint32_t flagsMask;//flags to wait for
+
+	//Windows waitable timer does not count expirations, so timer is always
+	//armed as one-shot and periodic expirations are counted manually.
+	std::chrono::steady_clock::time_point nextExpiration;
+	std::chrono::nanoseconds period;
+	bool isArmed = false;
+
+	void Arm(std::chrono::steady_clock::time_point expiration);
+#elif M_OS == M_OS_MACOSX
+	int queue; //kqueue, becomes readable when timer expires
+
+	//period to re-arm the timer with after first expiration, zero if no re-arming needed
+	std::chrono::nanoseconds pendingPeriod = std::chrono::nanoseconds::zero();
+
+	void ArmKqueueTimer(std::chrono::nanoseconds timeout, bool oneShot);
+#elif M_OS == M_OS_LINUX
+	int fd; //timerfd
+#else
+#	error "Unsupported OS"
+#endif
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Creates a stopped timer.
+	 * @throw ting::Exc - if system timer object could not be created.
+	 */
+	WaitableTimer();
+
+	WaitableTimer(const WaitableTimer&) = delete;
+	WaitableTimer& operator=(const WaitableTimer&) = delete;
+
+	~WaitableTimer()NOEXCEPT;
+
+
+
+	/**
+	 * @brief Start timer.
+	 * Arms the timer. If the timer was already running it will be re-armed with new timeout values
+	 * and all the expirations which were not yet retrieved with NumExpirations() are discarded.
+	 * @param timeout - timeout after which the timer expires for the first time. Zero timeout
+	 *                  is treated as the minimal possible timeout, i.e. timer will expire almost immediately.
+	 * @param period - if not zero, then after first expiration the timer will be expiring
+	 *                 periodically with this interval. If zero then the timer is one-shot.
+	 * @throw ting::Exc - in case of any error.
+	 */
+	void Start(std::chrono::nanoseconds timeout, std::chrono::nanoseconds period = std::chrono::nanoseconds::zero());
+
+
+
+	/**
+	 * @brief Stop timer.
+	 * Disarms the timer and discards all pending expirations.
+	 * It is ok to stop the timer which is not running.
+	 */
+	void Stop()NOEXCEPT;
+
+
+
+	/**
+	 * @brief Get number of expirations.
+	 * Returns number of times the timer has expired since it was started or since
+	 * last call to this method. Clears the "can read" state of the timer, so the
+	 * method is supposed to be called every time the timer has triggered in a WaitSet.
+	 * Does not block.
+	 * @return number of expirations, 0 if timer has not expired yet.
+	 */
+	std::uint64_t NumExpirations();
+
+
+
+private:
+#if M_OS == M_OS_WINDOWS
+	HANDLE GetHandle()override;
+
+	void SetWaitingEvents(std::uint32_t flagsToWaitFor)override;
+
+	//returns true if signaled
+	bool CheckSignaled()override;
+
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+	int GetHandle()override;
+
+#else
+#	error "Unsupported OS"
+#endif
+};//~class WaitableTimer
+
+
+
+}//~namespace
@@ -165,6 +165,22 @@ size_t FSFile::SeekBackwardInternal(size_t numBytesToSeek)const{
 
 
 
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+int FSFile::GetDescriptor()const{
+	if(!this->IsOpened()){
+		throw File::IllegalStateExc("GetDescriptor(): file is not opened");
+	}
+
+	ASSERT(this->handle)
+	if(fflush(this->handle) != 0){
+		throw File::Exc("fflush() failed");
+	}
+	return fileno(this->handle);
+}
+#endif
+
+
+
 //override
 void FSFile::RewindInternal()const{
 	if(!this->IsOpened()){
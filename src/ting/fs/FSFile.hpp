@@ -102,6 +102,21 @@ public:
 
 
 
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	/**
+	 * @brief Get file descriptor of the opened file.
+	 * Allows doing operations on the file which are not covered by File interface,
+	 * e.g. sending file contents to a socket with sendfile().
+	 * Buffered data written to the file is flushed before returning the descriptor,
+	 * so that operations done on the descriptor see all the data written so far.
+	 * @return OS file descriptor.
+	 * @throw IllegalStateExc - if file is not opened.
+	 */
+	int GetDescriptor()const;
+#endif
+
+
+
 	virtual std::vector<std::string> ListDirContents(size_t maxEntries = 0)const override;
 	
 	virtual std::unique_ptr<File> Spawn()override;
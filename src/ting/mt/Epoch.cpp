@@ -0,0 +1,180 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "Epoch.hpp"
+
+
+
+using namespace ting::mt;
+
+
+
+EpochDomain::~EpochDomain()NOEXCEPT{
+	ASSERT_INFO(this->participants == nullptr, "EpochDomain is destroyed while there are participants registered")
+
+	//nobody can access the objects anymore
+	for(auto& o : this->orphans){
+		o.retired.Free();
+	}
+}
+
+
+
+bool EpochDomain::TryAdvance()NOEXCEPT{
+	std::vector<Retired> toFree;
+
+	{
+		std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+
+		std::uint64_t epoch = this->globalEpoch.load(std::memory_order_seq_cst);
+
+		for(Participant* p = this->participants; p; p = p->next){
+			std::uint64_t e = p->localEpoch.load(std::memory_order_seq_cst);
+			if(e != 0 && (e >> 1) != epoch){
+				//participant is in critical section which has started in previous epoch
+				return false;
+			}
+		}
+
+		++epoch;
+		this->globalEpoch.store(epoch, std::memory_order_seq_cst);
+
+		//free orphans retired two or more epochs ago
+		for(size_t i = 0; i != this->orphans.size();){
+			if(this->orphans[i].epoch + 2 <= epoch){
+				toFree.push_back(this->orphans[i].retired);
+				this->orphans[i] = this->orphans.back();
+				this->orphans.pop_back();
+			}else{
+				++i;
+			}
+		}
+	}
+
+	//call deleters without the mutex locked
+	for(auto& r : toFree){
+		r.Free();
+	}
+
+	return true;
+}
+
+
+
+EpochDomain::Participant::Participant(EpochDomain& domain) :
+		domain(domain),
+		localEpoch(0),
+		prev(nullptr)
+{
+	this->bucketEpoch.fill(0);
+
+	std::lock_guard<decltype(this->domain.mutex)> mutexGuard(this->domain.mutex);
+	this->next = this->domain.participants;
+	if(this->next){
+		this->next->prev = this;
+	}
+	this->domain.participants = this;
+}
+
+
+
+EpochDomain::Participant::~Participant()NOEXCEPT{
+	ASSERT_INFO(this->nesting == 0, "Participant is destroyed while in critical section")
+
+	{
+		std::lock_guard<decltype(this->domain.mutex)> mutexGuard(this->domain.mutex);
+		if(this->prev){
+			this->prev->next = this->next;
+		}else{
+			this->domain.participants = this->next;
+		}
+		if(this->next){
+			this->next->prev = this->prev;
+		}
+	}
+
+	this->Collect();
+
+	if(this->NumRetired() == 0){
+		return;
+	}
+
+	std::lock_guard<decltype(this->domain.mutex)> mutexGuard(this->domain.mutex);
+	for(unsigned i = 0; i != this->retired.size(); ++i){
+		for(auto& r : this->retired[i]){
+			Orphan o = {this->bucketEpoch[i], r};
+			this->domain.orphans.push_back(o);
+		}
+	}
+}
+
+
+
+void EpochDomain::Participant::FreeBucket(unsigned index)NOEXCEPT{
+	//move the bucket out, since deleters may retire other objects
+	std::vector<Retired> bucket;
+	bucket.swap(this->retired[index]);
+	for(auto& r : bucket){
+		r.Free();
+	}
+}
+
+
+
+void EpochDomain::Participant::DoRetire(const Retired& r){
+	//read epoch after the object has been removed from the data structure
+	std::uint64_t epoch = this->domain.globalEpoch.load(std::memory_order_seq_cst);
+
+	unsigned index = unsigned(epoch % this->retired.size());
+	if(this->bucketEpoch[index] != epoch){
+		//bucket contains objects retired at least 3 epochs ago, they are safe to free
+		ASSERT(this->bucketEpoch[index] + 2 <= epoch || this->retired[index].size() == 0)
+		this->FreeBucket(index);
+		this->bucketEpoch[index] = epoch;
+	}
+	this->retired[index].push_back(r);
+
+	if(++this->numRetiredSinceAdvance >= DAdvanceThreshold && !this->IsInCriticalSection()){
+		this->Collect();
+	}
+}
+
+
+
+void EpochDomain::Participant::Collect()NOEXCEPT{
+	ASSERT(!this->IsInCriticalSection())
+
+	this->numRetiredSinceAdvance = 0;
+
+	this->domain.TryAdvance();
+
+	std::uint64_t epoch = this->domain.globalEpoch.load(std::memory_order_seq_cst);
+	for(unsigned i = 0; i != this->retired.size(); ++i){
+		if(this->retired[i].size() != 0 && this->bucketEpoch[i] + 2 <= epoch){
+			this->FreeBucket(i);
+		}
+	}
+}
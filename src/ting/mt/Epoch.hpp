@@ -0,0 +1,305 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+#include "../PoolStored.hpp"
+
+
+
+namespace ting{
+namespace mt{
+
+
+
+/**
+ * @brief Epoch-based memory reclamation domain.
+ * Allows safe memory reclamation for data structures which are read without locking.
+ * Threads accessing the data structure register in the domain by creating a Participant object.
+ * Before accessing the shared data structure a thread enters the critical section
+ * (see Participant::Guard), and leaves it when it does not hold references to the data
+ * structure nodes anymore. Entering and leaving the critical section only writes the
+ * thread's own epoch record, reading the data structure itself needs no atomic read-modify-write
+ * operations or locks.
+ * When a node is removed from the data structure, it is not freed immediately,
+ * instead it is retired (see Participant::Retire()). Retired node is freed only when
+ * all the threads which could hold a reference to it have left their critical sections.
+ * This is tracked with global epoch counter which is advanced only when all the threads
+ * in critical section have observed its current value. Object retired in epoch E is
+ * freed once the global epoch reaches E + 2.
+ */
+class EpochDomain{
+public:
+	class Participant;
+
+private:
+	struct Retired{
+		void* p;
+		void (*deleter)(void* p, void* context);
+		void* context;
+
+		void Free()NOEXCEPT{
+			this->deleter(this->p, this->context);
+		}
+	};
+
+	struct Orphan{
+		std::uint64_t epoch;
+		Retired retired;
+	};
+
+	std::atomic<std::uint64_t> globalEpoch;
+
+	//protects list of participants and orphans
+	std::mutex mutex;
+
+	Participant* participants = nullptr;
+
+	//objects retired by participants which have been destroyed before the objects could be freed
+	std::vector<Orphan> orphans;
+
+public:
+	EpochDomain() :
+			globalEpoch(1)
+	{}
+
+	EpochDomain(const EpochDomain&) = delete;
+	EpochDomain& operator=(const EpochDomain&) = delete;
+
+	/**
+	 * @brief Destructor.
+	 * All participants should be destroyed before the domain.
+	 * All objects which are still retired are freed.
+	 */
+	~EpochDomain()NOEXCEPT;
+
+	/**
+	 * @brief Get global epoch.
+	 * @return current value of the global epoch.
+	 */
+	std::uint64_t Epoch()const NOEXCEPT{
+		return this->globalEpoch.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Try to advance global epoch.
+	 * Advances global epoch if all the threads in critical section have observed its current value.
+	 * Also frees orphaned objects which became safe to free.
+	 * It is called automatically from Participant::Retire(), so normally there is no need to call it.
+	 * @return true if epoch was advanced.
+	 */
+	bool TryAdvance()NOEXCEPT;
+
+
+
+	/**
+	 * @brief Thread registration in epoch domain.
+	 * Each thread accessing the data structures protected by the domain should have its own
+	 * participant object. Participant object shall only be used by the thread which has created it.
+	 */
+	class Participant{
+		friend class EpochDomain;
+
+		EpochDomain& domain;
+
+		//epoch observed when entering the critical section shifted left by 1 with lowest bit set, 0 if not in critical section
+		std::atomic<std::uint64_t> localEpoch;
+
+		unsigned nesting = 0;
+
+		//list of participants in the domain
+		Participant* next;
+		Participant* prev;
+
+		//retired objects, bucket index is epoch % 3
+		std::array<std::vector<Retired>, 3> retired;
+		std::array<std::uint64_t, 3> bucketEpoch;
+
+		unsigned numRetiredSinceAdvance = 0;
+
+		static const unsigned DAdvanceThreshold = 64;
+
+		void FreeBucket(unsigned index)NOEXCEPT;
+
+		void DoRetire(const Retired& r);
+
+		template <class T> static void Deleter(void* p, void* context){
+			delete reinterpret_cast<T*>(p);
+		}
+
+		template <class T, class T_Pool> static void PoolDeleter(void* p, void* context){
+			reinterpret_cast<T*>(p)->~T();
+			reinterpret_cast<T_Pool*>(context)->Free_ts(p);
+		}
+
+	public:
+		/**
+		 * @brief Constructor.
+		 * Registers the participant in the domain.
+		 * @param domain - epoch domain to register in.
+		 */
+		Participant(EpochDomain& domain);
+
+		Participant(const Participant&) = delete;
+		Participant& operator=(const Participant&) = delete;
+
+		/**
+		 * @brief Destructor.
+		 * Unregisters the participant from the domain. Objects retired by the participant
+		 * which cannot be freed yet are passed over to the domain.
+		 */
+		~Participant()NOEXCEPT;
+
+		/**
+		 * @brief Enter critical section.
+		 * After entering the critical section, nodes of the shared data structure can be accessed
+		 * and they will not be freed until the critical section is left.
+		 * Critical sections can be nested.
+		 */
+		void Enter()NOEXCEPT{
+			if(this->nesting++ != 0){
+				return;
+			}
+			this->localEpoch.store((this->domain.globalEpoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_relaxed);
+
+			//make the epoch record visible before any reads of the shared data structure
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+
+		/**
+		 * @brief Leave critical section.
+		 */
+		void Leave()NOEXCEPT{
+			ASSERT(this->nesting != 0)
+			if(--this->nesting != 0){
+				return;
+			}
+			this->localEpoch.store(0, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Check if participant is in critical section.
+		 * @return true if participant is in critical section.
+		 */
+		bool IsInCriticalSection()const NOEXCEPT{
+			return this->nesting != 0;
+		}
+
+		/**
+		 * @brief Scoped critical section.
+		 */
+		class Guard{
+			Participant& participant;
+		public:
+			Guard(Participant& participant) :
+					participant(participant)
+			{
+				this->participant.Enter();
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+			~Guard()NOEXCEPT{
+				this->participant.Leave();
+			}
+		};
+
+		/**
+		 * @brief Retire object.
+		 * The object should already be removed from the shared data structure, so that
+		 * no new references to it can be obtained. The object will be freed with the deleter
+		 * once no thread can hold a reference to it.
+		 * The deleter is called from some thread calling Retire(), or from destructor
+		 * of the participant or the domain.
+		 * @param p - object to retire.
+		 * @param deleter - function to free the object.
+		 * @param context - user data passed to the deleter.
+		 */
+		void Retire(void* p, void (*deleter)(void* p, void* context), void* context = nullptr){
+			Retired r = {p, deleter, context};
+			this->DoRetire(r);
+		}
+
+		/**
+		 * @brief Retire object allocated with new.
+		 * The object will be deleted with delete operator. For objects derived from PoolStored
+		 * it means that the memory goes back to the memory pool of the class.
+		 * @param p - object to retire.
+		 */
+		template <class T> void Retire(T* p){
+			this->Retire(p, &Deleter<T>);
+		}
+
+		/**
+		 * @brief Retire object allocated from a memory pool.
+		 * The object will be destroyed and its memory will be returned to the pool.
+		 * @param p - object to retire, it should be constructed in memory allocated with pool.Alloc_ts().
+		 * @param pool - memory pool to return the memory to. The pool should outlive the participant and the domain.
+		 */
+		template <class T, size_t element_size, std::uint32_t num_elements_in_chunk> void Retire(
+				T* p,
+				MemoryPool<element_size, num_elements_in_chunk>& pool
+			)
+		{
+			static_assert(sizeof(T) <= element_size, "object does not fit into the pool element");
+			this->Retire(p, &PoolDeleter<T, MemoryPool<element_size, num_elements_in_chunk>>, &pool);
+		}
+
+		/**
+		 * @brief Try to free retired objects.
+		 * Tries to advance the global epoch and frees the objects retired by this participant
+		 * which became safe to free.
+		 * Should not be called from within critical section.
+		 */
+		void Collect()NOEXCEPT;
+
+		/**
+		 * @brief Get number of objects retired by this participant which are not freed yet.
+		 * @return number of retired objects.
+		 */
+		size_t NumRetired()const NOEXCEPT{
+			return this->retired[0].size() + this->retired[1].size() + this->retired[2].size();
+		}
+	};
+};
+
+
+
+}//~namespace
+}//~namespace
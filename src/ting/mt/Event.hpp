@@ -0,0 +1,171 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+
+
+#if M_OS == M_OS_LINUX
+#	include <atomic>
+#	include "Futex.hpp"
+
+#elif M_OS == M_OS_WINDOWS || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+#	include <mutex>
+#	include <condition_variable>
+
+#else
+#	error "Unsupported OS"
+#endif
+
+
+
+namespace ting{
+namespace mt{
+
+
+
+/**
+ * @brief Auto-reset event.
+ * Event is either set or not set. Wait() waits until the event is set and resets it,
+ * so that only one waiting thread is released by each Set(). Setting the event which
+ * is already set does nothing, i.e. several Set() calls made while nobody is waiting
+ * release only one Wait().
+ * This makes event a lightweight replacement of semaphore in cases when one thread
+ * needs to be woken up to recheck some state, like a worker thread checking its task queue.
+ * On Linux the event is implemented on top of futex, so Set() does not enter the kernel if
+ * nobody waits on the event, and Wait() spins for a short while before going to sleep.
+ */
+class Event{
+#if M_OS == M_OS_LINUX
+	//1 if event is set, 0 otherwise, it is the futex word
+	std::atomic<std::uint32_t> state;
+	std::atomic<std::uint32_t> numWaiters;
+
+	bool TryReset()NOEXCEPT{
+		std::uint32_t expected = 1;
+		return this->state.compare_exchange_strong(expected, 0);
+	}
+#elif M_OS == M_OS_WINDOWS || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool isSet;
+#else
+#	error "Unsupported OS"
+#endif
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param isSet - initial state of the event.
+	 */
+	Event(bool isSet = false) :
+#if M_OS == M_OS_LINUX
+			state(isSet ? 1 : 0),
+			numWaiters(0)
+#else
+			isSet(isSet)
+#endif
+	{}
+
+	Event(const Event&) = delete;
+	Event& operator=(const Event&) = delete;
+
+	~Event()NOEXCEPT{
+#if M_OS == M_OS_LINUX
+		ASSERT(this->numWaiters == 0)
+#endif
+	}
+
+	/**
+	 * @brief Set the event.
+	 * Releases one thread waiting on the event, or, if nobody waits, the next Wait() call.
+	 */
+	void Set()NOEXCEPT{
+#if M_OS == M_OS_LINUX
+		if(this->state.exchange(1) == 0 && this->numWaiters.load() != 0){
+			futex::Wake(this->state, 1);
+		}
+#else
+		{
+			std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+			if(this->isSet){
+				return;
+			}
+			this->isSet = true;
+		}
+		this->cond.notify_one();
+#endif
+	}
+
+	/**
+	 * @brief Wait for the event to be set.
+	 * Waits until the event is set and resets it.
+	 */
+	void Wait(){
+#if M_OS == M_OS_LINUX
+		futex::WaitAcquire(this->state, this->numWaiters, std::chrono::nanoseconds::max(), [this](){return this->TryReset();});
+#else
+		std::unique_lock<decltype(this->mutex)> mutexGuard(this->mutex);
+		this->cond.wait(mutexGuard, [this](){return this->isSet;});
+		this->isSet = false;
+#endif
+	}
+
+	/**
+	 * @brief Wait for the event to be set with timeout.
+	 * Waits until the event is set and resets it.
+	 * @param timeout - waiting timeout, it is measured using monotonic clock.
+	 *                  If zero then the method checks if the event is set and returns immediately.
+	 * @return true if the event was set.
+	 * @return false if timeout was hit.
+	 */
+	bool Wait(std::chrono::nanoseconds timeout){
+		ASSERT(timeout.count() >= 0)
+#if M_OS == M_OS_LINUX
+		return futex::WaitAcquire(this->state, this->numWaiters, timeout, [this](){return this->TryReset();});
+#else
+		std::unique_lock<decltype(this->mutex)> mutexGuard(this->mutex);
+		if(!this->cond.wait_for(mutexGuard, timeout, [this](){return this->isSet;})){
+			return false;
+		}
+		this->isSet = false;
+		return true;
+#endif
+	}
+};
+
+
+
+}//~namespace
+}//~namespace
@@ -0,0 +1,216 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+
+
+#if M_OS == M_OS_LINUX
+#	include <ctime>
+#	include <cerrno>
+#	include <unistd.h>
+#	include <sys/syscall.h>
+#	include <linux/futex.h>
+#endif
+
+
+#if M_COMPILER == M_COMPILER_MSVC && (M_CPU == M_CPU_X86 || M_CPU == M_CPU_X86_64)
+#	include <intrin.h>
+#endif
+
+
+
+namespace ting{
+namespace mt{
+
+
+
+/**
+ * @brief Hint the CPU that the thread is in a busy-wait loop.
+ * On x86 it executes the PAUSE instruction which lowers power consumption and frees
+ * resources for the sibling hyper-thread, and avoids memory order violation penalty
+ * when exiting the loop. On other CPUs it does nothing.
+ */
+inline void CpuPause()NOEXCEPT{
+#if M_CPU == M_CPU_X86 || M_CPU == M_CPU_X86_64
+#	if M_COMPILER == M_COMPILER_GCC
+	__builtin_ia32_pause();
+#	elif M_COMPILER == M_COMPILER_MSVC
+	_mm_pause();
+#	endif
+#elif M_CPU == M_CPU_ARM && M_CPU_VERSION >= 7 && M_COMPILER == M_COMPILER_GCC
+	asm volatile("yield");
+#endif
+}
+
+
+
+/**
+ * @brief Number of spins worth doing before going to sleep.
+ * Spinning makes sense only if there is another CPU which can release the resource
+ * while we are spinning, so on single CPU systems it is zero.
+ * @return number of busy-wait iterations.
+ */
+inline unsigned NumSpinsBeforeSleep()NOEXCEPT{
+	static const unsigned numSpins = std::thread::hardware_concurrency() > 1 ? 100 : 0;
+	return numSpins;
+}
+
+
+
+#if M_OS == M_OS_LINUX
+
+/**
+ * @brief Linux futex primitives.
+ * Futex word is a 32 bit integer. std::atomic<std::uint32_t> has same representation,
+ * so it can be used as futex word.
+ */
+namespace futex{
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "atomic uint32 cannot be used as futex word");
+
+/**
+ * @brief Sleep while futex word has expected value.
+ * @param word - futex word.
+ * @param expected - value of the word to sleep on.
+ * @param timeout - relative timeout measured against CLOCK_MONOTONIC, nullptr for infinite.
+ * @return false if timed out.
+ * @return true if woken up, interrupted or if the word value was not expected, i.e. caller should recheck the word.
+ */
+inline bool Wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout)NOEXCEPT{
+	if(syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0) == -1){
+		ASSERT_INFO(errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT, "errno = " << errno)
+		return errno != ETIMEDOUT;
+	}
+	return true;
+}
+
+/**
+ * @brief Wake threads sleeping on futex word.
+ * @param word - futex word.
+ * @param num - maximum number of threads to wake.
+ */
+inline void Wake(std::atomic<std::uint32_t>& word, int num)NOEXCEPT{
+	syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, num, nullptr, nullptr, 0);
+}
+
+inline std::uint64_t MonotonicNanoseconds()NOEXCEPT{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return std::uint64_t(ts.tv_sec) * 1000000000 + std::uint64_t(ts.tv_nsec);
+}
+
+/**
+ * @brief Wait until resource represented by futex word is acquired.
+ * The word value 0 means that the resource is not available. The function first tries
+ * to acquire the resource, then spins for a while and then sleeps on the futex word until
+ * the resource is acquired or until timeout is hit.
+ * Party which makes the resource available should change the word to non-zero value and
+ * call Wake() if numWaiters is not 0.
+ * @param word - futex word.
+ * @param numWaiters - counter of threads sleeping on the word.
+ * @param timeout - waiting timeout, std::chrono::nanoseconds::max() for infinite.
+ * @param tryAcquire - functor trying to acquire the resource, returns true if acquired.
+ * @return true if resource was acquired.
+ * @return false if timeout was hit.
+ */
+template <class T_TryAcquire> bool WaitAcquire(
+		std::atomic<std::uint32_t>& word,
+		std::atomic<std::uint32_t>& numWaiters,
+		std::chrono::nanoseconds timeout,
+		T_TryAcquire tryAcquire
+	)
+{
+	ASSERT(timeout.count() >= 0)
+
+	//uncontended fast path
+	if(tryAcquire()){
+		return true;
+	}
+	if(timeout.count() == 0){
+		return false;
+	}
+
+	//resource is likely to become available soon, try spinning before going to sleep
+	for(unsigned i = NumSpinsBeforeSleep(); i != 0; --i){
+		CpuPause();
+		if(word.load(std::memory_order_relaxed) != 0 && tryAcquire()){
+			return true;
+		}
+	}
+
+	bool isInfinite = timeout == std::chrono::nanoseconds::max();
+	std::uint64_t deadline = isInfinite ? 0 : MonotonicNanoseconds() + std::uint64_t(timeout.count());
+
+	++numWaiters;
+
+	bool ret;
+	for(;;){
+		if(tryAcquire()){
+			ret = true;
+			break;
+		}
+
+		if(isInfinite){
+			Wait(word, 0, nullptr);
+			continue;
+		}
+
+		std::uint64_t now = MonotonicNanoseconds();
+		if(now >= deadline){
+			ret = false;
+			break;
+		}
+
+		timespec rel;
+		rel.tv_sec = time_t((deadline - now) / 1000000000);
+		rel.tv_nsec = long((deadline - now) % 1000000000);
+		Wait(word, 0, &rel);
+	}
+
+	--numWaiters;
+	return ret;
+}
+
+}//~namespace
+
+#endif
+
+
+
+}//~namespace
+}//~namespace
@@ -0,0 +1,200 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+#include "Futex.hpp"
+
+
+
+namespace ting{
+namespace mt{
+
+/**
+ * @brief Reader-writer spin lock.
+ * Lock which can be held either by one writer or by several readers at the same time.
+ * It is supposed to be used for read-mostly data which is accessed for very short periods of time.
+ * The lock is writer-preferring, i.e. when a writer is waiting for the lock, new readers
+ * are not let in, so that writers do not starve under constant read load.
+ * Waiting threads spin with exponential backoff and start yielding after a while.
+ * Exclusive (writer) locking is done with lock()/unlock(), so the class can be used with
+ * std::lock_guard same way as SpinLock. Shared (reader) locking is done with
+ * lock_shared()/unlock_shared(), use RWSpinLock::SharedGuard for scoped shared locking.
+ */
+class RWSpinLock{
+	//bit 31 - writer holds the lock, bit 30 - writer is waiting, lower bits - number of readers holding the lock
+	std::atomic<std::uint32_t> state;
+
+	static const std::uint32_t DWriter = std::uint32_t(1) << 31;
+	static const std::uint32_t DWriterWaiting = std::uint32_t(1) << 30;
+	static const std::uint32_t DReadersMask = DWriterWaiting - 1;
+
+	static const unsigned DMaxBackoff = 64;
+
+	class Backoff{
+		unsigned backoff = 1;
+	public:
+		void Wait()NOEXCEPT{
+			if(this->backoff > DMaxBackoff || NumSpinsBeforeSleep() == 0){
+				std::this_thread::yield();
+				return;
+			}
+			for(unsigned i = 0; i != this->backoff; ++i){
+				CpuPause();
+			}
+			this->backoff *= 2;
+		}
+	};
+
+public:
+	RWSpinLock() :
+			state(0)
+	{}
+
+	RWSpinLock(const RWSpinLock&) = delete;
+	RWSpinLock& operator=(const RWSpinLock&) = delete;
+
+	~RWSpinLock()NOEXCEPT{
+		ASSERT((this->state & (DWriter | DReadersMask)) == 0)
+	}
+
+	/**
+	 * @brief Try to acquire exclusive lock.
+	 * @return true if lock was acquired.
+	 */
+	bool try_lock()NOEXCEPT{
+		std::uint32_t s = this->state.load(std::memory_order_relaxed);
+		if((s & (DWriter | DReadersMask)) != 0){
+			return false;
+		}
+		//acquiring the lock clears the waiting flag, other waiting writers will set it again
+		return this->state.compare_exchange_strong(s, DWriter, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Acquire exclusive lock.
+	 * Waits until all readers and writer release the lock.
+	 */
+	void lock()NOEXCEPT{
+		Backoff backoff;
+		for(;;){
+			std::uint32_t s = this->state.load(std::memory_order_relaxed);
+			if((s & (DWriter | DReadersMask)) == 0){
+				if(this->state.compare_exchange_weak(s, DWriter, std::memory_order_acquire, std::memory_order_relaxed)){
+					return;
+				}
+				continue;
+			}
+			if((s & DWriterWaiting) == 0){
+				//stop new readers from entering
+				this->state.compare_exchange_weak(s, s | DWriterWaiting, std::memory_order_relaxed, std::memory_order_relaxed);
+			}
+			backoff.Wait();
+		}
+	}
+
+	/**
+	 * @brief Release exclusive lock.
+	 */
+	void unlock()NOEXCEPT{
+		ASSERT(this->state & DWriter)
+		this->state.fetch_sub(DWriter, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Try to acquire shared lock.
+	 * @return true if lock was acquired.
+	 */
+	bool try_lock_shared()NOEXCEPT{
+		std::uint32_t s = this->state.load(std::memory_order_relaxed);
+		if((s & (DWriter | DWriterWaiting)) != 0){
+			return false;
+		}
+		ASSERT((s & DReadersMask) != DReadersMask)
+		return this->state.compare_exchange_strong(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Acquire shared lock.
+	 * Waits while the lock is held by a writer or while a writer is waiting for the lock.
+	 */
+	void lock_shared()NOEXCEPT{
+		Backoff backoff;
+		for(;;){
+			std::uint32_t s = this->state.load(std::memory_order_relaxed);
+			if((s & (DWriter | DWriterWaiting)) == 0){
+				ASSERT((s & DReadersMask) != DReadersMask)
+				if(this->state.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed)){
+					return;
+				}
+				continue;
+			}
+			backoff.Wait();
+		}
+	}
+
+	/**
+	 * @brief Release shared lock.
+	 */
+	void unlock_shared()NOEXCEPT{
+		ASSERT((this->state & DReadersMask) != 0)
+		this->state.fetch_sub(1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Scoped shared lock.
+	 * Acquires shared lock in constructor and releases it in destructor.
+	 */
+	class SharedGuard{
+		RWSpinLock& lock;
+	public:
+		SharedGuard(RWSpinLock& lock) :
+				lock(lock)
+		{
+			this->lock.lock_shared();
+		}
+
+		SharedGuard(const SharedGuard&) = delete;
+		SharedGuard& operator=(const SharedGuard&) = delete;
+
+		~SharedGuard()NOEXCEPT{
+			this->lock.unlock_shared();
+		}
+	};
+};
+
+}
+}
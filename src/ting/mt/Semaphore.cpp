@@ -24,7 +24,10 @@ Semaphore::Semaphore(unsigned initialValue){
 		pthread_mutex_destroy(&this->m);
 	}
 #elif M_OS == M_OS_LINUX
-	if(sem_init(&this->s, 0, initialValue) < 0)
+	//futex based semaphore needs no system resources, so it cannot fail
+	this->v = initialValue;
+	this->numWaiters = 0;
+	return;
 #else
 #	error "unknown OS"
 #endif
@@ -45,7 +48,7 @@ Semaphore::~Semaphore()NOEXCEPT{
 	pthread_cond_destroy(&this->c);
 	pthread_mutex_destroy(&this->m);
 #elif M_OS == M_OS_LINUX
-	sem_destroy(&this->s);
+	ASSERT(this->numWaiters == 0)
 #else
 #	error "unknown OS"
 #endif
@@ -104,37 +107,62 @@ bool Semaphore::Wait(std::uint32_t timeoutMillis){
 		ASSERT(false)
 	}
 #elif M_OS == M_OS_LINUX
-	//if timeoutMillis is 0 then use sem_trywait() to avoid unnecessary time calculation for sem_timedwait()
-	if(timeoutMillis == 0){
-		if(sem_trywait(&this->s) == -1){
-			if(errno == EAGAIN){
-				return false;
-			}else{
-				throw ting::Exc("Semaphore::Wait(u32): error: sem_trywait() failed");
-			}
-		}
-	}else{
-		timespec ts;
+	if(!this->WaitFutex(std::chrono::milliseconds(timeoutMillis))){
+		return false;
+	}
+#else
+#	error "unknown OS"
+#endif
+	return true;
+}
 
-		if(clock_gettime(CLOCK_REALTIME, &ts) == -1){
-			throw ting::Exc("Semaphore::Wait(): clock_gettime() returned error");
-		}
 
-		ts.tv_sec += timeoutMillis / 1000;
-		ts.tv_nsec += (timeoutMillis % 1000) * 1000 * 1000;
-		ts.tv_sec += ts.tv_nsec / (1000 * 1000 * 1000);
-		ts.tv_nsec = ts.tv_nsec % (1000 * 1000 * 1000);
 
-		if(sem_timedwait(&this->s, &ts) == -1){
-			if(errno == ETIMEDOUT){
+bool Semaphore::Wait(std::chrono::nanoseconds timeout){
+	ASSERT(timeout.count() >= 0)
+#if M_OS == M_OS_WINDOWS
+	//round up to whole milliseconds, so that the wait is not shorter than requested
+	std::uint64_t millis = (std::uint64_t(timeout.count()) + 999999) / 1000000;
+	return this->Wait(std::uint32_t(millis < INFINITE ? millis : INFINITE - 1));
+#elif M_OS == M_OS_MACOSX
+	struct timeval tv;
+	
+	gettimeofday(&tv, NULL);
+	
+	struct timespec ts;
+	
+	ts.tv_sec = tv.tv_sec + time_t(timeout.count() / 1000000000);
+	ts.tv_nsec = long(tv.tv_usec) * 1000 + long(timeout.count() % 1000000000);
+	ts.tv_sec += ts.tv_nsec / (1000 * 1000 * 1000);
+	ts.tv_nsec = ts.tv_nsec % (1000 * 1000 * 1000);
+	
+	if(pthread_mutex_lock(&this->m) != 0){
+		throw ting::Exc("Semaphore::Wait(): failed to lock the mutex");
+	}
+
+	if(this->v == 0){
+		if(int err = pthread_cond_timedwait(&this->c, &this->m, &ts)){
+			if(pthread_mutex_unlock(&this->m) != 0){
+				ASSERT(false)
+			}
+			if(err == ETIMEDOUT){
 				return false;
 			}else{
-				throw ting::Exc("Semaphore::Wait(u32): error: sem_timedwait() failed");
+				TRACE(<< "Semaphore::Wait(): pthread_cond_wait() failed, error code = " << err << std::endl)
+				throw ting::Exc("Semaphore::Wait(): pthread_cond_wait() failed");
 			}
 		}
 	}
+
+	--this->v;
+
+	if(pthread_mutex_unlock(&this->m) != 0){
+		ASSERT(false)
+	}
+	return true;
+#elif M_OS == M_OS_LINUX
+	return this->WaitFutex(timeout);
 #else
 #	error "unknown OS"
 #endif
-	return true;
 }
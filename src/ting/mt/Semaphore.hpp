@@ -31,6 +31,8 @@ THE SOFTWARE. */
 
 #pragma once
 
+#include <chrono>
+
 #include "../config.hpp"
 #include "../debug.hpp"
 #include "../types.hpp"
@@ -45,7 +47,11 @@ THE SOFTWARE. */
 #	include <e32std.h>
 #	include <hal.h>
 
-#elif M_OS == M_OS_LINUX || M_OS == M_OS_UNIX
+#elif M_OS == M_OS_LINUX
+#	include <atomic>
+#	include "Futex.hpp"
+
+#elif M_OS == M_OS_UNIX
 #	include <semaphore.h>
 #	include <errno.h>
 
@@ -72,6 +78,9 @@ namespace mt{
  * decrement it. If there are several threads waiting for semaphore decrement and
  * some other thread increments it then only one of the hanging threads will be
  * resumed, other threads will remain waiting for next increment.
+ * On Linux the semaphore is implemented on top of futex, so uncontended Wait() and Signal()
+ * do not enter the kernel. Before going to sleep Wait() spins for a short while, and timeouts are
+ * measured using monotonic clock, so they are not affected by system time changes.
  */
 class Semaphore{
 	//system dependent handle
@@ -85,7 +94,23 @@ class Semaphore{
 	pthread_cond_t c;
 	unsigned v; //current semaphore value
 #elif M_OS == M_OS_LINUX
-	sem_t s;
+	//futex based semaphore, value is the futex word
+	std::atomic<std::uint32_t> v;
+	std::atomic<std::uint32_t> numWaiters;
+
+	bool TryDecrement()NOEXCEPT{
+		std::uint32_t c = this->v.load();
+		while(c != 0){
+			if(this->v.compare_exchange_weak(c, c - 1)){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool WaitFutex(std::chrono::nanoseconds timeout){
+		return futex::WaitAcquire(this->v, this->numWaiters, timeout, [this](){return this->TryDecrement();});
+	}
 #else
 #	error "unknown OS"
 #endif
@@ -145,13 +170,7 @@ public:
 			ASSERT(false)
 		}
 #elif M_OS == M_OS_LINUX
-		int retVal;
-		do{
-			retVal = sem_wait(&this->s);
-		}while(retVal == -1 && errno == EINTR);
-		if(retVal < 0){
-			throw ting::Exc("Semaphore::Wait(): wait failed");
-		}
+		this->WaitFutex(std::chrono::nanoseconds::max());
 #else
 #	error "unknown OS"
 #endif
@@ -174,6 +193,19 @@ public:
 
 
 
+	/**
+	 * @brief Wait on semaphore with high resolution timeout.
+	 * Same as Wait(std::uint32_t), but timeout can be specified with better than millisecond precision.
+	 * Actual precision depends on the system, on Windows the timeout is rounded up to whole milliseconds.
+	 * @param timeout - waiting timeout. If zero then this method will try to decrement
+	 *                  the semaphore value and exit immediately.
+	 * @return returns true if the semaphore value was decremented.
+	 * @return returns false if the timeout was hit.
+	 */
+	bool Wait(std::chrono::nanoseconds timeout);
+
+
+
 	/**
 	 * @brief Signal the semaphore.
 	 * Increments the semaphore value.
@@ -214,9 +246,12 @@ public:
 			ASSERT(false)
 		}
 #elif M_OS == M_OS_LINUX
-		if(sem_post(&this->s) < 0){
+		if(this->v.fetch_add(1) == std::uint32_t(-1)){
 			ASSERT(false)
 		}
+		if(this->numWaiters.load() != 0){
+			futex::Wake(this->v, 1);
+		}
 #else
 #	error "unknown OS"
 #endif
@@ -0,0 +1,179 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <mutex>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+#include "SpinLock.hpp"
+
+
+
+namespace ting{
+namespace mt{
+
+/**
+ * @brief Sequence lock protecting a small value.
+ * Readers never block writers and do not modify any shared memory, so reading scales
+ * perfectly across CPUs. Instead, a reader retries reading if the value was modified
+ * while it was being read. Writers are serialized with a spin lock.
+ * This makes the sequence lock suitable for small, frequently read and rarely modified
+ * values, like configuration snapshots or statistics.
+ * The value is stored as an array of atomic words, so concurrent reading and writing
+ * is not a data race.
+ * Writing is done with Write() or, for read-modify-write, by holding the lock with
+ * lock()/unlock() (e.g. using std::lock_guard) and calling Load()/Store().
+ * @param T - type of the value. Should be trivially copyable.
+ */
+template <class T> class SeqLock{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock value type should be trivially copyable");
+
+	typedef std::uintptr_t T_Word;
+
+	static const size_t DNumWords = (sizeof(T) + sizeof(T_Word) - 1) / sizeof(T_Word);
+
+	//even when nobody is writing, odd while write is in progress
+	std::atomic<std::uint32_t> seq;
+
+	SpinLock writeLock;
+
+	std::array<std::atomic<T_Word>, DNumWords> data;
+
+	void CopyOut(T& ret)const NOEXCEPT{
+		std::array<T_Word, DNumWords> words;
+		for(size_t i = 0; i != DNumWords; ++i){
+			words[i] = this->data[i].load(std::memory_order_relaxed);
+		}
+		memcpy(&ret, &words[0], sizeof(T));
+	}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param value - initial value.
+	 */
+	SeqLock(const T& value = T()) :
+			seq(0)
+	{
+		std::array<T_Word, DNumWords> words;
+		words.fill(0);
+		memcpy(&words[0], &value, sizeof(T));
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->data[i].store(words[i], std::memory_order_relaxed);
+		}
+	}
+
+	SeqLock(const SeqLock&) = delete;
+	SeqLock& operator=(const SeqLock&) = delete;
+
+	/**
+	 * @brief Read the value.
+	 * Does not block writers. If the value is being written, waits until the write completes.
+	 * @return consistent copy of the value.
+	 */
+	T Read()const NOEXCEPT{
+		T ret;
+		for(;;){
+			std::uint32_t s1 = this->seq.load(std::memory_order_acquire);
+			if(s1 & 1){
+				CpuPause();
+				continue;
+			}
+			this->CopyOut(ret);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(this->seq.load(std::memory_order_relaxed) == s1){
+				return ret;
+			}
+		}
+	}
+
+	/**
+	 * @brief Acquire the writer lock.
+	 * While the lock is held, readers spin waiting for it to be released.
+	 */
+	void lock()NOEXCEPT{
+		this->writeLock.lock();
+		this->seq.store(this->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	/**
+	 * @brief Release the writer lock.
+	 */
+	void unlock()NOEXCEPT{
+		ASSERT(this->seq & 1)
+		this->seq.store(this->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		this->writeLock.unlock();
+	}
+
+	/**
+	 * @brief Get the value while holding the writer lock.
+	 * @return the value.
+	 */
+	T Load()const NOEXCEPT{
+		ASSERT(this->seq & 1)
+		T ret;
+		this->CopyOut(ret);
+		return ret;
+	}
+
+	/**
+	 * @brief Set the value while holding the writer lock.
+	 * @param value - new value.
+	 */
+	void Store(const T& value)NOEXCEPT{
+		ASSERT(this->seq & 1)
+		std::array<T_Word, DNumWords> words;
+		words.fill(0);
+		memcpy(&words[0], &value, sizeof(T));
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->data[i].store(words[i], std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Write the value.
+	 * @param value - new value.
+	 */
+	void Write(const T& value)NOEXCEPT{
+		std::lock_guard<SeqLock> guard(*this);
+		this->Store(value);
+	}
+};
+
+}
+}
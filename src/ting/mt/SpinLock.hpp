@@ -32,6 +32,10 @@ THE SOFTWARE. */
 
 #include <atomic>
 #include <thread>
+#include <cstdint>
+
+#include "../config.hpp"
+#include "Futex.hpp"
 
 #if M_OS == M_OS_WINDOWS && M_COMPILER == M_COMPILER_GCC
 #	include "../windows.hpp"
@@ -41,40 +45,57 @@ THE SOFTWARE. */
 namespace ting{
 namespace mt{
 
+/**
+ * @brief Spin lock.
+ * Lock which is supposed to be held for very short periods of time.
+ * Lock acquisition is done in the following stages:
+ * - uncontended fast path, one atomic operation;
+ * - spinning with exponential backoff, during which the lock state is only read
+ *   (test-and-test-and-set), so waiting threads do not bounce the cache line between CPUs.
+ *   PAUSE instruction is used between reads;
+ * - if the lock was not acquired after spinning, then on Linux the thread is parked on futex
+ *   until the lock is released. On other systems the thread yields until it acquires the lock.
+ * The class satisfies the Lockable concept, so it can be used with std::lock_guard.
+ */
 class SpinLock{
-	std::atomic_flag flag
-#if M_OS == M_OS_WINDOWS
-	;
-#else
-	= ATOMIC_FLAG_INIT;//initialize to false
-#endif
-	
+	//0 - unlocked, 1 - locked, 2 - locked and there may be parked threads. It is the futex word.
+	std::atomic<std::uint32_t> state;
+
+	static const unsigned DMaxBackoff = 64;
+	static const unsigned DMaxSpins = 1024;
+
 public:
-	SpinLock(){
-		this->unlock();//NOTE: initialization of flag does not work for some reason, so set to unlocked state initially.
-	}
+	SpinLock() :
+			state(0)
+	{}
 	
 	
 	SpinLock(const SpinLock&) = delete;
 	SpinLock& operator=(const SpinLock&) = delete;
 	
-	~SpinLock()NOEXCEPT{}
+	~SpinLock()NOEXCEPT{
+		ASSERT(this->state == 0)
+	}
+
+	/**
+	 * @brief Try to lock the spinlock.
+	 * Does not wait if the lock is held by someone else.
+	 * @return true if lock was acquired.
+	 */
+	bool try_lock()NOEXCEPT{
+		std::uint32_t expected = 0;
+		return this->state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
 
 	/**
 	 * @brief Lock the spinlock.
-	 * If the lock cannot be acquired immediately it will enter a busy loop
-	 * reading the lock value until it becomes 'unlocked' and then try to lock again.
-	 * Each cycle of the busy loop it will yield the thread.
 	 * Right after acquiring the lock the memory barrier is set.
 	 */
 	void lock()NOEXCEPT{
-		while(this->flag.test_and_set(std::memory_order_acquire)){
-#if M_OS == M_OS_WINDOWS && M_COMPILER == M_COMPILER_GCC
-			SleepEx(0, FALSE);
-#else
-			std::this_thread::yield();
-#endif
+		if(this->try_lock()){
+			return;
 		}
+		this->LockContended();
 	}
 	
 
@@ -84,7 +105,104 @@ public:
 	 * Right before releasing the lock the memory barrier is set.
 	 */
 	void unlock()NOEXCEPT{
-		this->flag.clear(std::memory_order_release);
+#if M_OS == M_OS_LINUX
+		if(this->state.exchange(0, std::memory_order_release) == 2){
+			futex::Wake(this->state, 1);
+		}
+#else
+		this->state.store(0, std::memory_order_release);
+#endif
+	}
+
+protected:
+	/**
+	 * @brief Acquire the lock after the fast path has failed.
+	 */
+	void LockContended()NOEXCEPT{
+		if(NumSpinsBeforeSleep() != 0){
+			for(unsigned backoff = 1, spins = 0; spins < DMaxSpins; spins += backoff){
+				//test before test-and-set, so that spinning does not need exclusive ownership of the cache line
+				if(this->state.load(std::memory_order_relaxed) == 0 && this->try_lock()){
+					return;
+				}
+				for(unsigned i = 0; i != backoff; ++i){
+					CpuPause();
+				}
+				if(backoff < DMaxBackoff){
+					backoff *= 2;
+				}
+			}
+		}
+
+#if M_OS == M_OS_LINUX
+		//mark the lock as having parked threads, so that unlock() will wake one of them
+		std::uint32_t c = this->state.exchange(2, std::memory_order_acquire);
+		while(c != 0){
+			futex::Wait(this->state, 2, nullptr);
+			c = this->state.exchange(2, std::memory_order_acquire);
+		}
+#else
+		while(!this->try_lock()){
+#	if M_OS == M_OS_WINDOWS && M_COMPILER == M_COMPILER_GCC
+			SleepEx(0, FALSE);
+#	else
+			std::this_thread::yield();
+#	endif
+		}
+#endif
+	}
+};
+
+
+
+/**
+ * @brief Spin lock collecting statistics.
+ * Same as SpinLock, but also counts number of acquisitions and number of acquisitions
+ * which had to wait for the lock. Counting has a small cost, so use plain SpinLock
+ * unless the statistics is needed, e.g. for profiling lock contention.
+ */
+class CountingSpinLock : public SpinLock{
+	//counters are only modified while the lock is held, so no atomic increment is needed
+	std::atomic<std::uint64_t> numAcquisitions;
+	std::atomic<std::uint64_t> numContentions;
+
+public:
+	CountingSpinLock() :
+			numAcquisitions(0),
+			numContentions(0)
+	{}
+
+	bool try_lock()NOEXCEPT{
+		if(!this->SpinLock::try_lock()){
+			return false;
+		}
+		this->numAcquisitions.store(this->numAcquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void lock()NOEXCEPT{
+		bool contended = !this->SpinLock::try_lock();
+		if(contended){
+			this->LockContended();
+			this->numContentions.store(this->numContentions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		this->numAcquisitions.store(this->numAcquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Get number of times the lock was acquired.
+	 * @return number of lock acquisitions.
+	 */
+	std::uint64_t NumAcquisitions()const NOEXCEPT{
+		return this->numAcquisitions.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Get number of times the lock was contended.
+	 * @return number of lock acquisitions which could not be done immediately.
+	 */
+	std::uint64_t NumContentions()const NOEXCEPT{
+		return this->numContentions.load(std::memory_order_relaxed);
 	}
 };
 
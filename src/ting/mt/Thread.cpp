@@ -24,9 +24,19 @@ THE SOFTWARE. */
 
 #include "Thread.hpp"
 
+#include <sstream>
+#include <cstring>
+#include <memory>
+
+#include "Semaphore.hpp"
+
 
 #if M_OS == M_OS_WINDOWS
 #	include <process.h>
+#elif M_OS == M_OS_LINUX
+#	include <sched.h>
+#	include <cerrno>
+#	include <sys/syscall.h>
 #endif
 
 
@@ -43,10 +53,135 @@ std::mutex threadMutex2;
 
 
 
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+//applies options which can only be applied from within the thread itself,
+//returns error description or empty string on success.
+std::string ApplyThreadOptions(const Thread::StartOptions& options){
+	std::stringstream ss;
+
+	if(options.cpus.size() != 0){
+#	if M_OS == M_OS_LINUX
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for(auto c : options.cpus){
+			if(c >= CPU_SETSIZE){
+				ss << "CPU number " << c << " is too big";
+				return ss.str();
+			}
+			CPU_SET(c, &set);
+		}
+		if(sched_setaffinity(0, sizeof(set), &set) != 0){
+			ss << "sched_setaffinity() failed, error code = " << errno << ": " << strerror(errno);
+			return ss.str();
+		}
+#	else
+		return "CPU affinity is not supported on this OS";
+#	endif
+	}
+
+	if(options.numaNode >= 0){
+#	if M_OS == M_OS_LINUX
+		//use system call directly to avoid dependency on libnuma
+		const int DMPolBind = 2;//MPOL_BIND
+		const unsigned DBitsPerWord = sizeof(unsigned long) * 8;
+		std::vector<unsigned long> nodeMask(unsigned(options.numaNode) / DBitsPerWord + 1, 0);
+		nodeMask[unsigned(options.numaNode) / DBitsPerWord] |= 1UL << (unsigned(options.numaNode) % DBitsPerWord);
+		if(syscall(SYS_set_mempolicy, DMPolBind, &nodeMask[0], nodeMask.size() * DBitsPerWord + 1) != 0){
+			ss << "set_mempolicy() failed, error code = " << errno << ": " << strerror(errno);
+			return ss.str();
+		}
+#	else
+		return "NUMA binding is not supported on this OS";
+#	endif
+	}
+
+	if(options.schedPolicy != Thread::StartOptions::DEFAULT){
+		int policy;
+		switch(options.schedPolicy){
+			case Thread::StartOptions::OTHER:
+				policy = SCHED_OTHER;
+				break;
+			case Thread::StartOptions::FIFO:
+				policy = SCHED_FIFO;
+				break;
+			case Thread::StartOptions::ROUND_ROBIN:
+				policy = SCHED_RR;
+				break;
+#	if M_OS == M_OS_LINUX
+			case Thread::StartOptions::BATCH:
+				policy = SCHED_BATCH;
+				break;
+			case Thread::StartOptions::IDLE:
+				policy = SCHED_IDLE;
+				break;
+#	endif
+			default:
+				return "scheduling policy is not supported on this OS";
+		}
+
+		//NOTE: pthread attributes do not support all the policies, so set the scheduling from within the thread
+		sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = options.priority;
+		if(int res = pthread_setschedparam(pthread_self(), policy, &param)){
+			ss << "pthread_setschedparam() failed, error code = " << res << ": " << strerror(res);
+			return ss.str();
+		}
+	}
+
+	if(options.name.size() != 0){
+#	if M_OS == M_OS_LINUX
+		//name length is limited to 16 characters including terminating 0
+		if(int res = pthread_setname_np(pthread_self(), options.name.substr(0, 15).c_str())){
+			ss << "pthread_setname_np() failed, error code = " << res << ": " << strerror(res);
+			return ss.str();
+		}
+#	else
+		if(int res = pthread_setname_np(options.name.c_str())){
+			ss << "pthread_setname_np() failed, error code = " << res << ": " << strerror(res);
+			return ss.str();
+		}
+#	endif
+	}
+
+	return std::string();
+}
+
+
+
+bool NeedsApplyingFromThread(const Thread::StartOptions& options){
+	return options.cpus.size() != 0
+			|| options.numaNode >= 0
+			|| options.name.size() != 0
+			|| options.schedPolicy != Thread::StartOptions::DEFAULT;
+}
+
+
+
+#endif
+
+
+
 }//~namespace
 
 
 
+struct Thread::StartContext{
+	const StartOptions& options;
+
+	//signalled by the new thread when it has applied the options
+	Semaphore applied;
+
+	//error description, empty if options were applied successfully
+	std::string error;
+
+	StartContext(const StartOptions& options) :
+			options(options)
+	{}
+};
+
+
+
 //Tread Run function
 //static
 #if M_OS == M_OS_WINDOWS
@@ -60,6 +195,21 @@ void* Thread::RunThread(void *data)
 #endif
 {
 	Thread *thr = reinterpret_cast<Thread*>(data);
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+	if(StartContext* ctx = thr->startContext){
+		ctx->error = ApplyThreadOptions(ctx->options);
+		bool failed = ctx->error.size() != 0;
+
+		//NOTE: after signalling, the context and, in case of failure, the thread object may be destroyed
+		ctx->applied.Signal();
+		if(failed){
+			//Start() joins the thread and throws, do not touch the thread object
+			return 0;
+		}
+	}
+#endif
+
 	try{
 		thr->Run();
 	}catch(ting::Exc& e){
@@ -124,6 +274,14 @@ Thread::~Thread()NOEXCEPT{
 
 
 void Thread::Start(size_t stackSize){
+	StartOptions options;
+	options.stackSize = stackSize;
+	this->Start(options);
+}
+
+
+
+void Thread::Start(const StartOptions& options){
 	//Protect by mutex to avoid several Start() methods to be called
 	//by concurrent threads simultaneously and to protect call to Join() before Start()
 	//has returned.
@@ -131,29 +289,59 @@ void Thread::Start(size_t stackSize){
 	
 	//Protect by mutex to avoid incorrect state changing in case when thread
 	//exits before the Start() method returned.
-	std::lock_guard<decltype(threadMutex2)> mutexGuard2(threadMutex2);
+	std::unique_lock<decltype(threadMutex2)> mutexGuard2(threadMutex2);
 
 	if(this->state != NEW){
 		throw HasAlreadyBeenStartedExc();
 	}
 
 #if M_OS == M_OS_WINDOWS
+	if(options.numaNode >= 0){
+		throw Exc("Thread::Start(): NUMA binding is not supported on this OS");
+	}
+
+	DWORD_PTR affinityMask = 0;
+	for(auto c : options.cpus){
+		if(c >= sizeof(affinityMask) * 8){
+			throw Exc("Thread::Start(): CPU number is too big");
+		}
+		affinityMask |= DWORD_PTR(1) << c;
+	}
+
+	//create suspended thread to apply the options before it starts running
 	this->th = reinterpret_cast<HANDLE>(
 			_beginthreadex(
 					NULL,
-					stackSize > size_t(unsigned(-1)) ? unsigned(-1) : unsigned(stackSize),
+					options.stackSize > size_t(unsigned(-1)) ? unsigned(-1) : unsigned(options.stackSize),
 					&RunThread,
 					reinterpret_cast<void*>(this),
-					0,
+					CREATE_SUSPENDED,
 					NULL
 				)
 		);
 	if(this->th == NULL){
 		throw Exc("Thread::Start(): _beginthreadex failed");
 	}
+
+	bool failed = false;
+	if(affinityMask != 0 && SetThreadAffinityMask(this->th, affinityMask) == 0){
+		failed = true;
+	}
+	if(!failed && options.schedPolicy != StartOptions::DEFAULT && SetThreadPriority(this->th, options.priority) == 0){
+		failed = true;
+	}
+	if(failed){
+		//thread has not run yet, so it is safe to terminate it
+		TerminateThread(this->th, 0);
+		CloseHandle(this->th);
+		this->th = NULL;
+		throw Exc("Thread::Start(): applying thread start options failed");
+	}
+
+	ResumeThread(this->th);
 #elif M_OS == M_OS_SYMBIAN
 	if(this->th.Create(_L("ting thread"), &RunThread,
-				stackSize == 0 ? KDefaultStackSize : stackSize,
+				options.stackSize == 0 ? KDefaultStackSize : options.stackSize,
 				NULL, reinterpret_cast<TAny*>(this)) != KErrNone
 			)
 	{
@@ -166,10 +354,19 @@ void Thread::Start(size_t stackSize){
 
 		pthread_attr_init(&attr);
 		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-		pthread_attr_setstacksize(&attr, stackSize);
+		if(options.stackSize != 0){
+			pthread_attr_setstacksize(&attr, options.stackSize);
+		}
+
+		std::unique_ptr<StartContext> ctx;
+		if(NeedsApplyingFromThread(options)){
+			ctx = std::unique_ptr<StartContext>(new StartContext(options));
+		}
+		this->startContext = ctx.get();
 
 		int res = pthread_create(&this->th, &attr, &RunThread, this);
 		if(res != 0){
+			this->startContext = nullptr;
 			pthread_attr_destroy(&attr);
 			TRACE_AND_LOG(<< "Thread::Start(): pthread_create() failed, error code = " << res
 					<< " meaning: " << strerror(res) << std::endl)
@@ -179,11 +376,32 @@ void Thread::Start(size_t stackSize){
 			throw Exc(ss.str());
 		}
 		pthread_attr_destroy(&attr);
+
+		if(ctx){
+			//Wait until the thread applies the options. The mutex is shared by all threads,
+			//so do not hold it while waiting, otherwise starting and exiting of other threads
+			//would be blocked until the new thread gets scheduled.
+			mutexGuard2.unlock();
+			ctx->applied.Wait();
+			mutexGuard2.lock();
+			this->startContext = nullptr;
+
+			if(ctx->error.size() != 0){
+				pthread_join(this->th, 0);
+				std::stringstream ss;
+				ss << "Thread::Start(): applying thread start options failed: " << ctx->error;
+				throw Exc(ss.str());
+			}
+		}
 	}
 #else
 #	error "Unsupported OS"
 #endif
-	this->state = RUNNING;
+	//In case the mutex was released while waiting for start options to be applied,
+	//the thread may have already exited and set the STOPPED state.
+	if(this->state == NEW){
+		this->state = RUNNING;
+	}
 }
 
 
@@ -39,6 +39,8 @@ THE SOFTWARE. */
 #include "../Exc.hpp"
 
 #include <mutex>
+#include <string>
+#include <vector>
 
 
 
@@ -100,6 +102,10 @@ class Thread{
 	
 	volatile E_State state = NEW;
 
+	//set while Start() waits for the new thread to apply start options, see Thread.cpp
+	struct StartContext;
+	StartContext* startContext = nullptr;
+
 	//system dependent handle
 #if M_OS == M_OS_WINDOWS
 	HANDLE th;
@@ -135,6 +141,66 @@ public:
 		{}
 	};
 	
+	/**
+	 * @brief Thread start options.
+	 * All the options are applied before the Thread::Run() method is called, so the thread
+	 * never runs user code with partially applied options. If some option cannot be applied,
+	 * then Thread::Start() throws and Thread::Run() is not called.
+	 */
+	struct StartOptions{
+		/**
+		 * @brief Scheduling policy.
+		 */
+		enum E_SchedPolicy{
+			DEFAULT,     ///< inherit scheduling of the creating thread
+			OTHER,       ///< normal time-sharing scheduling (SCHED_OTHER)
+			FIFO,        ///< real-time first-in first-out scheduling (SCHED_FIFO), usually requires privileges
+			ROUND_ROBIN, ///< real-time round-robin scheduling (SCHED_RR), usually requires privileges
+			BATCH,       ///< CPU-intensive batch processing (SCHED_BATCH), Linux only
+			IDLE         ///< very low priority background jobs (SCHED_IDLE), Linux only
+		};
+
+		/**
+		 * @brief Stack size in bytes.
+		 * If 0 then system default stack size is used.
+		 */
+		size_t stackSize = 0;
+
+		/**
+		 * @brief CPUs the thread is allowed to run on.
+		 * CPUs are numbered from 0. If empty, the affinity is inherited from the creating thread.
+		 * Not supported on Mac OS X. On Windows CPU numbers should be less than 64.
+		 */
+		std::vector<unsigned> cpus;
+
+		/**
+		 * @brief Thread name.
+		 * Name shown by debuggers and system tools. On Linux it is truncated to 15 characters.
+		 * If empty, the name is not set. Ignored on Windows.
+		 */
+		std::string name;
+
+		/**
+		 * @brief Scheduling policy.
+		 */
+		E_SchedPolicy schedPolicy = DEFAULT;
+
+		/**
+		 * @brief Scheduling priority.
+		 * Meaning depends on scheduling policy, for real-time policies it is real-time priority,
+		 * for other policies it should be 0. Ignored for DEFAULT policy.
+		 * On Windows it is a THREAD_PRIORITY_* value and scheduling policy is only checked for being DEFAULT.
+		 */
+		int priority = 0;
+
+		/**
+		 * @brief NUMA node to bind the thread's memory allocations to.
+		 * If negative, the memory policy is inherited from the creating thread.
+		 * Linux only. It is usually combined with the affinity to CPUs of the same node.
+		 */
+		int numaNode = -1;
+	};
+
 	Thread();
 	
 	
@@ -162,6 +228,17 @@ public:
 
 
 
+	/**
+	 * @brief Start thread execution with given options.
+	 * Same as Start(size_t), but also allows setting CPU affinity, name, scheduling
+	 * and NUMA memory binding of the thread. See Thread::StartOptions for details.
+	 * @param options - thread start options.
+	 * @throw Thread::Exc - if the thread could not be started or some option could not be applied.
+	 */
+	void Start(const StartOptions& options);
+
+
+
 	/**
 	 * @brief Wait for thread to finish its execution.
 	 * This function waits for the thread finishes its execution,
@@ -0,0 +1,369 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "BufferedStream.hpp"
+#include "../util.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+
+using namespace ting::net;
+
+
+
+size_t BufferedStream::RingBuffer::DataParts(std::array<ting::Buffer<const std::uint8_t>, 2>& out_Parts)const NOEXCEPT{
+	if(this->size == 0){
+		return 0;
+	}
+	
+	size_t firstSize = std::min(this->size, this->buf.size() - this->begin);
+	out_Parts[0] = ting::Buffer<const std::uint8_t>(&*this->buf.begin() + this->begin, firstSize);
+	if(firstSize == this->size){
+		return 1;
+	}
+	out_Parts[1] = ting::Buffer<const std::uint8_t>(&*this->buf.begin(), this->size - firstSize);
+	return 2;
+}
+
+
+
+size_t BufferedStream::RingBuffer::FreeParts(std::array<ting::Buffer<std::uint8_t>, 2>& out_Parts)NOEXCEPT{
+	size_t numFree = this->NumFree();
+	if(numFree == 0){
+		return 0;
+	}
+	
+	size_t end = (this->begin + this->size) % this->buf.size();
+	size_t firstSize = std::min(numFree, this->buf.size() - end);
+	out_Parts[0] = ting::Buffer<std::uint8_t>(&*this->buf.begin() + end, firstSize);
+	if(firstSize == numFree){
+		return 1;
+	}
+	out_Parts[1] = ting::Buffer<std::uint8_t>(&*this->buf.begin(), numFree - firstSize);
+	return 2;
+}
+
+
+
+const std::uint8_t* BufferedStream::RingBuffer::Contiguous(size_t offset, size_t length)const NOEXCEPT{
+	ASSERT(offset + length <= this->size)
+	size_t start = (this->begin + offset) % this->buf.size();
+	if(start + length > this->buf.size()){
+		return nullptr;
+	}
+	return &*this->buf.begin() + start;
+}
+
+
+
+void BufferedStream::RingBuffer::Copy(size_t offset, ting::Buffer<std::uint8_t> out_Buf)const NOEXCEPT{
+	ASSERT(offset + out_Buf.size() <= this->size)
+	if(out_Buf.size() == 0){
+		return;
+	}
+	
+	size_t start = (this->begin + offset) % this->buf.size();
+	size_t firstSize = std::min(out_Buf.size(), this->buf.size() - start);
+	memcpy(&*out_Buf.begin(), &*this->buf.begin() + start, firstSize);
+	memcpy(&*out_Buf.begin() + firstSize, &*this->buf.begin(), out_Buf.size() - firstSize);
+}
+
+
+
+void BufferedStream::RingBuffer::Append(ting::Buffer<const std::uint8_t> data)NOEXCEPT{
+	ASSERT(data.size() <= this->NumFree())
+	
+	std::array<ting::Buffer<std::uint8_t>, 2> parts;
+	size_t numParts = this->FreeParts(parts);
+	
+	size_t numCopied = 0;
+	for(size_t i = 0; i != numParts && numCopied != data.size(); ++i){
+		size_t n = std::min(parts[i].size(), data.size() - numCopied);
+		memcpy(&*parts[i].begin(), &*data.begin() + numCopied, n);
+		numCopied += n;
+	}
+	this->size += numCopied;
+}
+
+
+
+BufferedStream::BufferedStream(TCPSocket& socket, size_t inCapacity, size_t outCapacity) :
+		socket(socket),
+		in(inCapacity),
+		out(outCapacity)
+{
+	if(inCapacity == 0 || outCapacity == 0){
+		throw net::Exc("BufferedStream::BufferedStream(): buffer capacity must be greater than 0");
+	}
+}
+
+
+
+ting::Waitable::EReadinessFlags BufferedStream::WaitingFlags()const NOEXCEPT{
+	std::uint32_t flags = Waitable::NOT_READY;
+	
+	//input buffer space which is held by the last received frame will be freed on next Fill()
+	if((this->in.NumFree() != 0 || this->numBytesToRelease != 0) && !this->isPeerClosed){
+		flags |= Waitable::READ;
+	}
+	
+	if(this->out.Size() != 0){
+		flags |= Waitable::WRITE;
+	}
+	
+	return Waitable::EReadinessFlags(flags);
+}
+
+
+
+void BufferedStream::HandleReadiness(){
+	if(this->socket.CanWrite()){
+		this->Flush();
+	}
+	
+	if(this->socket.CanRead() || this->socket.ErrorCondition()){
+		this->Fill();
+	}
+}
+
+
+
+size_t BufferedStream::Fill(){
+	this->Release();
+	
+	std::array<ting::Buffer<std::uint8_t>, 2> parts;
+	size_t numParts = this->in.FreeParts(parts);
+	if(numParts == 0){
+		return 0;
+	}
+	
+	//Recv() clears the 'can read' flag, so remember it to detect closing of the connection
+	bool canRead = this->socket.CanRead();
+	
+	size_t numReceived = this->socket.Recv(ting::Buffer<const ting::Buffer<std::uint8_t>>(&*parts.begin(), numParts));
+	if(numReceived == 0 && canRead){
+		this->isPeerClosed = true;
+	}
+	
+	this->in.Commit(numReceived);
+	return numReceived;
+}
+
+
+
+size_t BufferedStream::Flush(){
+	std::array<ting::Buffer<const std::uint8_t>, 2> parts;
+	size_t numParts = this->out.DataParts(parts);
+	if(numParts == 0){
+		return 0;
+	}
+	
+	size_t numSent = this->socket.Send(ting::Buffer<const ting::Buffer<const std::uint8_t>>(&*parts.begin(), numParts));
+	this->out.Consume(numSent);
+	return numSent;
+}
+
+
+
+size_t BufferedStream::Peek(ting::Buffer<std::uint8_t> out_Buf)const NOEXCEPT{
+	size_t n = std::min(out_Buf.size(), this->NumBytesAvailable());
+	this->in.Copy(this->numBytesToRelease, ting::Buffer<std::uint8_t>(&*out_Buf.begin(), n));
+	return n;
+}
+
+
+
+size_t BufferedStream::Find(ting::Buffer<const std::uint8_t> pattern, size_t from)const NOEXCEPT{
+	size_t size = this->NumBytesAvailable();
+	if(pattern.size() == 0 || pattern.size() > size){
+		return DNotFound();
+	}
+	
+	for(size_t i = from; i <= size - pattern.size(); ++i){
+		size_t j = 0;
+		for(; j != pattern.size() && this->in[this->numBytesToRelease + i + j] == pattern[j]; ++j){}
+		if(j == pattern.size()){
+			return i;
+		}
+	}
+	return DNotFound();
+}
+
+
+
+size_t BufferedStream::Read(ting::Buffer<std::uint8_t> out_Buf)NOEXCEPT{
+	this->Release();
+	
+	size_t n = this->Peek(out_Buf);
+	this->in.Consume(n);
+	return n;
+}
+
+
+
+bool BufferedStream::RecvFrame(Framer& framer, ting::Buffer<const std::uint8_t>& out_Payload){
+	this->Release();
+	
+	size_t headerSize, payloadSize, trailerSize;
+	if(!framer.FindFrame(*this, headerSize, payloadSize, trailerSize)){
+		return false;
+	}
+	ASSERT(headerSize + payloadSize + trailerSize <= this->in.Size())
+	
+	if(const std::uint8_t* p = this->in.Contiguous(headerSize, payloadSize)){
+		out_Payload = ting::Buffer<const std::uint8_t>(p, payloadSize);
+	}else{
+		this->frameBuf.resize(payloadSize);
+		this->in.Copy(headerSize, this->frameBuf);
+		out_Payload = ting::Buffer<const std::uint8_t>(this->frameBuf);
+	}
+	
+	//keep the frame in the input buffer until next reading, so that the payload stays valid
+	this->numBytesToRelease = headerSize + payloadSize + trailerSize;
+	return true;
+}
+
+
+
+size_t BufferedStream::Write(ting::Buffer<const std::uint8_t> data){
+	size_t numSent = 0;
+	if(this->out.Size() == 0){
+		numSent = this->socket.Send(data);
+	}
+	
+	size_t n = std::min(data.size() - numSent, this->out.NumFree());
+	this->out.Append(ting::Buffer<const std::uint8_t>(&*data.begin() + numSent, n));
+	return numSent + n;
+}
+
+
+
+bool BufferedStream::WriteFrame(Framer& framer, ting::Buffer<const std::uint8_t> payload){
+	std::array<std::uint8_t, Framer::DMaxHeaderSize()> header;
+	size_t headerSize = framer.MakeHeader(payload.size(), header);
+	ASSERT(headerSize <= header.size())
+	
+	std::array<ting::Buffer<const std::uint8_t>, 3> parts = {{
+		ting::Buffer<const std::uint8_t>(&*header.begin(), headerSize),
+		payload,
+		framer.Trailer()
+	}};
+	
+	size_t frameSize = headerSize + payload.size() + parts[2].size();
+	if(frameSize > this->out.Capacity()){
+		throw net::Exc("BufferedStream::WriteFrame(): frame is bigger than output buffer");
+	}
+	if(frameSize > this->out.NumFree()){
+		return false;
+	}
+	
+	size_t numSent = 0;
+	if(this->out.Size() == 0){
+		numSent = this->socket.Send(parts);
+	}
+	
+	//buffer the rest of the frame
+	for(auto& p : parts){
+		if(numSent >= p.size()){
+			numSent -= p.size();
+			continue;
+		}
+		this->out.Append(ting::Buffer<const std::uint8_t>(&*p.begin() + numSent, p.size() - numSent));
+		numSent = 0;
+	}
+	return true;
+}
+
+
+
+bool BufferedStream::LengthPrefixFramer::FindFrame(const BufferedStream& stream, size_t& out_HeaderSize, size_t& out_PayloadSize, size_t& out_TrailerSize){
+	std::array<std::uint8_t, 4> header;
+	if(stream.Peek(header) != header.size()){
+		return false;
+	}
+	
+	size_t payloadSize = ting::util::Deserialize32BE(&*header.begin());
+	if(payloadSize > this->maxPayloadSize || payloadSize > stream.InputCapacity() - header.size()){
+		throw net::Exc("BufferedStream::LengthPrefixFramer::FindFrame(): frame is too big");
+	}
+	
+	if(stream.NumBytesAvailable() < header.size() + payloadSize){
+		return false;
+	}
+	
+	out_HeaderSize = header.size();
+	out_PayloadSize = payloadSize;
+	out_TrailerSize = 0;
+	return true;
+}
+
+
+
+size_t BufferedStream::LengthPrefixFramer::MakeHeader(size_t payloadSize, ting::Buffer<std::uint8_t> out_Header){
+	ASSERT(out_Header.size() >= 4)
+	if(payloadSize > this->maxPayloadSize || payloadSize > size_t(std::uint32_t(-1))){
+		throw net::Exc("BufferedStream::LengthPrefixFramer::MakeHeader(): frame is too big");
+	}
+	ting::util::Serialize32BE(std::uint32_t(payloadSize), &*out_Header.begin());
+	return 4;
+}
+
+
+
+BufferedStream::DelimiterFramer::DelimiterFramer(ting::Buffer<const std::uint8_t> delimiter) :
+		delimiter(delimiter.begin(), delimiter.end())
+{
+	if(this->delimiter.size() == 0){
+		throw net::Exc("BufferedStream::DelimiterFramer::DelimiterFramer(): delimiter must not be empty");
+	}
+}
+
+
+
+bool BufferedStream::DelimiterFramer::FindFrame(const BufferedStream& stream, size_t& out_HeaderSize, size_t& out_PayloadSize, size_t& out_TrailerSize){
+	size_t pos = stream.Find(this->delimiter, this->numSearched);
+	if(pos == DNotFound()){
+		size_t numAvailable = stream.NumBytesAvailable();
+		if(numAvailable == stream.InputCapacity()){
+			throw net::Exc("BufferedStream::DelimiterFramer::FindFrame(): frame is too big");
+		}
+		
+		//do not search through the same data again, except for the bytes which may be a beginning of the delimiter
+		if(numAvailable >= this->delimiter.size()){
+			this->numSearched = numAvailable - (this->delimiter.size() - 1);
+		}
+		return false;
+	}
+	
+	this->numSearched = 0;
+	
+	out_HeaderSize = 0;
+	out_PayloadSize = pos;
+	out_TrailerSize = this->delimiter.size();
+	return true;
+}
@@ -0,0 +1,389 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include <vector>
+#include <array>
+
+#include "TCPSocket.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Buffered stream over TCP socket.
+ * Provides input and output buffering for non-blocking TCP socket. Received data is
+ * accumulated in the input ring buffer until whole frames (messages) are available, and
+ * data which could not be sent immediately is kept in the output ring buffer and is sent
+ * later, when the socket becomes ready for writing.
+ *
+ * Typical usage is to add the socket to a WaitSet with flags returned by WaitingFlags(),
+ * call HandleReadiness() every time the WaitSet reports the socket, then read the received
+ * frames with RecvFrame() and update the waiting flags of the socket with WaitingFlags().
+ *
+ * The stream does not own the socket, so the socket must outlive the stream.
+ */
+class BufferedStream{
+public:
+	/**
+	 * @brief Value returned by Find() if the pattern was not found.
+	 */
+	static constexpr size_t DNotFound()NOEXCEPT{
+		return size_t(-1);
+	}
+	
+	/**
+	 * @brief Base class for framers.
+	 * Framer defines how frames are delimited in the stream. Framers may keep the state
+	 * of the frame being received, so one framer object should be used for one stream and
+	 * received data should not be removed from the stream other than with RecvFrame() using that framer.
+	 */
+	class Framer{
+	public:
+		/**
+		 * @brief Maximum size of the frame header.
+		 */
+		static constexpr size_t DMaxHeaderSize()NOEXCEPT{
+			return 16;
+		}
+		
+		virtual ~Framer()NOEXCEPT{}
+		
+		/**
+		 * @brief Find frame at the beginning of the received data.
+		 * @param stream - stream to look for the frame in.
+		 * @param out_HeaderSize - number of header bytes preceding the frame payload.
+		 * @param out_PayloadSize - size of the frame payload.
+		 * @param out_TrailerSize - number of trailer bytes following the frame payload.
+		 * @return true if complete frame has been received.
+		 * @return false if more data is needed.
+		 * @throw net::Exc - if the frame can never be received, e.g. it does not fit into the input buffer.
+		 */
+		virtual bool FindFrame(const BufferedStream& stream, size_t& out_HeaderSize, size_t& out_PayloadSize, size_t& out_TrailerSize) = 0;
+		
+		/**
+		 * @brief Make frame header.
+		 * @param payloadSize - size of the frame payload.
+		 * @param out_Header - buffer of DMaxHeaderSize() bytes to write the header to.
+		 * @return size of the header in bytes.
+		 */
+		virtual size_t MakeHeader(size_t payloadSize, ting::Buffer<std::uint8_t> out_Header) = 0;
+		
+		/**
+		 * @brief Get frame trailer.
+		 * @return bytes to send after the frame payload.
+		 */
+		virtual ting::Buffer<const std::uint8_t> Trailer()const NOEXCEPT = 0;
+	};
+	
+	
+	
+	/**
+	 * @brief Length-prefix framer.
+	 * Each frame is preceded by 4 byte big-endian length of the frame payload.
+	 */
+	class LengthPrefixFramer : public Framer{
+		size_t maxPayloadSize;
+	public:
+		/**
+		 * @brief Constructor.
+		 * @param maxPayloadSize - maximum allowed payload size. Frames with bigger payload
+		 *                         are treated as protocol error.
+		 */
+		LengthPrefixFramer(size_t maxPayloadSize = size_t(-1))NOEXCEPT :
+				maxPayloadSize(maxPayloadSize)
+		{}
+		
+		bool FindFrame(const BufferedStream& stream, size_t& out_HeaderSize, size_t& out_PayloadSize, size_t& out_TrailerSize)override;
+		
+		size_t MakeHeader(size_t payloadSize, ting::Buffer<std::uint8_t> out_Header)override;
+		
+		ting::Buffer<const std::uint8_t> Trailer()const NOEXCEPT override{
+			return ting::Buffer<const std::uint8_t>();
+		}
+	};
+	
+	
+	
+	/**
+	 * @brief Delimiter framer.
+	 * Each frame is followed by the delimiter byte sequence, e.g. "\r\n".
+	 * The payload must not contain the delimiter.
+	 */
+	class DelimiterFramer : public Framer{
+		std::vector<std::uint8_t> delimiter;
+		
+		//number of bytes already searched for the delimiter without success
+		size_t numSearched = 0;
+	public:
+		/**
+		 * @brief Constructor.
+		 * @param delimiter - delimiter byte sequence, must not be empty.
+		 */
+		DelimiterFramer(ting::Buffer<const std::uint8_t> delimiter);
+		
+		bool FindFrame(const BufferedStream& stream, size_t& out_HeaderSize, size_t& out_PayloadSize, size_t& out_TrailerSize)override;
+		
+		size_t MakeHeader(size_t payloadSize, ting::Buffer<std::uint8_t> out_Header)override{
+			return 0;
+		}
+		
+		ting::Buffer<const std::uint8_t> Trailer()const NOEXCEPT override{
+			return ting::Buffer<const std::uint8_t>(this->delimiter);
+		}
+	};
+	
+	
+	
+private:
+	class RingBuffer{
+		std::vector<std::uint8_t> buf;
+		size_t begin = 0;
+		size_t size = 0;
+	public:
+		RingBuffer(size_t capacity) :
+				buf(capacity)
+		{}
+		
+		size_t Capacity()const NOEXCEPT{
+			return this->buf.size();
+		}
+		
+		size_t Size()const NOEXCEPT{
+			return this->size;
+		}
+		
+		size_t NumFree()const NOEXCEPT{
+			return this->buf.size() - this->size;
+		}
+		
+		std::uint8_t operator[](size_t i)const NOEXCEPT{
+			ASSERT(i < this->size)
+			return this->buf[(this->begin + i) % this->buf.size()];
+		}
+		
+		//returns number of filled parts, 0, 1 or 2
+		size_t DataParts(std::array<ting::Buffer<const std::uint8_t>, 2>& out_Parts)const NOEXCEPT;
+		
+		//returns number of filled parts, 0, 1 or 2
+		size_t FreeParts(std::array<ting::Buffer<std::uint8_t>, 2>& out_Parts)NOEXCEPT;
+		
+		//returns pointer to contiguous block of 'length' bytes at 'offset' or nullptr if the block wraps around
+		const std::uint8_t* Contiguous(size_t offset, size_t length)const NOEXCEPT;
+		
+		void Copy(size_t offset, ting::Buffer<std::uint8_t> out_Buf)const NOEXCEPT;
+		
+		void Append(ting::Buffer<const std::uint8_t> data)NOEXCEPT;
+		
+		void Commit(size_t numBytes)NOEXCEPT{
+			ASSERT(numBytes <= this->NumFree())
+			this->size += numBytes;
+		}
+		
+		void Consume(size_t numBytes)NOEXCEPT{
+			ASSERT(numBytes <= this->size)
+			this->size -= numBytes;
+			this->begin = this->size == 0 ? 0 : (this->begin + numBytes) % this->buf.size();
+		}
+	};
+	
+	TCPSocket& socket;
+	
+	RingBuffer in;
+	RingBuffer out;
+	
+	//number of bytes of the frame returned by last RecvFrame() which are to be removed from input buffer
+	size_t numBytesToRelease = 0;
+	
+	//holds payload of the last received frame if it was wrapped around in the input buffer
+	std::vector<std::uint8_t> frameBuf;
+	
+	bool isPeerClosed = false;
+	
+	void Release()NOEXCEPT{
+		this->in.Consume(this->numBytesToRelease);
+		this->numBytesToRelease = 0;
+	}
+	
+public:
+	/**
+	 * @brief Constructor.
+	 * @param socket - connected TCP socket.
+	 * @param inCapacity - size of the input buffer, limits the maximum size of frame which can be received.
+	 * @param outCapacity - size of the output buffer, limits the maximum size of frame which can be sent.
+	 */
+	BufferedStream(TCPSocket& socket, size_t inCapacity = 0x10000, size_t outCapacity = 0x10000);
+	
+	BufferedStream(const BufferedStream&) = delete;
+	BufferedStream& operator=(const BufferedStream&) = delete;
+	
+	/**
+	 * @brief Get socket of the stream.
+	 * @return reference to the socket.
+	 */
+	TCPSocket& GetSocket()NOEXCEPT{
+		return this->socket;
+	}
+	
+	/**
+	 * @brief Get flags to wait for on the socket.
+	 * @return READ if there is free space in input buffer, plus WRITE if there is pending data in output buffer.
+	 */
+	Waitable::EReadinessFlags WaitingFlags()const NOEXCEPT;
+	
+	/**
+	 * @brief Handle readiness of the socket.
+	 * Sends pending output data if the socket is ready for writing and
+	 * receives data to input buffer if the socket is ready for reading.
+	 * Supposed to be called after WaitSet has reported the socket.
+	 * @throw net::Exc - in case of socket error.
+	 */
+	void HandleReadiness();
+	
+	/**
+	 * @brief Receive available data from socket to input buffer.
+	 * Invalidates the payload returned by last RecvFrame().
+	 * @return number of bytes received.
+	 */
+	size_t Fill();
+	
+	/**
+	 * @brief Send pending data from output buffer.
+	 * @return number of bytes sent.
+	 */
+	size_t Flush();
+	
+	/**
+	 * @brief Check if peer has closed the connection.
+	 * The state is detected by Fill() when socket is ready for reading but there is no data to read.
+	 * Data received before closing can still be read from the stream.
+	 * @return true if peer has closed the connection.
+	 */
+	bool IsPeerClosed()const NOEXCEPT{
+		return this->isPeerClosed;
+	}
+	
+	/**
+	 * @brief Check if there is pending data in output buffer.
+	 * @return true if there is data which was not sent yet.
+	 */
+	bool HasPendingOutput()const NOEXCEPT{
+		return this->out.Size() != 0;
+	}
+	
+	/**
+	 * @brief Get input buffer size.
+	 * @return capacity of the input buffer.
+	 */
+	size_t InputCapacity()const NOEXCEPT{
+		return this->in.Capacity();
+	}
+	
+	/**
+	 * @brief Get number of received bytes available for reading.
+	 * @return number of bytes in the input buffer.
+	 */
+	size_t NumBytesAvailable()const NOEXCEPT{
+		return this->in.Size() - this->numBytesToRelease;
+	}
+	
+	/**
+	 * @brief Copy received data without removing it from the stream.
+	 * @param out_Buf - buffer to copy data to.
+	 * @return number of bytes copied.
+	 */
+	size_t Peek(ting::Buffer<std::uint8_t> out_Buf)const NOEXCEPT;
+	
+	/**
+	 * @brief Find byte sequence in the received data.
+	 * @param pattern - byte sequence to look for.
+	 * @param from - offset in the received data to start searching from.
+	 * @return offset of the first occurrence of the pattern.
+	 * @return DNotFound() if the pattern is not found.
+	 */
+	size_t Find(ting::Buffer<const std::uint8_t> pattern, size_t from = 0)const NOEXCEPT;
+	
+	/**
+	 * @brief Read received data.
+	 * Copies received data to the given buffer and removes it from the stream.
+	 * Invalidates the payload returned by last RecvFrame().
+	 * @param out_Buf - buffer to copy data to.
+	 * @return number of bytes read.
+	 */
+	size_t Read(ting::Buffer<std::uint8_t> out_Buf)NOEXCEPT;
+	
+	/**
+	 * @brief Receive frame.
+	 * Removes next complete frame from the stream. Only data which is already in the input buffer is examined,
+	 * use Fill() or HandleReadiness() to receive data from socket.
+	 * Payload of the frame is returned as a buffer pointing directly into the input buffer of the stream,
+	 * unless the frame wraps around the end of the ring buffer, only in that case the payload is copied.
+	 * The returned payload buffer is valid until next call to RecvFrame(), Read(), Fill() or HandleReadiness().
+	 * @param framer - framer to use.
+	 * @param out_Payload - returns payload of the received frame.
+	 * @return true if the frame was received.
+	 * @return false if there is no complete frame in the input buffer.
+	 * @throw net::Exc - if framer has detected a frame which can never be received.
+	 */
+	bool RecvFrame(Framer& framer, ting::Buffer<const std::uint8_t>& out_Payload);
+	
+	/**
+	 * @brief Write data.
+	 * If there is no pending output data, tries to send the data right away, without copying.
+	 * The rest of data is appended to the output buffer, as much as fits.
+	 * @param data - data to write.
+	 * @return number of bytes sent or buffered.
+	 */
+	size_t Write(ting::Buffer<const std::uint8_t> data);
+	
+	/**
+	 * @brief Write frame.
+	 * Writes frame header, payload and trailer. Frame is written as a whole, if there is not enough space in
+	 * output buffer then nothing is written. If there is no pending output data, tries to send the frame
+	 * right away with a single system call, without copying.
+	 * @param framer - framer to use.
+	 * @param payload - payload of the frame.
+	 * @return true if the frame was written.
+	 * @return false if there is not enough space in output buffer at the moment.
+	 * @throw net::Exc - if frame is bigger than output buffer, i.e. it can never be written.
+	 */
+	bool WriteFrame(Framer& framer, ting::Buffer<const std::uint8_t> payload);
+};//~class BufferedStream
+
+
+
+}//~namespace
+}//~namespace
@@ -36,6 +36,16 @@ THE SOFTWARE. */
 #	include <ws2tcpip.h>
 #endif
 
+//older system headers may lack these definitions
+#if M_OS == M_OS_LINUX
+#	ifndef SO_BUSY_POLL
+#		define SO_BUSY_POLL 46
+#	endif
+#	ifndef TCP_NOTSENT_LOWAT
+#		define TCP_NOTSENT_LOWAT 25
+#	endif
+#endif
+
 
 
 using namespace ting::net;
@@ -100,6 +110,37 @@ Socket& Socket::operator=(Socket&& s){
 
 
 
+int Socket::GetLastErrorCode()NOEXCEPT{
+#if M_OS == M_OS_WINDOWS
+	return WSAGetLastError();
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	return errno;
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+void Socket::ThrowError(const char* what, int errorCode){
+	std::stringstream ss;
+	ss << what << ", error code = " << errorCode << ": ";
+#if M_COMPILER == M_COMPILER_MSVC
+	{
+		const size_t msgbufSize = 0xff;
+		char msgbuf[msgbufSize];
+		strerror_s(msgbuf, msgbufSize, errorCode);
+		msgbuf[msgbufSize - 1] = 0;//make sure the string is null-terminated
+		ss << msgbuf;
+	}
+#else
+	ss << strerror(errorCode);
+#endif
+	throw net::Exc(ss.str());
+}
+
+
+
 void Socket::DisableNaggle(){
 	if(!*this){
 		throw net::Exc("Socket::DisableNaggle(): socket is not valid");
@@ -183,6 +224,157 @@ std::uint16_t Socket::GetLocalPort(){
 
 
 
+void Socket::SetOption(int level, int name, int value, const char* what){
+	if(!*this){
+		std::stringstream ss;
+		ss << what << ": socket is not valid";
+		throw net::Exc(ss.str());
+	}
+
+	if(setsockopt(this->socket, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) != 0){
+		ThrowError(what, GetLastErrorCode());
+	}
+}
+
+
+
+int Socket::GetOption(int level, int name, const char* what){
+	if(!*this){
+		std::stringstream ss;
+		ss << what << ": socket is not valid";
+		throw net::Exc(ss.str());
+	}
+
+	int value = 0;
+#if M_OS == M_OS_WINDOWS
+	int len = sizeof(value);
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	socklen_t len = sizeof(value);
+#else
+#	error "Unsupported OS"
+#endif
+	if(getsockopt(this->socket, level, name, reinterpret_cast<char*>(&value), &len) != 0){
+		ThrowError(what, GetLastErrorCode());
+	}
+	return value;
+}
+
+
+
+void Socket::ApplyOptions(const SocketOptions& options){
+	if(options.disableNaggle){
+		this->DisableNaggle();
+	}
+
+	if(options.sendBufferSize != 0){
+		this->SetSendBufferSize(options.sendBufferSize);
+	}
+
+	if(options.recvBufferSize != 0){
+		this->SetRecvBufferSize(options.recvBufferSize);
+	}
+
+	if(options.keepAlive){
+		this->SetKeepAlive(true, options.keepAliveIdle, options.keepAliveInterval, options.keepAliveCount);
+	}
+
+	if(options.lingerTimeout >= 0){
+		this->SetLinger(options.lingerTimeout);
+	}
+
+	if(options.notSentLowWatermark != 0){
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+		this->SetOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT, int(options.notSentLowWatermark), "Socket::ApplyOptions(): setting TCP_NOTSENT_LOWAT failed");
+#else
+		throw net::Exc("Socket::ApplyOptions(): TCP_NOTSENT_LOWAT is not supported on this OS");
+#endif
+	}
+
+	if(options.busyPoll != 0){
+		this->SetBusyPoll(options.busyPoll);
+	}
+}
+
+
+
+void Socket::SetSendBufferSize(size_t size){
+	this->SetOption(SOL_SOCKET, SO_SNDBUF, int(size), "Socket::SetSendBufferSize(): setsockopt(SO_SNDBUF) failed");
+}
+
+
+
+size_t Socket::GetSendBufferSize(){
+	return size_t(this->GetOption(SOL_SOCKET, SO_SNDBUF, "Socket::GetSendBufferSize(): getsockopt(SO_SNDBUF) failed"));
+}
+
+
+
+void Socket::SetRecvBufferSize(size_t size){
+	this->SetOption(SOL_SOCKET, SO_RCVBUF, int(size), "Socket::SetRecvBufferSize(): setsockopt(SO_RCVBUF) failed");
+}
+
+
+
+size_t Socket::GetRecvBufferSize(){
+	return size_t(this->GetOption(SOL_SOCKET, SO_RCVBUF, "Socket::GetRecvBufferSize(): getsockopt(SO_RCVBUF) failed"));
+}
+
+
+
+void Socket::SetKeepAlive(bool enable, unsigned idle, unsigned interval, unsigned count){
+	this->SetOption(SOL_SOCKET, SO_KEEPALIVE, enable ? 1 : 0, "Socket::SetKeepAlive(): setsockopt(SO_KEEPALIVE) failed");
+
+	if(!enable || (idle == 0 && interval == 0 && count == 0)){
+		return;
+	}
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || defined(TCP_KEEPIDLE)
+	if(idle != 0){
+#	if M_OS == M_OS_MACOSX
+		this->SetOption(IPPROTO_TCP, TCP_KEEPALIVE, int(idle), "Socket::SetKeepAlive(): setsockopt(TCP_KEEPALIVE) failed");
+#	else
+		this->SetOption(IPPROTO_TCP, TCP_KEEPIDLE, int(idle), "Socket::SetKeepAlive(): setsockopt(TCP_KEEPIDLE) failed");
+#	endif
+	}
+	if(interval != 0){
+		this->SetOption(IPPROTO_TCP, TCP_KEEPINTVL, int(interval), "Socket::SetKeepAlive(): setsockopt(TCP_KEEPINTVL) failed");
+	}
+	if(count != 0){
+		this->SetOption(IPPROTO_TCP, TCP_KEEPCNT, int(count), "Socket::SetKeepAlive(): setsockopt(TCP_KEEPCNT) failed");
+	}
+#else
+	throw net::Exc("Socket::SetKeepAlive(): setting keep-alive timings is not supported on this OS");
+#endif
+}
+
+
+
+void Socket::SetLinger(int timeout){
+	if(!*this){
+		throw net::Exc("Socket::SetLinger(): socket is not valid");
+	}
+
+	linger l;
+	l.l_onoff = timeout >= 0 ? 1 : 0;
+	l.l_linger = timeout >= 0 ? timeout : 0;
+
+	if(setsockopt(this->socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&l), sizeof(l)) != 0){
+		ThrowError("Socket::SetLinger(): setsockopt(SO_LINGER) failed", GetLastErrorCode());
+	}
+}
+
+
+
+void Socket::SetBusyPoll(unsigned microseconds){
+#if M_OS == M_OS_LINUX
+	this->SetOption(SOL_SOCKET, SO_BUSY_POLL, int(microseconds), "Socket::SetBusyPoll(): setsockopt(SO_BUSY_POLL) failed");
+#else
+	throw net::Exc("Socket::SetBusyPoll(): busy polling is not supported on this OS");
+#endif
+}
+
+
+
 #if M_OS == M_OS_WINDOWS
 
 //override
@@ -71,6 +71,92 @@ namespace net{
 
 
 
+/**
+ * @brief Socket options.
+ * Options which are applied to the socket when it is opened, i.e. before connecting
+ * or before starting to listen. Some options, like buffer sizes or TCP Fast Open, have
+ * full effect only if they are set before the connection is established.
+ * Options set on a TCP server socket are inherited by accepted sockets.
+ * Default values of all the fields mean "leave system default".
+ */
+struct SocketOptions{
+	/**
+	 * @brief Disable Naggle algorithm (TCP_NODELAY).
+	 */
+	bool disableNaggle = false;
+	
+	/**
+	 * @brief Size of the socket send buffer in bytes (SO_SNDBUF).
+	 * If 0 then system default is used.
+	 */
+	size_t sendBufferSize = 0;
+	
+	/**
+	 * @brief Size of the socket receive buffer in bytes (SO_RCVBUF).
+	 * If 0 then system default is used.
+	 * For TCP it also determines the window scale factor, so it should be set before connecting.
+	 */
+	size_t recvBufferSize = 0;
+	
+	/**
+	 * @brief Enable sending of keep-alive probes (SO_KEEPALIVE).
+	 */
+	bool keepAlive = false;
+	
+	/**
+	 * @brief Idle time in seconds before the first keep-alive probe is sent.
+	 * If 0 then system default is used. Ignored if keepAlive is false.
+	 */
+	unsigned keepAliveIdle = 0;
+	
+	/**
+	 * @brief Interval in seconds between keep-alive probes.
+	 * If 0 then system default is used. Ignored if keepAlive is false.
+	 */
+	unsigned keepAliveInterval = 0;
+	
+	/**
+	 * @brief Number of unanswered keep-alive probes after which the connection is dropped.
+	 * If 0 then system default is used. Ignored if keepAlive is false.
+	 */
+	unsigned keepAliveCount = 0;
+	
+	/**
+	 * @brief Linger timeout in seconds (SO_LINGER).
+	 * If negative then lingering is disabled, i.e. Close() returns immediately and
+	 * the system sends remaining data in background, this is the system default.
+	 * If 0 then Close() discards unsent data and resets the connection.
+	 */
+	int lingerTimeout = -1;
+	
+	/**
+	 * @brief Limit of unsent bytes in the socket send buffer (TCP_NOTSENT_LOWAT).
+	 * The socket is reported as ready for writing only when the amount of unsent data
+	 * drops below this limit. This keeps the send queue short, reducing latency of
+	 * the data which is prepared just before sending.
+	 * If 0 then system default is used. Linux and Mac OS X only.
+	 */
+	size_t notSentLowWatermark = 0;
+	
+	/**
+	 * @brief Busy polling time in microseconds (SO_BUSY_POLL).
+	 * Time to busy poll the network device queue when there is no data to receive,
+	 * trades CPU time for lower receive latency.
+	 * If 0 then system default is used. Linux only.
+	 */
+	unsigned busyPoll = 0;
+	
+	/**
+	 * @brief Enable TCP Fast Open (TCP_FASTOPEN, TCP_FASTOPEN_CONNECT).
+	 * Allows sending data in the SYN packet, saving one round trip on repeated connections
+	 * to the same server. Must be enabled on both sides and allowed by the system configuration.
+	 * Linux only.
+	 */
+	bool fastOpen = false;
+};
+
+
+
 /**
  * @brief Basic socket class.
  * This is a base class for all socket types such as TCP sockets or UDP sockets.
@@ -155,6 +241,30 @@ protected:
 
 
 
+	//applies options which are common for all kinds of TCP sockets, TCP Fast Open is not applied
+	void ApplyOptions(const SocketOptions& options);
+
+
+
+	//throws net::Exc if setting of the option fails, 'what' is used in exception message
+	void SetOption(int level, int name, int value, const char* what);
+
+
+
+	int GetOption(int level, int name, const char* what);
+
+
+
+	//returns error code of the last failed socket operation
+	static int GetLastErrorCode()NOEXCEPT;
+
+
+
+	//throws net::Exc with message composed of 'what' and description of the error code
+	static void ThrowError(const char* what, int errorCode);
+
+
+
 public:
 	Socket(Socket&& s) :
 			//NOTE: operator=() will call Close, so the socket should be in invalid state!!!
@@ -197,6 +307,73 @@ public:
 
 
 
+	/**
+	 * @brief Set size of the socket send buffer.
+	 * @param size - buffer size in bytes. Note, that Linux doubles the value to allow space for bookkeeping.
+	 * @throw net::Exc - if socket is not opened or on error.
+	 */
+	void SetSendBufferSize(size_t size);
+
+
+
+	/**
+	 * @brief Get size of the socket send buffer.
+	 * @return buffer size in bytes.
+	 */
+	size_t GetSendBufferSize();
+
+
+
+	/**
+	 * @brief Set size of the socket receive buffer.
+	 * @param size - buffer size in bytes. Note, that Linux doubles the value to allow space for bookkeeping.
+	 * @throw net::Exc - if socket is not opened or on error.
+	 */
+	void SetRecvBufferSize(size_t size);
+
+
+
+	/**
+	 * @brief Get size of the socket receive buffer.
+	 * @return buffer size in bytes.
+	 */
+	size_t GetRecvBufferSize();
+
+
+
+	/**
+	 * @brief Enable or disable TCP keep-alive.
+	 * See SocketOptions for description of the parameters, zero timing values leave system defaults.
+	 * @param enable - whether to send keep-alive probes.
+	 * @param idle - idle time in seconds before the first probe.
+	 * @param interval - interval in seconds between probes.
+	 * @param count - number of unanswered probes after which the connection is dropped.
+	 * @throw net::Exc - if socket is not opened or on error.
+	 */
+	void SetKeepAlive(bool enable, unsigned idle = 0, unsigned interval = 0, unsigned count = 0);
+
+
+
+	/**
+	 * @brief Set linger timeout.
+	 * See SocketOptions::lingerTimeout for details.
+	 * @param timeout - timeout in seconds, negative value disables lingering.
+	 * @throw net::Exc - if socket is not opened or on error.
+	 */
+	void SetLinger(int timeout);
+
+
+
+	/**
+	 * @brief Set busy polling time.
+	 * See SocketOptions::busyPoll for details. Linux only.
+	 * @param microseconds - busy polling time, 0 disables busy polling.
+	 * @throw net::Exc - if socket is not opened, on error, or if not supported by OS.
+	 */
+	void SetBusyPoll(unsigned microseconds);
+
+
+
 #if M_OS == M_OS_WINDOWS
 private:
 	//override
@@ -0,0 +1,108 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "TCPListenerGroup.hpp"
+
+#include <sstream>
+#include <cstring>
+
+#if M_OS == M_OS_LINUX
+#	include <linux/filter.h>
+#endif
+
+
+#if M_OS == M_OS_LINUX
+#	ifndef SO_ATTACH_REUSEPORT_CBPF
+#		define SO_ATTACH_REUSEPORT_CBPF 51
+#	endif
+#endif
+
+
+
+using namespace ting::net;
+
+
+
+void TCPListenerGroup::Open(std::uint16_t port, size_t numListeners, bool steerByCpu, bool disableNaggle, std::uint16_t queueLength){
+	if(this->listeners.size() != 0){
+		throw net::Exc("TCPListenerGroup::Open(): group already opened");
+	}
+	
+	if(numListeners == 0){
+		throw net::Exc("TCPListenerGroup::Open(): number of listeners must be greater than 0");
+	}
+	
+	SocketOptions options;
+	options.disableNaggle = disableNaggle;
+	
+	try{
+		this->listeners.resize(numListeners);
+		
+		//the order of opening determines the index of the listener within the OS reuseport group
+		for(auto& l : this->listeners){
+			l.Open(port, options, queueLength, true);
+			if(port == 0){
+				port = l.GetLocalPort();
+			}
+		}
+		
+		if(steerByCpu){
+			this->AttachCpuSteering();
+		}
+	}catch(...){
+		this->Close();
+		throw;
+	}
+}
+
+
+
+void TCPListenerGroup::AttachCpuSteering(){
+	ASSERT(this->listeners.size() != 0)
+	
+#if M_OS == M_OS_LINUX
+	//classic BPF program which returns the number of current CPU as index of the socket in the group
+	sock_filter code[] = {
+		{BPF_LD | BPF_W | BPF_ABS, 0, 0, std::uint32_t(SKF_AD_OFF + SKF_AD_CPU)},
+		{BPF_RET | BPF_A, 0, 0, 0}
+	};
+	
+	sock_fprog prog;
+	prog.len = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+	
+	//the program is attached to the whole group, so it is enough to attach it to one of the sockets
+	TCPServerSocket& s = this->listeners.front();
+	if(setsockopt(s.socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0){
+		int errorCode = errno;
+		std::stringstream ss;
+		ss << "TCPListenerGroup::Open(): attaching CPU steering program failed, error code = " << errorCode << ": " << strerror(errorCode);
+		throw net::Exc(ss.str());
+	}
+#else
+	throw net::Exc("TCPListenerGroup::Open(): steering connections by CPU is not supported on this OS");
+#endif
+}
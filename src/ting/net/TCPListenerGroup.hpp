@@ -0,0 +1,153 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include <vector>
+
+#include "TCPServerSocket.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Group of TCP server sockets listening on the same port.
+ * All the sockets of the group are opened with SO_REUSEPORT option, so that the OS
+ * distributes incoming connections among them. This allows accepting connections on
+ * several CPU cores in parallel, each listener is supposed to be added to its own WaitSet
+ * which is served by its own thread, thus, there is no contention on a single accept queue.
+ * Listeners of the group can also be used from one thread, in that case the group just
+ * provides several accept queues.
+ *
+ * On Linux the incoming connections are distributed by the hash of connection addresses
+ * by default. Optionally, the connections can be steered to the listener by the number
+ * of CPU which has processed the incoming SYN packet, i.e. connection is accepted by the
+ * listener whose index in the group is equal to that CPU number. Combined with pinning
+ * the thread serving the listener to the corresponding CPU (see ting::mt::Thread::StartOptions)
+ * and with distributing the NIC receive queue interrupts across the CPUs, this keeps
+ * all the processing of a connection on one CPU core.
+ *
+ * On Mac OS X the port can be shared, but the connections are not load-balanced among the listeners.
+ * Not supported on Windows.
+ */
+class TCPListenerGroup{
+	std::vector<TCPServerSocket> listeners;
+	
+	void AttachCpuSteering();
+	
+public:
+	TCPListenerGroup(){}
+	
+	TCPListenerGroup(const TCPListenerGroup&) = delete;
+	TCPListenerGroup& operator=(const TCPListenerGroup&) = delete;
+	
+	TCPListenerGroup(TCPListenerGroup&& g) :
+			listeners(std::move(g.listeners))
+	{}
+	
+	TCPListenerGroup& operator=(TCPListenerGroup&& g){
+		this->listeners = std::move(g.listeners);
+		return *this;
+	}
+	
+	/**
+	 * @brief Open all the listeners of the group.
+	 * @param port - IP port number to listen on. If 0 then the port is chosen by OS
+	 *               when opening the first listener and the rest of listeners use the same port.
+	 * @param numListeners - number of listeners in the group, must be greater than 0.
+	 * @param steerByCpu - if true, connections are accepted by the listener whose index is equal to the
+	 *                     number of CPU which has received the connection. Connections received by CPUs
+	 *                     with numbers greater or equal to numListeners are distributed by hash.
+	 *                     Supported only on Linux.
+	 * @param disableNaggle - disable Naggle algorithm for all accepted sockets.
+	 * @param queueLength - the maximum length of the queue of pending connections of each listener.
+	 * @throw net::Exc - if the group is already opened or in case of any error,
+	 *                   in that case all the listeners which were opened are closed.
+	 */
+	void Open(std::uint16_t port, size_t numListeners, bool steerByCpu = false, bool disableNaggle = false, std::uint16_t queueLength = 50);
+	
+	/**
+	 * @brief Close all the listeners of the group.
+	 * Listeners must be removed from WaitSets before closing.
+	 */
+	void Close()NOEXCEPT{
+		this->listeners.clear();
+	}
+	
+	/**
+	 * @brief Check if the group is opened.
+	 * @return true if the group is opened.
+	 */
+	explicit operator bool()const NOEXCEPT{
+		return this->listeners.size() != 0;
+	}
+	
+	/**
+	 * @brief Get number of listeners in the group.
+	 * @return number of listeners, 0 if group is not opened.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->listeners.size();
+	}
+	
+	/**
+	 * @brief Get listener.
+	 * Listener can be used as any other TCP server socket, e.g. added to a WaitSet and
+	 * accepted connections from, but it should not be closed or re-opened by user.
+	 * @param i - index of the listener in the group.
+	 * @return reference to the listener.
+	 */
+	TCPServerSocket& operator[](size_t i)NOEXCEPT{
+		ASSERT(i < this->listeners.size())
+		return this->listeners[i];
+	}
+	
+	/**
+	 * @brief Get local port the group is listening on.
+	 * @return port number.
+	 * @throw net::Exc - if the group is not opened.
+	 */
+	std::uint16_t GetLocalPort(){
+		if(this->listeners.size() == 0){
+			throw net::Exc("TCPListenerGroup::GetLocalPort(): group is not opened");
+		}
+		return this->listeners.front().GetLocalPort();
+	}
+};//~class TCPListenerGroup
+
+
+
+}//~namespace
+}//~namespace
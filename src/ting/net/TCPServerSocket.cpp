@@ -28,6 +28,13 @@ THE SOFTWARE. */
 
 #if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
 #	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#endif
+
+#if M_OS == M_OS_LINUX
+#	ifndef TCP_FASTOPEN
+#		define TCP_FASTOPEN 23
+#	endif
 #endif
 
 
@@ -35,12 +42,12 @@ using namespace ting::net;
 
 
 
-void TCPServerSocket::Open(std::uint16_t port, bool disableNaggle, std::uint16_t queueLength){
+void TCPServerSocket::Open(std::uint16_t port, const SocketOptions& options, std::uint16_t queueLength, bool reusePort){
 	if(*this){
 		throw net::Exc("TCPServerSocket::Open(): socket already opened");
 	}
 
-	this->disableNaggle = disableNaggle;
+	this->disableNaggle = options.disableNaggle;
 
 #if M_OS == M_OS_WINDOWS
 	this->CreateEventForWaitable();
@@ -104,6 +111,21 @@ void TCPServerSocket::Open(std::uint16_t port, bool disableNaggle, std::uint16_t
 		setsockopt(this->socket, SOL_SOCKET, SO_REUSEADDR, (char*)&yes, sizeof(yes));
 	}
 
+	// allow several sockets to listen on the same port
+	if(reusePort){
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+		int yes = 1;
+		if(setsockopt(this->socket, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) != 0){
+			int errorCode = GetLastErrorCode();
+			this->Close();
+			ThrowError("TCPServerSocket::Open(): setting SO_REUSEPORT failed", errorCode);
+		}
+#else
+		this->Close();
+		throw net::Exc("TCPServerSocket::Open(): port reusing is not supported on this OS");
+#endif
+	}
+
 	sockaddr_storage sockAddr;
 	socklen_t sockAddrLen;
 	
@@ -155,6 +177,29 @@ void TCPServerSocket::Open(std::uint16_t port, bool disableNaggle, std::uint16_t
 		throw net::Exc(ss.str());
 	}
 
+	//apply options before listening, accepted sockets inherit them from the listening socket
+	try{
+		SocketOptions listenerOptions = options;
+		
+		//On Linux accepted sockets inherit TCP_NODELAY option from listening socket, no need to set it on every accepted socket
+#if M_OS != M_OS_LINUX
+		listenerOptions.disableNaggle = false;
+#endif
+		this->ApplyOptions(listenerOptions);
+		
+		if(options.fastOpen){
+#if M_OS == M_OS_LINUX
+			//option value is the maximum length of the queue of pending TCP Fast Open requests
+			this->SetOption(IPPROTO_TCP, TCP_FASTOPEN, int(queueLength), "TCPServerSocket::Open(): setting TCP_FASTOPEN failed");
+#else
+			throw net::Exc("TCPServerSocket::Open(): TCP Fast Open is not supported on this OS");
+#endif
+		}
+	}catch(...){
+		this->Close();
+		throw;
+	}
+
 	if(listen(this->socket, int(queueLength)) == DSocketError()){
 		this->Close();
 		throw net::Exc("TCPServerSocket::Open(): Couldn't listen to local port");
@@ -165,12 +210,8 @@ void TCPServerSocket::Open(std::uint16_t port, bool disableNaggle, std::uint16_t
 
 
 
-TCPSocket TCPServerSocket::Accept(){
-	if(!*this){
-		throw net::Exc("TCPServerSocket::Accept(): the socket is not opened");
-	}
-
-	this->ClearCanReadFlag();
+bool TCPServerSocket::AcceptTo(TCPSocket& sock, int& out_ErrorCode){
+	sock.Close();
 
 	sockaddr_storage sockAddr;
 
@@ -182,18 +223,42 @@ TCPSocket TCPServerSocket::Accept(){
 #	error "Unsupported OS"
 #endif
 
-	TCPSocket sock;//allocate a new socket object
-
+#if M_OS == M_OS_LINUX
+	//create the socket in non-blocking mode right away, saves system calls
+	while(true){
+		sock.socket = ::accept4(
+				this->socket,
+				reinterpret_cast<sockaddr*>(&sockAddr),
+				&sock_alen,
+				SOCK_NONBLOCK | SOCK_CLOEXEC
+			);
+		if(sock.socket == DInvalidSocket() && errno == EINTR){
+			continue;
+		}
+		break;
+	}
+#else
 	sock.socket = ::accept(
 			this->socket,
 			reinterpret_cast<sockaddr*>(&sockAddr),
 			&sock_alen
 		);
+#endif
 
 	if(sock.socket == DInvalidSocket()){
-		return sock;//no connections to be accepted, return invalid socket
+		int errorCode = GetLastErrorCode();
+		out_ErrorCode = errorCode == DEAgain() ? 0 : errorCode;
+		return false;//no connections to be accepted
 	}
 
+	out_ErrorCode = 0;
+
+	//the socket object may be reused, zero-copy send IDs start from 0 for every new connection
+	sock.nextZeroCopyId = 0;
+	sock.zeroCopyEnabled = false;
+	sock.connectError = 0;
+	sock.connectDeferred = false;
+
 #if M_OS == M_OS_WINDOWS
 	sock.CreateEventForWaitable();
 
@@ -202,13 +267,65 @@ TCPSocket TCPServerSocket::Accept(){
 	sock.SetWaitingEvents(0);
 #endif
 
+#if M_OS != M_OS_LINUX
 	sock.SetNonBlockingMode();
 
 	if(this->disableNaggle){
 		sock.DisableNaggle();
 	}
+#endif
+
+	return true;
+}
+
+
+
+TCPSocket TCPServerSocket::Accept(){
+	if(!*this){
+		throw net::Exc("TCPServerSocket::Accept(): the socket is not opened");
+	}
+
+	int errorCode;
+	return this->Accept(errorCode);//return a newly created socket or invalid socket if there were no connections to be accepted
+}
+
+
+
+TCPSocket TCPServerSocket::Accept(int& out_ErrorCode){
+	this->ClearCanReadFlag();
+
+	TCPSocket sock;//allocate a new socket object
+
+	this->AcceptTo(sock, out_ErrorCode);
+
+	return sock;
+}
+
+
+
+size_t TCPServerSocket::AcceptMany(ting::Buffer<TCPSocket> sockets){
+	if(!*this){
+		throw net::Exc("TCPServerSocket::AcceptMany(): the socket is not opened");
+	}
 
-	return sock;//return a newly created socket
+	int errorCode;
+	return this->AcceptMany(sockets, errorCode);
+}
+
+
+
+size_t TCPServerSocket::AcceptMany(ting::Buffer<TCPSocket> sockets, int& out_ErrorCode){
+	this->ClearCanReadFlag();
+
+	out_ErrorCode = 0;
+
+	size_t num = 0;
+	for(; num != sockets.size(); ++num){
+		if(!this->AcceptTo(sockets[num], out_ErrorCode)){
+			break;
+		}
+	}
+	return num;
 }
 
 
@@ -45,13 +45,23 @@ namespace net{
 
 
 
+//forward declarations
+class TCPListenerGroup;
+
+
+
 /**
  * @brief a class which represents a TCP server socket.
  * TCP server socket is the socket which can listen for new connections
  * and accept them creating an ordinary TCP socket for it.
  */
 class TCPServerSocket : public Socket{
+	friend class TCPListenerGroup;
+	
 	bool disableNaggle = false;//this flag indicates if accepted sockets should be created with disabled Naggle
+
+	//returns false if there are no pending connections or in case of error, in the latter case error code is non-zero
+	bool AcceptTo(TCPSocket& sock, int& out_ErrorCode);
 public:
 	/**
 	 * @brief Creates an invalid (unopened) TCP server socket.
@@ -87,7 +97,34 @@ public:
 	 * @param disableNaggle - enable/disable Naggle algorithm for all accepted connections.
 	 * @param queueLength - the maximum length of the queue of pending connections.
 	 */
-	void Open(std::uint16_t port, bool disableNaggle = false, std::uint16_t queueLength = 50);
+	void Open(std::uint16_t port, bool disableNaggle = false, std::uint16_t queueLength = 50){
+		SocketOptions options;
+		options.disableNaggle = disableNaggle;
+		this->Open(port, options, queueLength);
+	}
+
+
+
+	/**
+	 * @brief Connects the socket or starts listening on it, with given options.
+	 * Same as Open(std::uint16_t, bool, std::uint16_t), but allows specifying socket options
+	 * which are applied before starting to listen. The options are inherited by accepted sockets.
+	 * If SocketOptions::fastOpen is set, then queueLength is also used as maximum length of the queue
+	 * of pending TCP Fast Open requests.
+	 * @param port - IP port number to listen on.
+	 * @param options - socket options.
+	 * @param queueLength - the maximum length of the queue of pending connections.
+	 * @throw net::Exc - in case of any error, including failure to apply some option.
+	 */
+	void Open(std::uint16_t port, const SocketOptions& options, std::uint16_t queueLength = 50){
+		this->Open(port, options, queueLength, false);
+	}
+
+private:
+	//reusePort - whether to allow several sockets to listen on the same port
+	void Open(std::uint16_t port, const SocketOptions& options, std::uint16_t queueLength, bool reusePort);
+
+public:
 	
 	
 	
@@ -106,6 +143,47 @@ public:
 
 
 
+	/**
+	 * @brief Accepts one of the pending connections, with error reporting.
+	 * Same as Accept(), but also reports the error code of failed accept() call, e.g.
+	 * when the process has run out of file descriptors, so that the caller could react to it.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error, including the case of no pending connections.
+	 * @return accepted socket, or invalid socket if no connection was accepted.
+	 */
+	TCPSocket Accept(int& out_ErrorCode);
+
+
+
+	/**
+	 * @brief Accepts pending connections, non-blocking.
+	 * Accepts as many pending connections as there are sockets in the given buffer.
+	 * This allows draining the queue of pending connections after just one
+	 * notification from WaitSet, which is useful when connections come at high rate.
+	 * @param sockets - buffer of socket objects to store accepted connections to.
+	 *                  Sockets in the buffer which were valid before the call are closed.
+	 * @return number of accepted connections. Accepted sockets are stored in
+	 *         the first entries of the given buffer. Returns 0 if there are no pending connections.
+	 */
+	size_t AcceptMany(ting::Buffer<TCPSocket> sockets);
+
+
+
+	/**
+	 * @brief Accepts pending connections, with error reporting.
+	 * Same as AcceptMany(), but also reports the error code of the failed accept() call which
+	 * stopped accepting, e.g. when the process has run out of file descriptors. In such case the
+	 * pending connections remain in the queue and the socket stays ready for reading, so the caller
+	 * has to react to the error instead of waiting for the socket again right away.
+	 * @param sockets - buffer of socket objects to store accepted connections to.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error, including the case of no more pending connections.
+	 * @return number of accepted connections, the connections accepted before the error are counted too.
+	 */
+	size_t AcceptMany(ting::Buffer<TCPSocket> sockets, int& out_ErrorCode);
+
+
+
 #if M_OS == M_OS_WINDOWS
 private:
 	void SetWaitingEvents(std::uint32_t flagsToWaitFor)override;
@@ -26,9 +26,42 @@ THE SOFTWARE. */
 
 #include "TCPSocket.hpp"
 #include "../util.hpp"
+#include "../fs/FSFile.hpp"
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <algorithm>
 
 #if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
 #	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <sys/uio.h>
+#endif
+
+#if M_OS == M_OS_LINUX
+#	include <sys/sendfile.h>
+#	include <linux/errqueue.h>
+
+//older system headers may lack these definitions
+#	ifndef SO_ZEROCOPY
+#		define SO_ZEROCOPY 60
+#	endif
+#	ifndef MSG_ZEROCOPY
+#		define MSG_ZEROCOPY 0x4000000
+#	endif
+#	ifndef SO_EE_ORIGIN_ZEROCOPY
+#		define SO_EE_ORIGIN_ZEROCOPY 5
+#	endif
+#	ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#		define SO_EE_CODE_ZEROCOPY_COPIED 1
+#	endif
+#	ifndef TCP_FASTOPEN_CONNECT
+#		define TCP_FASTOPEN_CONNECT 30
+#	endif
+#	ifndef TCP_NOTSENT_LOWAT
+#		define TCP_NOTSENT_LOWAT 25
+#	endif
 #endif
 
 
@@ -37,7 +70,7 @@ using namespace ting::net;
 
 
 
-void TCPSocket::Open(const IPAddress& ip, bool disableNaggle){
+void TCPSocket::Open(const IPAddress& ip, const SocketOptions& options){
 	if(*this){
 		throw net::Exc("TCPSocket::Open(): socket already opened");
 	}
@@ -59,15 +92,32 @@ void TCPSocket::Open(const IPAddress& ip, bool disableNaggle){
 		throw net::Exc("TCPSocket::Open(): Couldn't create socket");
 	}
 
-	//Disable Naggle algorithm if required
-	if(disableNaggle){
-		this->DisableNaggle();
+	//apply options before connecting
+	try{
+		this->ApplyOptions(options);
+		
+		if(options.fastOpen){
+#if M_OS == M_OS_LINUX
+			//connect() returns immediately and the SYN is sent along with the first data
+			this->SetOption(IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1, "TCPSocket::Open(): setting TCP_FASTOPEN_CONNECT failed");
+#else
+			throw net::Exc("TCPSocket::Open(): TCP Fast Open is not supported on this OS");
+#endif
+		}
+	}catch(...){
+		this->Close();
+		throw;
 	}
 
 	this->SetNonBlockingMode();
 
 	this->ClearAllReadinessFlags();
 
+	this->nextZeroCopyId = 0;
+	this->zeroCopyEnabled = false;
+	this->connectError = 0;
+	this->connectDeferred = false;
+
 	//Connecting to remote host
 	sockaddr_storage sockAddr;
 	
@@ -143,64 +193,262 @@ void TCPSocket::Open(const IPAddress& ip, bool disableNaggle){
 			this->Close();
 			throw net::Exc(ss.str());
 		}
+	}else if(options.fastOpen){
+		this->connectDeferred = true;
 	}
 }
 
 
 
-size_t TCPSocket::Send(ting::Buffer<const std::uint8_t> buf){
+TCPSocket::E_ConnectState TCPSocket::CheckConnect(int& out_ErrorCode){
 	if(!*this){
-		throw net::Exc("TCPSocket::Send(): socket is not opened");
+		throw net::Exc("TCPSocket::CheckConnect(): socket is not opened");
 	}
 
-	this->ClearCanWriteFlag();
+	if(this->connectError != 0){
+		out_ErrorCode = this->connectError;
+		return FAILED;
+	}
+
+	//pending error of the socket is the result of failed non-blocking connection attempt
+	out_ErrorCode = this->GetOption(SOL_SOCKET, SO_ERROR, "TCPSocket::CheckConnect(): getsockopt(SO_ERROR) failed");
+	if(out_ErrorCode != 0){
+		this->connectError = out_ErrorCode;
+		return FAILED;
+	}
 
+	sockaddr_storage sockAddr;
 #if M_OS == M_OS_WINDOWS
-	int len;
+	int sockAddrLen = sizeof(sockAddr);
+	const int notConnected = WSAENOTCONN;
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	socklen_t sockAddrLen = sizeof(sockAddr);
+	const int notConnected = ENOTCONN;
 #else
-	ssize_t len;
+#	error "Unsupported OS"
 #endif
 
+	//peer address is only available when the socket is connected
+	if(getpeername(this->socket, reinterpret_cast<sockaddr*>(&sockAddr), &sockAddrLen) == 0){
+		return CONNECTED;
+	}
+
+	int errorCode = GetLastErrorCode();
+	if(errorCode == notConnected){
+		//deferred connection is established by first send, it cannot be waited for
+		return this->connectDeferred ? CONNECTED : CONNECTING;
+	}
+
+	this->connectError = errorCode;
+	out_ErrorCode = errorCode;
+	return FAILED;
+}
+
+
+
+TCPSocket::E_ConnectState TCPSocket::WaitForConnect(std::uint32_t timeoutMillis, int& out_ErrorCode){
+	if(!*this){
+		throw net::Exc("TCPSocket::WaitForConnect(): socket is not opened");
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(*this, Waitable::WRITE);
+
+	E_ConnectState ret;
+	for(;;){
+		ret = this->CheckConnect(out_ErrorCode);
+		if(ret != CONNECTING){
+			break;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if(now >= deadline){
+			break;
+		}
+
+		//round up to not wake up before the deadline
+		auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+		waitSet.WaitWithTimeout(std::uint32_t(timeout));
+	}
+
+	waitSet.Remove(*this);
+	return ret;
+}
+
+
+
+TCPSocket TCPSocket::ConnectHappyEyeballs(
+		ting::Buffer<const IPAddress> addresses,
+		std::uint32_t timeoutMillis,
+		std::uint32_t attemptDelayMillis,
+		const SocketOptions& options
+	)
+{
+	//interleave address families, starting with IPv6
+	std::vector<const IPAddress*> order;
+	{
+		std::vector<const IPAddress*> v6, v4;
+		for(auto& a : addresses){
+			(a.host.IsIPv4() ? v4 : v6).push_back(&a);
+		}
+		for(size_t i = 0; i != std::max(v4.size(), v6.size()); ++i){
+			if(i < v6.size()){
+				order.push_back(v6[i]);
+			}
+			if(i < v4.size()){
+				order.push_back(v4[i]);
+			}
+		}
+	}
+
+	if(order.size() == 0){
+		throw net::Exc("TCPSocket::ConnectHappyEyeballs(): no addresses given");
+	}
+
+	typedef std::chrono::steady_clock T_Clock;
+
+	auto deadline = T_Clock::now() + std::chrono::milliseconds(timeoutMillis);
+	auto nextAttemptTime = T_Clock::now();
+
+	//sockets are added to the WaitSet, so the vector must not be reallocated
+	std::vector<TCPSocket> attempts(order.size());
+	ting::WaitSet waitSet(unsigned(attempts.size()));
+
+	//only opened sockets are added to the WaitSet
+	auto removeAll = [&attempts, &waitSet](){
+		for(auto& s : attempts){
+			if(s){
+				waitSet.Remove(s);
+			}
+		}
+	};
+
+	size_t numStarted = 0;
+	size_t numActive = 0;
+	int lastErrorCode = 0;
+
+	for(;;){
+		auto now = T_Clock::now();
+		if(now >= deadline){
+			break;
+		}
+
+		if(numStarted != attempts.size() && (now >= nextAttemptTime || numActive == 0)){
+			TCPSocket& s = attempts[numStarted];
+			try{
+				s.Open(*order[numStarted], options);
+				waitSet.Add(s, Waitable::WRITE);
+				++numActive;
+			}catch(ting::net::Exc&){
+				//connecting failed right away, e.g. network is unreachable, proceed to next address
+				s.Close();
+			}
+			++numStarted;
+			nextAttemptTime = now + std::chrono::milliseconds(attemptDelayMillis);
+			continue;
+		}
+
+		if(numActive == 0){
+			break;//all attempts have failed
+		}
+
+		auto waitUntil = numStarted == attempts.size() ? deadline : std::min(deadline, nextAttemptTime);
+		auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(waitUntil - now).count() + 1;
+		waitSet.WaitWithTimeout(std::uint32_t(timeout));
+
+		for(auto& s : attempts){
+			if(!s || !(s.CanWrite() || s.ErrorCondition())){
+				continue;
+			}
+
+			int errorCode;
+			switch(s.CheckConnect(errorCode)){
+				case CONNECTED:
+					removeAll();
+					return std::move(s);
+				case FAILED:
+					waitSet.Remove(s);
+					s.Close();
+					--numActive;
+					lastErrorCode = errorCode;
+					nextAttemptTime = T_Clock::now();//start next attempt right away
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	removeAll();
+
+	if(lastErrorCode != 0){
+		ThrowError("TCPSocket::ConnectHappyEyeballs(): all connection attempts failed", lastErrorCode);
+	}
+	throw net::Exc("TCPSocket::ConnectHappyEyeballs(): could not connect within timeout");
+}
+
+
+
+namespace{
+
+int SendFlags(bool more)NOEXCEPT{
+#if M_OS == M_OS_LINUX
+	return more ? MSG_MORE : 0;
+#else
+	return 0;
+#endif
+}
+
+}//~namespace
+
+
+
+size_t TCPSocket::Send(ting::Buffer<const std::uint8_t> buf, bool more){
+	if(!*this){
+		throw net::Exc("TCPSocket::Send(): socket is not opened");
+	}
+
+	int errorCode;
+	size_t ret = this->Send(buf, more, errorCode);
+	if(errorCode != 0){
+		ThrowError("TCPSocket::Send(): send() failed", errorCode);
+	}
+	return ret;
+}
+
+
+
+size_t TCPSocket::Send(ting::Buffer<const std::uint8_t> buf, bool more, int& out_ErrorCode)NOEXCEPT{
+	this->ClearCanWriteFlag();
+
 	while(true){
+#if M_OS == M_OS_WINDOWS
+		int len;
+#else
+		ssize_t len;
+#endif
 		len = send(
 				this->socket,
 				reinterpret_cast<const char*>(&*buf.begin()),
 				buf.size(),
-				0
+				SendFlags(more)
 			);
 		if(len == DSocketError()){
-#if M_OS == M_OS_WINDOWS
-			int errorCode = WSAGetLastError();
-#else
-			int errorCode = errno;
-#endif
+			int errorCode = GetLastErrorCode();
 			if(errorCode == DEIntr()){
 				continue;
-			}else if(errorCode == DEAgain()){
-				//can't send more bytes, return 0 bytes sent
-				len = 0;
-			}else{
-				std::stringstream ss;
-				ss << "TCPSocket::Send(): send() failed, error code = " << errorCode << ": ";
-#if M_COMPILER == M_COMPILER_MSVC
-				{
-					const size_t msgbufSize = 0xff;
-					char msgbuf[msgbufSize];
-					strerror_s(msgbuf, msgbufSize, errorCode);
-					msgbuf[msgbufSize - 1] = 0;//make sure the string is null-terminated
-					ss << msgbuf;
-				}
-#else
-				ss << strerror(errorCode);
-#endif
-				throw net::Exc(ss.str());
 			}
+			//if can't send more bytes, then it is not an error, return 0 bytes sent
+			out_ErrorCode = errorCode == DEAgain() ? 0 : errorCode;
+			return 0;
 		}
-		break;
-	}//~while
 
-	ASSERT(len >= 0)
-	return size_t(len);
+		ASSERT(len >= 0)
+		out_ErrorCode = 0;
+		return size_t(len);
+	}//~while
 }
 
 
@@ -215,13 +463,26 @@ size_t TCPSocket::Recv(ting::Buffer<std::uint8_t> buf){
 		throw net::Exc("TCPSocket::Recv(): socket is not opened");
 	}
 
+	int errorCode;
+	size_t ret = this->Recv(buf, errorCode);
+	if(errorCode != 0){
+		ThrowError("TCPSocket::Recv(): recv() failed", errorCode);
+	}
+	return ret;
+}
+
+
+
+size_t TCPSocket::Recv(ting::Buffer<std::uint8_t> buf, int& out_ErrorCode)NOEXCEPT{
+	//the 'can read' flag shall be cleared even if this function fails, see throwing version of Recv().
+	this->ClearCanReadFlag();
+
+	while(true){
 #if M_OS == M_OS_WINDOWS
-	int len;
+		int len;
 #else
-	ssize_t len;
+		ssize_t len;
 #endif
-
-	while(true){
 		len = recv(
 				this->socket,
 				reinterpret_cast<char*>(&*buf.begin()),
@@ -229,39 +490,371 @@ size_t TCPSocket::Recv(ting::Buffer<std::uint8_t> buf){
 				0
 			);
 		if(len == DSocketError()){
+			int errorCode = GetLastErrorCode();
+			if(errorCode == DEIntr()){
+				continue;
+			}
+			//if no data available, then it is not an error, return 0 bytes received
+			out_ErrorCode = errorCode == DEAgain() ? 0 : errorCode;
+			return 0;
+		}
+
+		ASSERT(len >= 0)
+		out_ErrorCode = 0;
+		return size_t(len);
+	}//~while
+}
+
+
+
+namespace{
+
+#if M_OS == M_OS_WINDOWS
+typedef WSABUF T_IOVec;
+
+template <class T> T_IOVec MakeIOVec(ting::Buffer<T> buf){
+	WSABUF ret;
+	ret.buf = const_cast<char*>(reinterpret_cast<const char*>(&*buf.begin()));
+	ret.len = ULONG(buf.size());
+	return ret;
+}
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+typedef iovec T_IOVec;
+
+template <class T> T_IOVec MakeIOVec(ting::Buffer<T> buf){
+	iovec ret;
+	ret.iov_base = const_cast<void*>(reinterpret_cast<const void*>(&*buf.begin()));
+	ret.iov_len = buf.size();
+	return ret;
+}
+#else
+#	error "Unsupported OS"
+#endif
+
+
+
+//fills array of I/O vectors from given buffers, empty buffers are skipped, returns number of filled I/O vectors
+template <class T> size_t FillIOVecs(std::array<T_IOVec, TCPSocket::DMaxNumBuffers()>& iovecs, ting::Buffer<const ting::Buffer<T>> bufs){
+	size_t num = 0;
+	for(auto& b : bufs){
+		if(b.size() == 0){
+			continue;
+		}
+		if(num == iovecs.size()){
+			break;
+		}
+		iovecs[num] = MakeIOVec(b);
+		++num;
+	}
+	return num;
+}
+
+}//~namespace
+
+
+
+size_t TCPSocket::Send(ting::Buffer<const ting::Buffer<const std::uint8_t>> bufs, bool more){
+	if(!*this){
+		throw net::Exc("TCPSocket::Send(): socket is not opened");
+	}
+
+	this->ClearCanWriteFlag();
+
+	std::array<T_IOVec, DMaxNumBuffers()> iovecs;
+	size_t numIOVecs = FillIOVecs(iovecs, bufs);
+	if(numIOVecs == 0){
+		return 0;
+	}
+
+	while(true){
 #if M_OS == M_OS_WINDOWS
-			int errorCode = WSAGetLastError();
+		DWORD numBytesSent;
+		if(WSASend(this->socket, &*iovecs.begin(), DWORD(numIOVecs), &numBytesSent, 0, NULL, NULL) == 0){
+			return size_t(numBytesSent);
+		}
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &*iovecs.begin();
+		msg.msg_iovlen = numIOVecs;
+
+		ssize_t len = sendmsg(this->socket, &msg, SendFlags(more));
+		if(len >= 0){
+			return size_t(len);
+		}
 #else
-			int errorCode = errno;
+#	error "Unsupported OS"
 #endif
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//can't send more bytes, return 0 bytes sent
+			return 0;
+		}
+		ThrowError("TCPSocket::Send(): sending of buffers failed", errorCode);
+	}//~while
+}
+
+
 
+size_t TCPSocket::Recv(ting::Buffer<const ting::Buffer<std::uint8_t>> bufs){
+	//the 'can read' flag shall be cleared even if this function fails, see single buffer version of Recv().
+	this->ClearCanReadFlag();
+
+	if(!*this){
+		throw net::Exc("TCPSocket::Recv(): socket is not opened");
+	}
+
+	std::array<T_IOVec, DMaxNumBuffers()> iovecs;
+	size_t numIOVecs = FillIOVecs(iovecs, bufs);
+	if(numIOVecs == 0){
+		return 0;
+	}
+
+	while(true){
+#if M_OS == M_OS_WINDOWS
+		DWORD numBytesReceived;
+		DWORD flags = 0;
+		if(WSARecv(this->socket, &*iovecs.begin(), DWORD(numIOVecs), &numBytesReceived, &flags, NULL, NULL) == 0){
+			return size_t(numBytesReceived);
+		}
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &*iovecs.begin();
+		msg.msg_iovlen = numIOVecs;
+
+		ssize_t len = recvmsg(this->socket, &msg, 0);
+		if(len >= 0){
+			return size_t(len);
+		}
+#else
+#	error "Unsupported OS"
+#endif
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//no data available, return 0 bytes received
+			return 0;
+		}
+		ThrowError("TCPSocket::Recv(): receiving to buffers failed", errorCode);
+	}//~while
+}
+
+
+
+size_t TCPSocket::SendFile(const ting::fs::File& file, size_t offset, size_t length){
+	if(!*this){
+		throw net::Exc("TCPSocket::SendFile(): socket is not opened");
+	}
+	if(!file.IsOpened()){
+		throw ting::fs::File::IllegalStateExc("TCPSocket::SendFile(): file is not opened");
+	}
+
+	if(length == 0){
+		return 0;
+	}
+
+#if M_OS == M_OS_LINUX
+	if(auto fsFile = dynamic_cast<const ting::fs::FSFile*>(&file)){
+		this->ClearCanWriteFlag();
+
+		int fd = fsFile->GetDescriptor();
+
+		while(true){
+			off_t off = off_t(offset);
+			ssize_t res = sendfile(this->socket, fd, &off, length);
+			if(res >= 0){
+				return size_t(res);
+			}
+
+			int errorCode = GetLastErrorCode();
 			if(errorCode == DEIntr()){
 				continue;
 			}else if(errorCode == DEAgain()){
-				//no data available, return 0 bytes received
-				len = 0;
-			}else{
-				std::stringstream ss;
-				ss << "TCPSocket::Recv(): recv() failed, error code = " << errorCode << ": ";
-#if M_COMPILER == M_COMPILER_MSVC
-				{
-					const size_t msgbufSize = 0xff;
-					char msgbuf[msgbufSize];
-					strerror_s(msgbuf, msgbufSize, errorCode);
-					msgbuf[msgbufSize - 1] = 0;//make sure the string is null-terminated
-					ss << msgbuf;
-				}
+				//can't send more bytes, return 0 bytes sent
+				return 0;
+			}else if(errorCode == EINVAL || errorCode == ENOSYS){
+				//file does not support sendfile(), fall back to copying through user space buffer
+				break;
+			}
+			ThrowError("TCPSocket::SendFile(): sendfile() failed", errorCode);
+		}//~while
+	}
+#endif
+
+	//position the file at the offset
+	if(file.CurPos() > offset){
+		file.Rewind();
+	}
+	size_t numBytesToSkip = offset - file.CurPos();
+	if(file.SeekForward(numBytesToSkip) != numBytesToSkip){
+		return 0;//offset is beyond the end of file
+	}
+	ASSERT(file.CurPos() == offset)
+
+	std::array<std::uint8_t, 0x4000> buf; //16kb
+
+	size_t numBytesSent = 0;
+	while(numBytesSent != length){
+		size_t numBytesRead = file.Read(ting::Buffer<std::uint8_t>(&*buf.begin(), std::min(buf.size(), length - numBytesSent)));
+		if(numBytesRead == 0){
+			break;//end of file
+		}
+
+		size_t res = this->Send(ting::Buffer<const std::uint8_t>(&*buf.begin(), numBytesRead));
+		numBytesSent += res;
+		if(res != numBytesRead){
+			break;//socket cannot accept more data
+		}
+	}
+
+	return numBytesSent;
+}
+
+
+
+void TCPSocket::SetCork(bool cork){
+#if M_OS == M_OS_LINUX
+	this->SetOption(IPPROTO_TCP, TCP_CORK, cork ? 1 : 0, "TCPSocket::SetCork(): setsockopt(TCP_CORK) failed");
 #else
-				ss << strerror(errorCode);
+	throw net::Exc("TCPSocket::SetCork(): corking is not supported on this OS");
 #endif
-				throw net::Exc(ss.str());
-			}
+}
+
+
+
+void TCPSocket::SetQuickAck(bool quickAck){
+#if M_OS == M_OS_LINUX
+	this->SetOption(IPPROTO_TCP, TCP_QUICKACK, quickAck ? 1 : 0, "TCPSocket::SetQuickAck(): setsockopt(TCP_QUICKACK) failed");
+#else
+	throw net::Exc("TCPSocket::SetQuickAck(): quick ACK mode is not supported on this OS");
+#endif
+}
+
+
+
+void TCPSocket::SetNotSentLowWatermark(size_t numBytes){
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+	this->SetOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT, int(numBytes), "TCPSocket::SetNotSentLowWatermark(): setsockopt(TCP_NOTSENT_LOWAT) failed");
+#else
+	throw net::Exc("TCPSocket::SetNotSentLowWatermark(): TCP_NOTSENT_LOWAT is not supported on this OS");
+#endif
+}
+
+
+
+bool TCPSocket::EnableZeroCopy(){
+	if(!*this){
+		throw net::Exc("TCPSocket::EnableZeroCopy(): socket is not opened");
+	}
+
+#if M_OS == M_OS_LINUX
+	int yes = 1;
+	this->zeroCopyEnabled = setsockopt(this->socket, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes)) == 0;
+	return this->zeroCopyEnabled;
+#else
+	return false;
+#endif
+}
+
+
+
+size_t TCPSocket::SendZeroCopy(ting::Buffer<const std::uint8_t> buf, std::uint32_t& out_Id){
+	if(!*this){
+		throw net::Exc("TCPSocket::SendZeroCopy(): socket is not opened");
+	}
+
+	if(!this->zeroCopyEnabled){
+		throw net::Exc("TCPSocket::SendZeroCopy(): zero-copy sending is not enabled");
+	}
+
+#if M_OS == M_OS_LINUX
+	this->ClearCanWriteFlag();
+
+	if(buf.size() == 0){
+		return 0;
+	}
+
+	while(true){
+		ssize_t len = send(this->socket, buf.begin(), buf.size(), MSG_ZEROCOPY);
+		if(len >= 0){
+			out_Id = this->nextZeroCopyId;
+			++this->nextZeroCopyId;
+			return size_t(len);
+		}
+
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//can't send more bytes, return 0 bytes sent
+			return 0;
 		}
-		break;
+		ThrowError("TCPSocket::SendZeroCopy(): send() failed", errorCode);
 	}//~while
+#else
+	throw net::Exc("TCPSocket::SendZeroCopy(): zero-copy sending is not supported");
+#endif
+}
+
+
+
+size_t TCPSocket::RecvZeroCopyCompletions(ting::Buffer<ZeroCopyCompletion> completions){
+	if(!*this){
+		throw net::Exc("TCPSocket::RecvZeroCopyCompletions(): socket is not opened");
+	}
 
-	ASSERT(len >= 0)
-	return size_t(len);
+	//completions are reported as error condition, clear the flag before draining the error queue
+	this->ClearErrorFlag();
+
+#if M_OS == M_OS_LINUX
+	size_t num = 0;
+	while(num != completions.size()){
+		union{
+			char buf[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+			cmsghdr align;
+		} control;
+
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		if(recvmsg(this->socket, &msg, MSG_ERRQUEUE) < 0){
+			int errorCode = GetLastErrorCode();
+			if(errorCode == DEIntr()){
+				continue;
+			}else if(errorCode == DEAgain()){
+				break;//error queue is empty
+			}
+			ThrowError("TCPSocket::RecvZeroCopyCompletions(): recvmsg() failed", errorCode);
+		}
+
+		for(cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)){
+			if(!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)){
+				continue;
+			}
+
+			sock_extended_err err;
+			memcpy(&err, CMSG_DATA(cm), sizeof(err));
+			if(err.ee_origin != SO_EE_ORIGIN_ZEROCOPY){
+				ThrowError("TCPSocket::RecvZeroCopyCompletions(): socket error", int(err.ee_errno));
+			}
+
+			completions[num].first = err.ee_info;
+			completions[num].last = err.ee_data;
+			completions[num].copied = (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+			++num;
+			break;
+		}
+	}
+	return num;
+#else
+	return 0;
+#endif
 }
 
 
@@ -34,6 +34,8 @@ THE SOFTWARE. */
 #include "Socket.hpp"
 #include "IPAddress.hpp"
 
+#include "../fs/File.hpp"
+
 
 
 
@@ -52,6 +54,20 @@ class TCPServerSocket;
  */
 class TCPSocket : public Socket{
 	friend class ting::net::TCPServerSocket;
+	
+	//identifier of the next zero-copy send, kernel counts zero-copy sends starting from 0
+	std::uint32_t nextZeroCopyId = 0;
+	
+	//kernel silently ignores MSG_ZEROCOPY if SO_ZEROCOPY is not set, no completions would be reported then
+	bool zeroCopyEnabled = false;
+	
+	//error code of the failed connection attempt, 0 if connection has not failed,
+	//pending socket error is cleared once read, so it is remembered here for subsequent CheckConnect() calls
+	int connectError = 0;
+	
+	//with TCP Fast Open connect() may succeed without sending SYN, the handshake is done when first data is sent,
+	//until then the socket is not connected from the system's point of view, though it is writable
+	bool connectDeferred = false;
 public:
 	
 	/**
@@ -66,7 +82,11 @@ public:
 	TCPSocket(const TCPSocket&) = delete;
 	
 	TCPSocket(TCPSocket&& s) :
-			Socket(std::move(s))
+			Socket(std::move(s)),
+			nextZeroCopyId(s.nextZeroCopyId),
+			zeroCopyEnabled(s.zeroCopyEnabled),
+			connectError(s.connectError),
+			connectDeferred(s.connectDeferred)
 	{}
 
 	
@@ -76,6 +96,10 @@ public:
 	
 	TCPSocket& operator=(TCPSocket&& s){
 		this->Socket::operator=(std::move(s));
+		this->nextZeroCopyId = s.nextZeroCopyId;
+		this->zeroCopyEnabled = s.zeroCopyEnabled;
+		this->connectError = s.connectError;
+		this->connectDeferred = s.connectDeferred;
 		return *this;
 	}
 
@@ -87,7 +111,103 @@ public:
 	 * @param ip - IP address.
 	 * @param disableNaggle - enable/disable Naggle algorithm.
 	 */
-	void Open(const IPAddress& ip, bool disableNaggle = false);
+	void Open(const IPAddress& ip, bool disableNaggle = false){
+		SocketOptions options;
+		options.disableNaggle = disableNaggle;
+		this->Open(ip, options);
+	}
+
+
+
+	/**
+	 * @brief Connects the socket with given options.
+	 * Same as Open(const IPAddress&, bool), but allows specifying socket options
+	 * which are applied before connecting.
+	 * If SocketOptions::fastOpen is set, then the connection is established only when
+	 * first data is sent, and the data is sent in the SYN packet.
+	 * @param ip - IP address.
+	 * @param options - socket options.
+	 * @throw net::Exc - in case of any error, including failure to apply some option.
+	 */
+	void Open(const IPAddress& ip, const SocketOptions& options);
+
+
+
+	/**
+	 * @brief State of connection establishment.
+	 */
+	enum E_ConnectState{
+		/**
+		 * @brief Connection is still being established.
+		 */
+		CONNECTING,
+		
+		/**
+		 * @brief Connection has been established.
+		 */
+		CONNECTED,
+		
+		/**
+		 * @brief Connection has failed.
+		 */
+		FAILED
+	};
+
+
+
+	/**
+	 * @brief Check if connection has been established.
+	 * Open() starts connecting and returns immediately, the socket becomes ready for writing
+	 * (or reports error condition) when the connection attempt is finished, successfully or not.
+	 * This method tells which of the cases it is. It does not block.
+	 * To limit the connecting time, add a WaitableTimer to the same WaitSet as the socket
+	 * and close the socket if the timer expires while the socket is still connecting.
+	 * Once the connection has failed, subsequent calls keep returning FAILED with the same error code.
+	 * If SocketOptions::fastOpen was used and the system deferred the connection until the first data is sent,
+	 * the connection is reported as CONNECTED, failure of such connection is reported by sending or receiving.
+	 * @param out_ErrorCode - returns system error code of the failed connection attempt
+	 *                        (errno on *nix, WSAGetLastError() on Windows), 0 if connection has not failed.
+	 * @return state of the connection.
+	 * @throw net::Exc - if socket is not opened.
+	 */
+	E_ConnectState CheckConnect(int& out_ErrorCode);
+
+
+
+	/**
+	 * @brief Wait for connection to be established.
+	 * Blocks until the connection attempt started by Open() is finished or until the timeout is hit.
+	 * The socket must not be added to any WaitSet.
+	 * @param timeoutMillis - maximum time to wait in milliseconds.
+	 * @param out_ErrorCode - returns system error code of the failed connection attempt, 0 if connection has not failed.
+	 * @return state of the connection, CONNECTING if timeout was hit.
+	 * @throw net::Exc - if socket is not opened.
+	 */
+	E_ConnectState WaitForConnect(std::uint32_t timeoutMillis, int& out_ErrorCode);
+
+
+
+	/**
+	 * @brief Connect to one of the addresses of the host.
+	 * Implements "Happy Eyeballs" algorithm (RFC 8305): addresses are tried in order, alternating between
+	 * IPv6 and IPv4 addresses, starting from IPv6. Next connection attempt is started if the previous one has failed
+	 * or has not succeeded during attemptDelayMillis, without aborting the previous attempts, i.e. several
+	 * attempts may run in parallel. The first connection established is returned and the rest of attempts are aborted.
+	 * This avoids long delays when one of the address families is broken on the path to the host.
+	 * Blocks until connection is established or all the attempts have failed or the timeout is hit.
+	 * @param addresses - addresses of the host to connect to, e.g. all the addresses returned by DNS.
+	 * @param timeoutMillis - maximum time to wait for connection in milliseconds.
+	 * @param attemptDelayMillis - delay between starting connection attempts.
+	 * @param options - socket options for the connection attempts.
+	 * @return connected socket.
+	 * @throw net::Exc - if no connection was established.
+	 */
+	static TCPSocket ConnectHappyEyeballs(
+			ting::Buffer<const IPAddress> addresses,
+			std::uint32_t timeoutMillis,
+			std::uint32_t attemptDelayMillis = 250,
+			const SocketOptions& options = SocketOptions()
+		);
 
 
 
@@ -96,9 +216,27 @@ public:
 	 * Sends data on connected socket. This method does not guarantee that the whole
 	 * buffer will be sent completely, it will return the number of bytes actually sent.
 	 * @param buf - pointer to the buffer with data to send.
+	 * @param more - hint that more data will follow shortly, so the system may hold
+	 *               the data to send it together with following data in full segments (MSG_MORE).
+	 *               Ignored on systems which do not support it.
 	 * @return the number of bytes actually sent.
 	 */
-	size_t Send(ting::Buffer<const std::uint8_t> buf);
+	size_t Send(ting::Buffer<const std::uint8_t> buf, bool more = false);
+
+
+
+	/**
+	 * @brief Send data to connected socket, non-throwing version.
+	 * Same as Send(ting::Buffer<const std::uint8_t>, bool), but instead of throwing an exception
+	 * in case of error it returns the error code. This allows handling routine errors, like connection
+	 * reset by peer, without the cost of exception.
+	 * @param buf - pointer to the buffer with data to send.
+	 * @param more - hint that more data will follow shortly.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error.
+	 * @return the number of bytes actually sent, 0 in case of error.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf, bool more, int& out_ErrorCode)NOEXCEPT;
 
 
 
@@ -114,6 +252,185 @@ public:
 	 */
 	size_t Recv(ting::Buffer<std::uint8_t> buf);
 
+
+
+	/**
+	 * @brief Receive data from connected socket, non-throwing version.
+	 * Same as Recv(ting::Buffer<std::uint8_t>), but instead of throwing an exception
+	 * in case of error it returns the error code.
+	 * @param buf - pointer to the buffer where to put received data.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error.
+	 * @return the number of bytes written to the buffer, 0 in case of error.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf, int& out_ErrorCode)NOEXCEPT;
+
+
+
+	/**
+	 * @brief Send data from several buffers to connected socket.
+	 * Gathers data from the given buffers, in order, and sends it with a single system call
+	 * (sendmsg() on *nix, WSASend() on Windows). This allows sending, for example, message header
+	 * and payload which reside in different memory blocks without copying them to one buffer.
+	 * Same as the single buffer version, this method does not guarantee that all the data will be sent.
+	 * The returned number of bytes is counted across buffers, i.e. if it is greater than size of the
+	 * first buffer then the first buffer was sent completely and the rest of bytes were taken from
+	 * following buffers. Only first DMaxNumBuffers() buffers are sent in one call.
+	 * @param bufs - buffers with data to send.
+	 * @param more - hint that more data will follow shortly, see single buffer version of Send().
+	 * @return the number of bytes actually sent.
+	 */
+	size_t Send(ting::Buffer<const ting::Buffer<const std::uint8_t>> bufs, bool more = false);
+
+
+
+	/**
+	 * @brief Receive data from connected socket to several buffers.
+	 * Receives data available on the socket and scatters it to the given buffers, in order,
+	 * with a single system call (recvmsg() on *nix, WSARecv() on Windows).
+	 * Next buffer is filled only when previous one has been filled completely.
+	 * Same as the single buffer version, returns 0 if there is no data available.
+	 * Only first DMaxNumBuffers() buffers are filled in one call.
+	 * @param bufs - buffers where to put received data.
+	 * @return the number of bytes received, counted across buffers.
+	 */
+	size_t Recv(ting::Buffer<const ting::Buffer<std::uint8_t>> bufs);
+
+
+
+	/**
+	 * @brief Send part of a file to connected socket.
+	 * Sends 'length' bytes of the file starting from 'offset' from the file beginning.
+	 * For FSFile on Linux the data is sent with sendfile(), i.e. it is copied from file to socket
+	 * within the kernel, without passing through user space buffers. Current position of
+	 * the FSFile is not changed in that case.
+	 * For other File implementations, e.g. MemoryFile, or in case sendfile() is not supported,
+	 * the data is read from file to an intermediate buffer and sent with Send(). This moves the current
+	 * position of the file, which may involve rewinding the file if current position is beyond the 'offset'.
+	 * Same as Send(), this method does not block and does not guarantee that all the requested bytes are sent.
+	 * To send the rest, call this method again with offset and length adjusted by the returned number.
+	 * @param file - opened file to send data from.
+	 * @param offset - offset from the file beginning of the data to send.
+	 * @param length - number of bytes to send.
+	 * @return the number of bytes actually sent. 0 if socket cannot accept more data at the current moment
+	 *         or if the offset is at or beyond the end of file.
+	 * @throw ting::fs::File::IllegalStateExc - if the file is not opened.
+	 */
+	size_t SendFile(const ting::fs::File& file, size_t offset, size_t length);
+
+
+
+	/**
+	 * @brief Enable or disable corking.
+	 * While the socket is corked, partial segments are not sent, the data is accumulated until
+	 * full segments can be sent or until the socket is uncorked (TCP_CORK). Uncorking sends
+	 * all the pending data immediately. This allows assembling a response with several Send()
+	 * calls without sending small segments. Linux only.
+	 * @param cork - true to cork the socket, false to uncork.
+	 * @throw net::Exc - if socket is not opened, on error, or if not supported by OS.
+	 */
+	void SetCork(bool cork);
+
+
+
+	/**
+	 * @brief Enable or disable quick acknowledgements.
+	 * In quick ACK mode acknowledgements are sent immediately rather than delayed (TCP_QUICKACK).
+	 * Note, that the mode is not permanent, the system may leave it later, so it is
+	 * supposed to be set after every receive when needed. Linux only.
+	 * @param quickAck - true to enable quick ACK mode.
+	 * @throw net::Exc - if socket is not opened, on error, or if not supported by OS.
+	 */
+	void SetQuickAck(bool quickAck);
+
+
+
+	/**
+	 * @brief Set limit of unsent bytes in the send buffer.
+	 * See SocketOptions::notSentLowWatermark for details. Linux and Mac OS X only.
+	 * @param numBytes - the limit in bytes.
+	 * @throw net::Exc - if socket is not opened, on error, or if not supported by OS.
+	 */
+	void SetNotSentLowWatermark(size_t numBytes);
+
+
+
+	/**
+	 * @brief Enable zero-copy sending.
+	 * Enables SendZeroCopy() on this socket (Linux SO_ZEROCOPY option).
+	 * The socket must be opened.
+	 * @return true if zero-copy sending was enabled.
+	 * @return false if zero-copy sending is not supported by the system.
+	 */
+	bool EnableZeroCopy();
+
+
+
+	/**
+	 * @brief Send data without copying it to kernel.
+	 * Same as Send(), but the data is not copied to kernel buffers. Instead, the kernel
+	 * references the user memory until the data is sent and acknowledged by the peer.
+	 * Thus, the buffer must not be modified or freed until the send is reported as completed
+	 * by RecvZeroCopyCompletions(). The completions are reported in the error queue of the socket,
+	 * so the socket becomes ready with error condition flag set when there are completions to
+	 * receive, see Waitable::ErrorCondition().
+	 * Zero-copy sending has its own overhead of pinning the memory pages and of completion notifications,
+	 * so it only pays off for large buffers, tens of kilobytes and more.
+	 * Zero-copy sending must be enabled with EnableZeroCopy().
+	 * @param buf - buffer with data to send.
+	 * @param out_Id - reference to variable where the identifier of this send operation is stored.
+	 *                 It is only set if some data was sent. Identifiers are assigned sequentially.
+	 * @return the number of bytes actually sent.
+	 * @throw net::Exc - if socket is not opened, if zero-copy sending was not enabled, or on error.
+	 */
+	size_t SendZeroCopy(ting::Buffer<const std::uint8_t> buf, std::uint32_t& out_Id);
+
+
+
+	/**
+	 * @brief Range of completed zero-copy sends.
+	 */
+	struct ZeroCopyCompletion{
+		/**
+		 * @brief Identifier of the first completed send.
+		 */
+		std::uint32_t first;
+		
+		/**
+		 * @brief Identifier of the last completed send, inclusive.
+		 */
+		std::uint32_t last;
+		
+		/**
+		 * @brief Whether kernel had to copy the data anyway.
+		 * Kernel copies the data in some cases, e.g. for sending over loopback.
+		 * If it happens often then zero-copy sending only brings overhead.
+		 */
+		bool copied;
+	};
+
+
+
+	/**
+	 * @brief Receive completions of zero-copy sends.
+	 * Once the send is completed its buffer can be reused.
+	 * Clears the error condition flag of the socket.
+	 * @param completions - buffer where to store completions.
+	 * @return number of completions stored to the buffer, 0 if no completions are available.
+	 * @throw net::Exc - if socket error is reported instead of completion.
+	 */
+	size_t RecvZeroCopyCompletions(ting::Buffer<ZeroCopyCompletion> completions);
+
+
+
+	/**
+	 * @brief Maximum number of buffers which can be sent or received in one call.
+	 * @return maximum number of buffers of scatter/gather Send() and Recv().
+	 */
+	static constexpr size_t DMaxNumBuffers()NOEXCEPT{
+		return 64;
+	}
+
 	
 	
 	/**
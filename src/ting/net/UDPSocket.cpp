@@ -1,9 +1,33 @@
 #include "UDPSocket.hpp"
 
 #include <limits>
+#include <array>
+#include <algorithm>
 
 #if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
 #	include <netinet/in.h>
+#	include <sys/uio.h>
+#endif
+
+#if M_OS == M_OS_LINUX
+#	include <netinet/udp.h>
+
+//older system headers may lack these definitions
+#	ifndef SOL_UDP
+#		define SOL_UDP 17
+#	endif
+#	ifndef UDP_SEGMENT
+#		define UDP_SEGMENT 103
+#	endif
+#	ifndef UDP_GRO
+#		define UDP_GRO 104
+#	endif
+#	ifndef SO_TIMESTAMPNS
+#		define SO_TIMESTAMPNS 35
+#	endif
+#	ifndef SCM_TIMESTAMPNS
+#		define SCM_TIMESTAMPNS SO_TIMESTAMPNS
+#	endif
 #endif
 
 
@@ -12,6 +36,175 @@ using namespace ting::net;
 
 
 
+namespace{
+
+//returns size of the filled address structure
+socklen_t FillSockaddr(sockaddr_storage& sockAddr, const IPAddress& ip, bool socketIsIPv4){
+	socklen_t sockAddrLen;
+
+	if(
+#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS
+			socketIsIPv4 &&
+#endif
+			ip.host.IsIPv4()
+		)
+	{
+		sockaddr_in& a = reinterpret_cast<sockaddr_in&>(sockAddr);
+		memset(&a, 0, sizeof(a));
+		a.sin_family = AF_INET;
+		a.sin_addr.s_addr = htonl(ip.host.IPv4Host());
+		a.sin_port = htons(ip.port);
+		sockAddrLen = sizeof(a);
+	}else{
+		sockaddr_in6& a = reinterpret_cast<sockaddr_in6&>(sockAddr);
+		memset(&a, 0, sizeof(a));
+		a.sin6_family = AF_INET6;
+#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS || (M_OS == M_OS_LINUX && M_OS_NAME == M_OS_NAME_ANDROID)
+		a.sin6_addr.s6_addr[0] = ip.host.Quad0() >> 24;
+		a.sin6_addr.s6_addr[1] = (ip.host.Quad0() >> 16) & 0xff;
+		a.sin6_addr.s6_addr[2] = (ip.host.Quad0() >> 8) & 0xff;
+		a.sin6_addr.s6_addr[3] = ip.host.Quad0() & 0xff;
+		a.sin6_addr.s6_addr[4] = ip.host.Quad1() >> 24;
+		a.sin6_addr.s6_addr[5] = (ip.host.Quad1() >> 16) & 0xff;
+		a.sin6_addr.s6_addr[6] = (ip.host.Quad1() >> 8) & 0xff;
+		a.sin6_addr.s6_addr[7] = ip.host.Quad1() & 0xff;
+		a.sin6_addr.s6_addr[8] = ip.host.Quad2() >> 24;
+		a.sin6_addr.s6_addr[9] = (ip.host.Quad2() >> 16) & 0xff;
+		a.sin6_addr.s6_addr[10] = (ip.host.Quad2() >> 8) & 0xff;
+		a.sin6_addr.s6_addr[11] = ip.host.Quad2() & 0xff;
+		a.sin6_addr.s6_addr[12] = ip.host.Quad3() >> 24;
+		a.sin6_addr.s6_addr[13] = (ip.host.Quad3() >> 16) & 0xff;
+		a.sin6_addr.s6_addr[14] = (ip.host.Quad3() >> 8) & 0xff;
+		a.sin6_addr.s6_addr[15] = ip.host.Quad3() & 0xff;
+#else
+		a.sin6_addr.__in6_u.__u6_addr32[0] = htonl(ip.host.Quad0());
+		a.sin6_addr.__in6_u.__u6_addr32[1] = htonl(ip.host.Quad1());
+		a.sin6_addr.__in6_u.__u6_addr32[2] = htonl(ip.host.Quad2());
+		a.sin6_addr.__in6_u.__u6_addr32[3] = htonl(ip.host.Quad3());
+#endif
+		a.sin6_port = htons(ip.port);
+		sockAddrLen = sizeof(a);
+	}
+
+	return sockAddrLen;
+}
+
+
+
+IPAddress IPAddressFromSockaddr(const sockaddr_storage& sockAddr){
+	if(sockAddr.ss_family == AF_INET){
+		const sockaddr_in& a = reinterpret_cast<const sockaddr_in&>(sockAddr);
+		return IPAddress(
+				ntohl(a.sin_addr.s_addr),
+				std::uint16_t(ntohs(a.sin_port))
+			);
+	}else{
+		ASSERT_INFO(sockAddr.ss_family == AF_INET6, "sockAddr.ss_family = " << unsigned(sockAddr.ss_family) << " AF_INET = " << AF_INET << " AF_INET6 = " << AF_INET6)
+		const sockaddr_in6& a = reinterpret_cast<const sockaddr_in6&>(sockAddr);
+		return IPAddress(
+				IPAddress::Host(
+#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS || (M_OS == M_OS_LINUX && M_OS_NAME == M_OS_NAME_ANDROID)
+						(std::uint32_t(a.sin6_addr.s6_addr[0]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[1]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[2]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[3]),
+						(std::uint32_t(a.sin6_addr.s6_addr[4]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[5]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[6]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[7]),
+						(std::uint32_t(a.sin6_addr.s6_addr[8]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[9]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[10]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[11]),
+						(std::uint32_t(a.sin6_addr.s6_addr[12]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[13]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[14]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[15])
+#else
+						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[0])),
+						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[1])),
+						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[2])),
+						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[3]))
+#endif
+					),
+				std::uint16_t(ntohs(a.sin6_port))
+			);
+	}
+}
+
+
+
+void InitMeta(UDPSocket::DatagramMeta& meta)NOEXCEPT{
+	meta.timestampNs = 0;
+	meta.hasDestination = false;
+	meta.interfaceIndex = 0;
+	meta.ttl = -1;
+	meta.tos = -1;
+}
+
+
+
+#if M_OS == M_OS_LINUX
+//enough for all the control messages which can be enabled with UDPSocket::EnableRecvMeta()
+const size_t DMetaControlSize =
+		CMSG_SPACE(sizeof(timespec))
+		+ CMSG_SPACE(sizeof(in_pktinfo))
+		+ CMSG_SPACE(sizeof(in6_pktinfo))
+		+ 4 * CMSG_SPACE(sizeof(int));
+
+union MetaControl{
+	char buf[DMetaControlSize];
+	cmsghdr align;
+};
+
+
+
+void ParseMeta(msghdr& msg, UDPSocket::DatagramMeta& out_Meta)NOEXCEPT{
+	InitMeta(out_Meta);
+	
+	for(cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)){
+		if(cm->cmsg_level == SOL_SOCKET){
+			if(cm->cmsg_type == SCM_TIMESTAMPNS){
+				timespec ts;
+				memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+				out_Meta.timestampNs = std::uint64_t(ts.tv_sec) * 1000000000 + std::uint64_t(ts.tv_nsec);
+			}
+		}else if(cm->cmsg_level == IPPROTO_IP){
+			//IPv4 datagrams received by dual stack IPv6 socket come with IPv4 control messages
+			if(cm->cmsg_type == IP_PKTINFO){
+				in_pktinfo pi;
+				memcpy(&pi, CMSG_DATA(cm), sizeof(pi));
+				out_Meta.destination = IPAddress::Host(std::uint32_t(ntohl(pi.ipi_addr.s_addr)));
+				out_Meta.interfaceIndex = unsigned(pi.ipi_ifindex);
+				out_Meta.hasDestination = true;
+			}else if(cm->cmsg_type == IP_TTL){
+				int ttl;
+				memcpy(&ttl, CMSG_DATA(cm), sizeof(ttl));
+				out_Meta.ttl = ttl;
+			}else if(cm->cmsg_type == IP_TOS){
+				//ToS is delivered as one byte
+				out_Meta.tos = int(*reinterpret_cast<const std::uint8_t*>(CMSG_DATA(cm)));
+			}
+		}else if(cm->cmsg_level == IPPROTO_IPV6){
+			if(cm->cmsg_type == IPV6_PKTINFO){
+				in6_pktinfo pi;
+				memcpy(&pi, CMSG_DATA(cm), sizeof(pi));
+				
+				sockaddr_storage sockAddr;
+				sockaddr_in6& a = reinterpret_cast<sockaddr_in6&>(sockAddr);
+				memset(&a, 0, sizeof(a));
+				a.sin6_family = AF_INET6;
+				a.sin6_addr = pi.ipi6_addr;
+				
+				out_Meta.destination = IPAddressFromSockaddr(sockAddr).host;
+				out_Meta.interfaceIndex = unsigned(pi.ipi6_ifindex);
+				out_Meta.hasDestination = true;
+			}else if(cm->cmsg_type == IPV6_HOPLIMIT){
+				int hopLimit;
+				memcpy(&hopLimit, CMSG_DATA(cm), sizeof(hopLimit));
+				out_Meta.ttl = hopLimit;
+			}else if(cm->cmsg_type == IPV6_TCLASS){
+				int trafficClass;
+				memcpy(&trafficClass, CMSG_DATA(cm), sizeof(trafficClass));
+				out_Meta.tos = trafficClass;
+			}
+		}
+	}
+}
+#endif
+
+}//~namespace
+
+
+
 void UDPSocket::Open(std::uint16_t port){
 	if(*this){
 		throw net::Exc("UDPSocket::Open(): the socket is already opened");
@@ -147,6 +340,17 @@ void UDPSocket::Open(std::uint16_t port){
 #	error "Unsupported OS"
 #endif
 
+	//Check for segmentation offload support, kernels which do not support it do not know the option
+#if M_OS == M_OS_LINUX
+	{
+		int segmentSize;
+		socklen_t len = sizeof(segmentSize);
+		this->gsoSupported = getsockopt(this->socket, SOL_UDP, UDP_SEGMENT, &segmentSize, &len) == 0;
+	}
+#else
+	this->gsoSupported = false;
+#endif
+
 	this->ClearAllReadinessFlags();
 }
 
@@ -157,63 +361,33 @@ size_t UDPSocket::Send(ting::Buffer<const std::uint8_t> buf, const IPAddress& de
 		throw net::Exc("UDPSocket::Send(): socket is not opened");
 	}
 
+	int errorCode;
+	size_t ret = this->Send(buf, destinationIP, errorCode);
+	if(errorCode != 0){
+#if M_OS == M_OS_WINDOWS
+		if(errorCode == WSAEAFNOSUPPORT){
+			throw net::Exc("Address family is not supported by protocol family. Note, that libting on WinXP does not support IPv6.");
+		}
+#endif
+		ThrowError("UDPSocket::Send(): sendto() failed", errorCode);
+	}
+	return ret;
+}
+
+
+
+size_t UDPSocket::Send(ting::Buffer<const std::uint8_t> buf, const IPAddress& destinationIP, int& out_ErrorCode)NOEXCEPT{
 	this->ClearCanWriteFlag();
 
 	sockaddr_storage sockAddr;
-	socklen_t sockAddrLen;
-	
-	
-	if(
-#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS
-			this->ipv4 &&
-#endif
-			destinationIP.host.IsIPv4()
-		)
-	{
-		sockaddr_in& a = reinterpret_cast<sockaddr_in&>(sockAddr);
-		memset(&a, 0, sizeof(a));
-		a.sin_family = AF_INET;
-		a.sin_addr.s_addr = htonl(destinationIP.host.IPv4Host());
-		a.sin_port = htons(destinationIP.port);
-		sockAddrLen = sizeof(a);
-	}else{
-		sockaddr_in6& a = reinterpret_cast<sockaddr_in6&>(sockAddr);
-		memset(&a, 0, sizeof(a));
-		a.sin6_family = AF_INET6;
-#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS || (M_OS == M_OS_LINUX && M_OS_NAME == M_OS_NAME_ANDROID)
-		a.sin6_addr.s6_addr[0] = destinationIP.host.Quad0() >> 24;
-		a.sin6_addr.s6_addr[1] = (destinationIP.host.Quad0() >> 16) & 0xff;
-		a.sin6_addr.s6_addr[2] = (destinationIP.host.Quad0() >> 8) & 0xff;
-		a.sin6_addr.s6_addr[3] = destinationIP.host.Quad0() & 0xff;
-		a.sin6_addr.s6_addr[4] = destinationIP.host.Quad1() >> 24;
-		a.sin6_addr.s6_addr[5] = (destinationIP.host.Quad1() >> 16) & 0xff;
-		a.sin6_addr.s6_addr[6] = (destinationIP.host.Quad1() >> 8) & 0xff;
-		a.sin6_addr.s6_addr[7] = destinationIP.host.Quad1() & 0xff;
-		a.sin6_addr.s6_addr[8] = destinationIP.host.Quad2() >> 24;
-		a.sin6_addr.s6_addr[9] = (destinationIP.host.Quad2() >> 16) & 0xff;
-		a.sin6_addr.s6_addr[10] = (destinationIP.host.Quad2() >> 8) & 0xff;
-		a.sin6_addr.s6_addr[11] = destinationIP.host.Quad2() & 0xff;
-		a.sin6_addr.s6_addr[12] = destinationIP.host.Quad3() >> 24;
-		a.sin6_addr.s6_addr[13] = (destinationIP.host.Quad3() >> 16) & 0xff;
-		a.sin6_addr.s6_addr[14] = (destinationIP.host.Quad3() >> 8) & 0xff;
-		a.sin6_addr.s6_addr[15] = destinationIP.host.Quad3() & 0xff;
-#else
-		a.sin6_addr.__in6_u.__u6_addr32[0] = htonl(destinationIP.host.Quad0());
-		a.sin6_addr.__in6_u.__u6_addr32[1] = htonl(destinationIP.host.Quad1());
-		a.sin6_addr.__in6_u.__u6_addr32[2] = htonl(destinationIP.host.Quad2());
-		a.sin6_addr.__in6_u.__u6_addr32[3] = htonl(destinationIP.host.Quad3());
-#endif
-		a.sin6_port = htons(destinationIP.port);
-		sockAddrLen = sizeof(a);
-	}
+	socklen_t sockAddrLen = FillSockaddr(sockAddr, destinationIP, this->ipv4);
 
+	while(true){
 #if M_OS == M_OS_WINDOWS
-	int len;
+		int len;
 #else
-	ssize_t len;
+		ssize_t len;
 #endif
-
-	while(true){
 		len = ::sendto(
 				this->socket,
 				reinterpret_cast<const char*>(buf.begin()),
@@ -224,46 +398,23 @@ size_t UDPSocket::Send(ting::Buffer<const std::uint8_t> buf, const IPAddress& de
 			);
 
 		if(len == DSocketError()){
-#if M_OS == M_OS_WINDOWS
-			int errorCode = WSAGetLastError();
-			
-			if(errorCode == WSAEAFNOSUPPORT){
-				throw net::Exc("Address family is not supported by protocol family. Note, that libting on WinXP does not support IPv6.");
-			}
-#else
-			int errorCode = errno;
-#endif
+			int errorCode = GetLastErrorCode();
 			if(errorCode == DEIntr()){
 				continue;
-			}else if(errorCode == DEAgain()){
-				//can't send more bytes, return 0 bytes sent
-				len = 0;
-			}else{
-				std::stringstream ss;
-				ss << "UDPSocket::Send(): sendto() failed, error code = " << errorCode << ": ";
-#if M_COMPILER == M_COMPILER_MSVC
-				{
-					const size_t msgbufSize = 0xff;
-					char msgbuf[msgbufSize];
-					strerror_s(msgbuf, msgbufSize, errorCode);
-					msgbuf[msgbufSize - 1] = 0;//make sure the string is null-terminated
-					ss << msgbuf;
-				}
-#else
-				ss << strerror(errorCode);
-#endif
-				throw net::Exc(ss.str());
 			}
+			//if can't send more bytes, then it is not an error, return 0 bytes sent
+			out_ErrorCode = errorCode == DEAgain() ? 0 : errorCode;
+			return 0;
 		}
-		break;
-	}//~while
 
-	ASSERT(buf.size() <= size_t(std::numeric_limits<int>::max()))
-	ASSERT_INFO(len <= int(buf.size()), "res = " << len)
-	ASSERT_INFO((len == int(buf.size())) || (len == 0), "res = " << len)
+		ASSERT(buf.size() <= size_t(std::numeric_limits<int>::max()))
+		ASSERT_INFO(len <= int(buf.size()), "res = " << len)
+		ASSERT_INFO((len == int(buf.size())) || (len == 0), "res = " << len)
 
-	ASSERT(len >= 0)
-	return size_t(len);
+		ASSERT(len >= 0)
+		out_ErrorCode = 0;
+		return size_t(len);
+	}//~while
 }
 
 
@@ -273,6 +424,17 @@ size_t UDPSocket::Recv(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP){
 		throw net::Exc("UDPSocket::Recv(): socket is not opened");
 	}
 
+	int errorCode;
+	size_t ret = this->Recv(buf, out_SenderIP, errorCode);
+	if(errorCode != 0){
+		ThrowError("UDPSocket::Recv(): recvfrom() failed", errorCode);
+	}
+	return ret;
+}
+
+
+
+size_t UDPSocket::Recv(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, int& out_ErrorCode)NOEXCEPT{
 	//The "can read" flag shall be cleared even if this function fails.
 	//This is to avoid subsequent calls to Recv() because of it indicating
 	//that there's an activity.
@@ -281,21 +443,16 @@ size_t UDPSocket::Recv(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP){
 
 	sockaddr_storage sockAddr;
 
+	while(true){
 #if M_OS == M_OS_WINDOWS
-	int sockLen = sizeof(sockAddr);
+		int sockLen = sizeof(sockAddr);
+		int len;
 #elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
-	socklen_t sockLen = sizeof(sockAddr);
+		socklen_t sockLen = sizeof(sockAddr);
+		ssize_t len;
 #else
 #	error "Unsupported OS"
 #endif
-
-#if M_OS == M_OS_WINDOWS
-	int len;
-#else
-	ssize_t len;
-#endif
-
-	while(true){
 		len = ::recvfrom(
 				this->socket,
 				reinterpret_cast<char*>(buf.begin()),
@@ -306,67 +463,613 @@ size_t UDPSocket::Recv(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP){
 			);
 
 		if(len == DSocketError()){
-#if M_OS == M_OS_WINDOWS
-			int errorCode = WSAGetLastError();
+			int errorCode = GetLastErrorCode();
+			if(errorCode == DEIntr()){
+				continue;
+			}
+			//if no data available, then it is not an error, return 0 bytes received
+			out_ErrorCode = errorCode == DEAgain() ? 0 : errorCode;
+			return 0;
+		}
+
+		ASSERT(buf.size() <= size_t(std::numeric_limits<int>::max()))
+		ASSERT_INFO(len <= int(buf.size()), "len = " << len)
+
+		out_SenderIP = IPAddressFromSockaddr(sockAddr);
+
+		ASSERT(len >= 0)
+		out_ErrorCode = 0;
+		return size_t(len);
+	}//~while
+}
+
+
+
+size_t UDPSocket::SendMany(ting::Buffer<const OutgoingDatagram> datagrams){
+	if(!*this){
+		throw net::Exc("UDPSocket::SendMany(): socket is not opened");
+	}
+
+#if M_OS == M_OS_LINUX && M_OS_NAME != M_OS_NAME_ANDROID
+	this->ClearCanWriteFlag();
+
+	size_t num = std::min(datagrams.size(), DMaxBatchSize());
+	if(num == 0){
+		return 0;
+	}
+
+	std::array<mmsghdr, DMaxBatchSize()> msgs;
+	std::array<iovec, DMaxBatchSize()> iovecs;
+	std::array<sockaddr_storage, DMaxBatchSize()> addrs;
+
+	for(size_t i = 0; i != num; ++i){
+		const OutgoingDatagram& d = datagrams[i];
+
+		iovecs[i].iov_base = const_cast<std::uint8_t*>(d.data.begin());
+		iovecs[i].iov_len = d.data.size();
+
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = FillSockaddr(addrs[i], d.destination, this->ipv4);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while(true){
+		int res = sendmmsg(this->socket, &*msgs.begin(), unsigned(num), 0);
+		if(res >= 0){
+			return size_t(res);
+		}
+
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//can't send more datagrams, return 0 datagrams sent
+			return 0;
+		}
+		ThrowError("UDPSocket::SendMany(): sendmmsg() failed", errorCode);
+	}//~while
 #else
-			int errorCode = errno;
+	//no batch system call, send datagrams one by one
+	size_t ret = 0;
+	for(; ret != datagrams.size() && ret != DMaxBatchSize(); ++ret){
+		try{
+			if(this->Send(datagrams[ret].data, datagrams[ret].destination) == 0){
+				break;
+			}
+		}catch(net::Exc&){
+			//report the error only if nothing was sent, same as sendmmsg() does
+			if(ret == 0){
+				throw;
+			}
+			break;
+		}
+	}
+	return ret;
 #endif
+}
+
+
+
+size_t UDPSocket::RecvMany(ting::Buffer<IncomingDatagram> datagrams){
+	if(!*this){
+		throw net::Exc("UDPSocket::RecvMany(): socket is not opened");
+	}
+
+	return this->RecvManyTo(datagrams, nullptr);
+}
+
+
+
+size_t UDPSocket::RecvManyWithMeta(ting::Buffer<IncomingDatagram> datagrams, ting::Buffer<DatagramMeta> out_Meta){
+	if(!*this){
+		throw net::Exc("UDPSocket::RecvManyWithMeta(): socket is not opened");
+	}
+
+	return this->RecvManyTo(
+			ting::Buffer<IncomingDatagram>(datagrams.begin(), std::min(datagrams.size(), out_Meta.size())),
+			out_Meta.begin()
+		);
+}
+
+
+
+size_t UDPSocket::RecvManyTo(ting::Buffer<IncomingDatagram> datagrams, DatagramMeta* out_Meta){
+#if M_OS == M_OS_LINUX && M_OS_NAME != M_OS_NAME_ANDROID
+	//the 'can read' flag shall be cleared even if this function fails, see Recv().
+	this->ClearCanReadFlag();
+
+	size_t num = std::min(datagrams.size(), DMaxBatchSize());
+	if(num == 0){
+		return 0;
+	}
+
+	std::array<mmsghdr, DMaxBatchSize()> msgs;
+	std::array<iovec, DMaxBatchSize()> iovecs;
+	std::array<sockaddr_storage, DMaxBatchSize()> addrs;
+	std::array<MetaControl, DMaxBatchSize()> controls;
+
+	for(size_t i = 0; i != num; ++i){
+		iovecs[i].iov_base = datagrams[i].buf.begin();
+		iovecs[i].iov_len = datagrams[i].buf.size();
+
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		if(out_Meta){
+			msgs[i].msg_hdr.msg_control = controls[i].buf;
+			msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].buf);
+		}
+	}
+
+	while(true){
+		//socket is in non-blocking mode, so recvmmsg() returns as soon as there are no more datagrams available
+		int res = recvmmsg(this->socket, &*msgs.begin(), unsigned(num), 0, nullptr);
+		if(res >= 0){
+			for(int i = 0; i != res; ++i){
+				ASSERT(msgs[i].msg_len <= datagrams[i].buf.size())
+				datagrams[i].size = msgs[i].msg_len;
+				datagrams[i].sender = IPAddressFromSockaddr(addrs[i]);
+				if(out_Meta){
+					ParseMeta(msgs[i].msg_hdr, out_Meta[i]);
+				}
+			}
+			return size_t(res);
+		}
+
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			return 0; //no data available, return 0 datagrams received
+		}
+		ThrowError("UDPSocket::RecvMany(): recvmmsg() failed", errorCode);
+	}//~while
+#else
+	//no batch system call, receive datagrams one by one
+	size_t ret = 0;
+	for(; ret != datagrams.size() && ret != DMaxBatchSize(); ++ret){
+		IncomingDatagram& d = datagrams[ret];
+		if(out_Meta){
+			d.size = this->RecvWithMeta(d.buf, d.sender, out_Meta[ret]);
+		}else{
+			d.size = this->Recv(d.buf, d.sender);
+		}
+		if(d.size == 0){
+			break;
+		}
+	}
+	return ret;
+#endif
+}
+
+
+
+size_t UDPSocket::SendSegmented(ting::Buffer<const std::uint8_t> buf, size_t segmentSize, const IPAddress& destinationIP){
+	if(!*this){
+		throw net::Exc("UDPSocket::SendSegmented(): socket is not opened");
+	}
+	if(segmentSize == 0){
+		throw net::Exc("UDPSocket::SendSegmented(): segment size is 0");
+	}
+
+	size_t numSegments = std::min(
+			(buf.size() + segmentSize - 1) / segmentSize,
+			std::min(DMaxNumSegments(), std::max(DMaxSegmentedSize() / segmentSize, size_t(1)))
+		);
+	size_t size = std::min(buf.size(), numSegments * segmentSize);
+
+	if(size <= segmentSize){
+		//just one datagram
+		return this->Send(ting::Buffer<const std::uint8_t>(buf.begin(), size), destinationIP);
+	}
+
+#if M_OS == M_OS_LINUX
+	if(this->gsoSupported){
+		this->ClearCanWriteFlag();
+
+		sockaddr_storage sockAddr;
+
+		iovec iov;
+		iov.iov_base = const_cast<std::uint8_t*>(buf.begin());
+		iov.iov_len = size;
+
+		union{
+			char buf[CMSG_SPACE(sizeof(std::uint16_t))];
+			cmsghdr align;
+		} control;
+
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &sockAddr;
+		msg.msg_namelen = FillSockaddr(sockAddr, destinationIP, this->ipv4);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+		cm->cmsg_level = SOL_UDP;
+		cm->cmsg_type = UDP_SEGMENT;
+		cm->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+		std::uint16_t gsoSize = std::uint16_t(segmentSize);
+		memcpy(CMSG_DATA(cm), &gsoSize, sizeof(gsoSize));
+
+		while(true){
+			ssize_t res = sendmsg(this->socket, &msg, 0);
+			if(res >= 0){
+				ASSERT_INFO(size_t(res) == size, "res = " << res)
+				return size;
+			}
+
+			int errorCode = GetLastErrorCode();
 			if(errorCode == DEIntr()){
 				continue;
 			}else if(errorCode == DEAgain()){
-				return 0; //no data available, return 0 bytes received
-			}else{
-				std::stringstream ss;
-				ss << "UDPSocket::Recv(): recvfrom() failed, error code = " << errorCode << ": ";
-#if M_COMPILER == M_COMPILER_MSVC
-				{
-					const size_t msgbufSize = 0xff;
-					char msgbuf[msgbufSize];
-					strerror_s(msgbuf, msgbufSize, errorCode);
-					msgbuf[msgbufSize - 1] = 0;//make sure the string is null-terminated
-					ss << msgbuf;
-				}
+				//can't send more bytes, return 0 bytes sent
+				return 0;
+			}else if(errorCode == EIO){
+				//network device cannot do the offload, e.g. it lacks checksum offload, use fallback from now on
+				this->gsoSupported = false;
+				break;
+			}
+			ThrowError("UDPSocket::SendSegmented(): sendmsg() failed", errorCode);
+		}//~while
+	}
+#endif
+
+	//no segmentation offload, send segments as separate datagrams
+	std::array<OutgoingDatagram, DMaxNumSegments()> datagrams;
+	for(size_t i = 0; i != numSegments; ++i){
+		size_t offset = i * segmentSize;
+		datagrams[i].data = ting::Buffer<const std::uint8_t>(buf.begin() + offset, std::min(segmentSize, size - offset));
+		datagrams[i].destination = destinationIP;
+	}
+
+	size_t numSent = this->SendMany(ting::Buffer<const OutgoingDatagram>(&*datagrams.begin(), numSegments));
+	return std::min(size, numSent * segmentSize);
+}
+
+
+
+bool UDPSocket::SetReceiveCoalescing(bool enable){
+	if(!*this){
+		throw net::Exc("UDPSocket::SetReceiveCoalescing(): socket is not opened");
+	}
+
+#if M_OS == M_OS_LINUX
+	int value = enable ? 1 : 0;
+	return setsockopt(this->socket, SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0;
 #else
-				ss << strerror(errorCode);
+	return !enable;
 #endif
-				throw net::Exc(ss.str());
-			}
+}
+
+
+
+size_t UDPSocket::RecvCoalesced(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, size_t& out_SegmentSize){
+#if M_OS == M_OS_LINUX
+	if(!*this){
+		throw net::Exc("UDPSocket::RecvCoalesced(): socket is not opened");
+	}
+
+	//the 'can read' flag shall be cleared even if this function fails, see Recv().
+	this->ClearCanReadFlag();
+
+	sockaddr_storage sockAddr;
+
+	iovec iov;
+	iov.iov_base = buf.begin();
+	iov.iov_len = buf.size();
+
+	union{
+		char buf[CMSG_SPACE(sizeof(int))];
+		cmsghdr align;
+	} control;
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &sockAddr;
+	msg.msg_namelen = sizeof(sockAddr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	ssize_t len;
+	while(true){
+		len = recvmsg(this->socket, &msg, 0);
+		if(len >= 0){
+			break;
 		}
-		break;
+
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			return 0; //no data available, return 0 bytes received
+		}
+		ThrowError("UDPSocket::RecvCoalesced(): recvmsg() failed", errorCode);
 	}//~while
 
-	ASSERT(buf.size() <= size_t(std::numeric_limits<int>::max()))
-	ASSERT_INFO(len <= int(buf.size()), "len = " << len)
+	out_SenderIP = IPAddressFromSockaddr(sockAddr);
 
-	if(sockAddr.ss_family == AF_INET){
-		sockaddr_in& a = reinterpret_cast<sockaddr_in&>(sockAddr);
-		out_SenderIP = IPAddress(
-				ntohl(a.sin_addr.s_addr),
-				std::uint16_t(ntohs(a.sin_port))
-			);
-	}else{
-		ASSERT_INFO(sockAddr.ss_family == AF_INET6, "sockAddr.ss_family = " << unsigned(sockAddr.ss_family) << " AF_INET = " << AF_INET << " AF_INET6 = " << AF_INET6)
-		sockaddr_in6& a = reinterpret_cast<sockaddr_in6&>(sockAddr);
-		out_SenderIP = IPAddress(
-				IPAddress::Host(
-#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS || (M_OS == M_OS_LINUX && M_OS_NAME == M_OS_NAME_ANDROID)
-						(std::uint32_t(a.sin6_addr.s6_addr[0]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[1]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[2]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[3]),
-						(std::uint32_t(a.sin6_addr.s6_addr[4]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[5]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[6]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[7]),
-						(std::uint32_t(a.sin6_addr.s6_addr[8]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[9]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[10]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[11]),
-						(std::uint32_t(a.sin6_addr.s6_addr[12]) << 24) | (std::uint32_t(a.sin6_addr.s6_addr[13]) << 16) | (std::uint32_t(a.sin6_addr.s6_addr[14]) << 8) | std::uint32_t(a.sin6_addr.s6_addr[15])
+	out_SegmentSize = size_t(len);
+	for(cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)){
+		if(cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO){
+			int gsoSize;
+			memcpy(&gsoSize, CMSG_DATA(cm), sizeof(gsoSize));
+			out_SegmentSize = size_t(gsoSize);
+			break;
+		}
+	}
+
+	return size_t(len);
 #else
-						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[0])),
-						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[1])),
-						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[2])),
-						std::uint32_t(ntohl(a.sin6_addr.__in6_u.__u6_addr32[3]))
+	size_t ret = this->Recv(buf, out_SenderIP);
+	out_SegmentSize = ret;
+	return ret;
 #endif
-					),
-				std::uint16_t(ntohs(a.sin6_port))
-			);
+}
+
+
+
+std::uint32_t UDPSocket::EnableRecvMeta(std::uint32_t flags){
+	if(!*this){
+		throw net::Exc("UDPSocket::EnableRecvMeta(): socket is not opened");
 	}
-	
-	ASSERT(len >= 0)
+
+#if M_OS == M_OS_LINUX
+	auto setOption = [this](int level, int name, bool enable){
+		int value = enable ? 1 : 0;
+		return setsockopt(this->socket, level, name, &value, sizeof(value)) == 0;
+	};
+
+	//IPv4 options are also set for IPv6 socket, since dual stack socket receives IPv4 datagrams too
+	auto setOptions = [this, &setOption](int nameIPv4, int nameIPv6, bool enable){
+		bool ret = setOption(IPPROTO_IP, nameIPv4, enable);
+		if(!this->ipv4){
+			ret = setOption(IPPROTO_IPV6, nameIPv6, enable) && ret;
+		}
+		return ret;
+	};
+
+	std::uint32_t ret = META_NONE;
+
+	if(setOption(SOL_SOCKET, SO_TIMESTAMPNS, (flags & META_TIMESTAMP) != 0)){
+		ret |= flags & META_TIMESTAMP;
+	}
+
+	if(setOptions(IP_PKTINFO, IPV6_RECVPKTINFO, (flags & META_DESTINATION) != 0)){
+		ret |= flags & META_DESTINATION;
+	}
+
+	{
+		bool enable = (flags & META_TTL_TOS) != 0;
+		bool ttl = setOptions(IP_RECVTTL, IPV6_RECVHOPLIMIT, enable);
+		bool tos = setOptions(IP_RECVTOS, IPV6_RECVTCLASS, enable);
+		if(ttl && tos){
+			ret |= flags & META_TTL_TOS;
+		}
+	}
+
+	return ret;
+#else
+	return META_NONE;
+#endif
+}
+
+
+
+size_t UDPSocket::RecvWithMeta(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, DatagramMeta& out_Meta){
+	InitMeta(out_Meta);
+
+#if M_OS == M_OS_LINUX
+	if(!*this){
+		throw net::Exc("UDPSocket::RecvWithMeta(): socket is not opened");
+	}
+
+	//the 'can read' flag shall be cleared even if this function fails, see Recv().
+	this->ClearCanReadFlag();
+
+	sockaddr_storage sockAddr;
+
+	iovec iov;
+	iov.iov_base = buf.begin();
+	iov.iov_len = buf.size();
+
+	MetaControl control;
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &sockAddr;
+	msg.msg_namelen = sizeof(sockAddr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	ssize_t len;
+	while(true){
+		len = recvmsg(this->socket, &msg, 0);
+		if(len >= 0){
+			break;
+		}
+
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			return 0; //no data available, return 0 bytes received
+		}
+		ThrowError("UDPSocket::RecvWithMeta(): recvmsg() failed", errorCode);
+	}//~while
+
+	out_SenderIP = IPAddressFromSockaddr(sockAddr);
+	ParseMeta(msg, out_Meta);
+
 	return size_t(len);
+#else
+	return this->Recv(buf, out_SenderIP);
+#endif
+}
+
+
+
+void UDPSocket::ChangeMembership(int name, const IPAddress::Host& group, const IPAddress::Host* source, unsigned interfaceIndex, const char* what){
+	if(!*this){
+		std::stringstream ss;
+		ss << what << ": socket is not opened";
+		throw net::Exc(ss.str());
+	}
+
+	if(source && source->IsIPv4() != group.IsIPv4()){
+		std::stringstream ss;
+		ss << what << ": group and source addresses are of different families";
+		throw net::Exc(ss.str());
+	}
+
+	if(this->ipv4 && !group.IsIPv4()){
+		std::stringstream ss;
+		ss << what << ": IPv6 group cannot be joined by IPv4 socket";
+		throw net::Exc(ss.str());
+	}
+
+	//protocol independent group requests take interface index, which is more convenient than interface address
+	int level = group.IsIPv4() ? IPPROTO_IP : IPPROTO_IPV6;
+
+	int res;
+	if(source){
+		group_source_req req;
+		memset(&req, 0, sizeof(req));
+		req.gsr_interface = interfaceIndex;
+		FillSockaddr(req.gsr_group, IPAddress(group, 0), true);
+		FillSockaddr(req.gsr_source, IPAddress(*source, 0), true);
+		res = setsockopt(this->socket, level, name, reinterpret_cast<const char*>(&req), sizeof(req));
+	}else{
+		group_req req;
+		memset(&req, 0, sizeof(req));
+		req.gr_interface = interfaceIndex;
+		FillSockaddr(req.gr_group, IPAddress(group, 0), true);
+		res = setsockopt(this->socket, level, name, reinterpret_cast<const char*>(&req), sizeof(req));
+	}
+
+	if(res != 0){
+		ThrowError(what, GetLastErrorCode());
+	}
+}
+
+
+
+void UDPSocket::JoinGroup(const IPAddress::Host& group, unsigned interfaceIndex){
+	this->ChangeMembership(MCAST_JOIN_GROUP, group, nullptr, interfaceIndex, "UDPSocket::JoinGroup(): setsockopt(MCAST_JOIN_GROUP) failed");
+}
+
+
+
+void UDPSocket::LeaveGroup(const IPAddress::Host& group, unsigned interfaceIndex){
+	this->ChangeMembership(MCAST_LEAVE_GROUP, group, nullptr, interfaceIndex, "UDPSocket::LeaveGroup(): setsockopt(MCAST_LEAVE_GROUP) failed");
+}
+
+
+
+void UDPSocket::JoinSourceGroup(const IPAddress::Host& group, const IPAddress::Host& source, unsigned interfaceIndex){
+	this->ChangeMembership(MCAST_JOIN_SOURCE_GROUP, group, &source, interfaceIndex, "UDPSocket::JoinSourceGroup(): setsockopt(MCAST_JOIN_SOURCE_GROUP) failed");
+}
+
+
+
+void UDPSocket::LeaveSourceGroup(const IPAddress::Host& group, const IPAddress::Host& source, unsigned interfaceIndex){
+	this->ChangeMembership(MCAST_LEAVE_SOURCE_GROUP, group, &source, interfaceIndex, "UDPSocket::LeaveSourceGroup(): setsockopt(MCAST_LEAVE_SOURCE_GROUP) failed");
+}
+
+
+
+void UDPSocket::SetIPOption(int nameIPv4, int nameIPv6, int value, const char* what){
+	if(this->ipv4){
+		this->SetOption(IPPROTO_IP, nameIPv4, value, what);
+		return;
+	}
+
+	this->SetOption(IPPROTO_IPV6, nameIPv6, value, what);
+
+	//not all systems allow IPv4 options on IPv6 socket, so ignore the error
+	setsockopt(this->socket, IPPROTO_IP, nameIPv4, reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+
+void UDPSocket::SetMulticastInterface(unsigned interfaceIndex){
+	if(!*this){
+		throw net::Exc("UDPSocket::SetMulticastInterface(): socket is not opened");
+	}
+
+	const char* what = "UDPSocket::SetMulticastInterface(): setsockopt(IP_MULTICAST_IF) failed";
+
+	if(!this->ipv4){
+		this->SetOption(IPPROTO_IPV6, IPV6_MULTICAST_IF, int(interfaceIndex), "UDPSocket::SetMulticastInterface(): setsockopt(IPV6_MULTICAST_IF) failed");
+	}
+
+	//IPv4 option takes the interface in a system specific way
+#if M_OS == M_OS_LINUX
+	ip_mreqn req;
+	memset(&req, 0, sizeof(req));
+	req.imr_ifindex = int(interfaceIndex);
+	int res = setsockopt(this->socket, IPPROTO_IP, IP_MULTICAST_IF, &req, sizeof(req));
+#elif M_OS == M_OS_WINDOWS
+	//interface index is passed as an address from 0.0.0.0/8 block
+	DWORD index = htonl(DWORD(interfaceIndex));
+	int res = setsockopt(this->socket, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&index), sizeof(index));
+#elif M_OS == M_OS_MACOSX
+	int index = int(interfaceIndex);
+	int res = setsockopt(this->socket, IPPROTO_IP, IP_MULTICAST_IFINDEX, &index, sizeof(index));
+#elif M_OS == M_OS_UNIX
+	if(interfaceIndex != 0){
+		throw net::Exc("UDPSocket::SetMulticastInterface(): setting IPv4 multicast interface by index is not supported on this OS");
+	}
+	in_addr addr;
+	addr.s_addr = htonl(INADDR_ANY);
+	int res = setsockopt(this->socket, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof(addr));
+#else
+#	error "Unsupported OS"
+#endif
+
+	//not all systems allow IPv4 options on IPv6 socket, so only report the error for IPv4 socket
+	if(res != 0 && this->ipv4){
+		ThrowError(what, GetLastErrorCode());
+	}
+}
+
+
+
+void UDPSocket::SetMulticastLoop(bool enable){
+	if(!*this){
+		throw net::Exc("UDPSocket::SetMulticastLoop(): socket is not opened");
+	}
+
+	this->SetIPOption(IP_MULTICAST_LOOP, IPV6_MULTICAST_LOOP, enable ? 1 : 0, "UDPSocket::SetMulticastLoop(): setsockopt() failed");
+}
+
+
+
+void UDPSocket::SetMulticastTTL(unsigned ttl){
+	if(!*this){
+		throw net::Exc("UDPSocket::SetMulticastTTL(): socket is not opened");
+	}
+	if(ttl > 255){
+		throw net::Exc("UDPSocket::SetMulticastTTL(): TTL is greater than 255");
+	}
+
+	this->SetIPOption(IP_MULTICAST_TTL, IPV6_MULTICAST_HOPS, int(ttl), "UDPSocket::SetMulticastTTL(): setsockopt() failed");
+}
+
+
+
+void UDPSocket::SetBroadcast(bool enable){
+	this->SetOption(SOL_SOCKET, SO_BROADCAST, enable ? 1 : 0, "UDPSocket::SetBroadcast(): setsockopt(SO_BROADCAST) failed");
 }
 
 
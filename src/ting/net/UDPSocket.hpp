@@ -51,19 +51,25 @@ namespace net{
  */
 class UDPSocket : public Socket{
 	bool ipv4;
+	
+	//true if kernel supports UDP generic segmentation offload
+	bool gsoSupported = false;
 public:
 	UDPSocket(){}
 
 	UDPSocket(const UDPSocket&) = delete;
 
 	UDPSocket(UDPSocket&& s) :
-			Socket(std::move(s))
+			Socket(std::move(s)),
+			ipv4(s.ipv4),
+			gsoSupported(s.gsoSupported)
 	{}
 
 
 	UDPSocket& operator=(UDPSocket&& s){
 		this->Socket::operator=(std::move(s));
 		this->ipv4 = s.ipv4;
+		this->gsoSupported = s.gsoSupported;
 		return *this;
 	}
 
@@ -100,6 +106,20 @@ public:
 
 
 
+	/**
+	 * @brief Send datagram over UDP socket, non-throwing version.
+	 * Same as Send(ting::Buffer<const std::uint8_t>, const IPAddress&), but instead of throwing
+	 * an exception in case of error it returns the error code.
+	 * @param buf - buffer containing the datagram to send.
+	 * @param destinationIP - the destination IP address to send the datagram to.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error.
+	 * @return number of bytes actually sent, 0 in case of error.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf, const IPAddress& destinationIP, int& out_ErrorCode)NOEXCEPT;
+
+
+
 	/**
 	 * @brief Receive datagram.
 	 * Writes a datagram to the given buffer at once if it is available.
@@ -119,6 +139,384 @@ public:
 
 
 
+	/**
+	 * @brief Receive datagram, non-throwing version.
+	 * Same as Recv(ting::Buffer<std::uint8_t>, IPAddress&), but instead of throwing
+	 * an exception in case of error it returns the error code.
+	 * @param buf - reference to the buffer the received datagram will be stored to.
+	 * @param out_SenderIP - reference to the IP-address structure where the IP-address
+	 *                       of the sender will be stored.
+	 * @param out_ErrorCode - returns system error code (errno on *nix, WSAGetLastError() on Windows),
+	 *                        or 0 if there was no error.
+	 * @return number of bytes stored in the output buffer, 0 in case of error.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, int& out_ErrorCode)NOEXCEPT;
+
+
+
+	/**
+	 * @brief Maximum number of datagrams which can be sent or received in one batch call.
+	 * @return maximum number of datagrams processed by SendMany() and RecvMany() at once.
+	 */
+	static constexpr size_t DMaxBatchSize()NOEXCEPT{
+		return 64;
+	}
+
+
+
+	/**
+	 * @brief Description of a datagram to send.
+	 */
+	struct OutgoingDatagram{
+		/**
+		 * @brief Datagram data.
+		 */
+		ting::Buffer<const std::uint8_t> data;
+		
+		/**
+		 * @brief IP address to send the datagram to.
+		 */
+		IPAddress destination;
+	};
+
+
+
+	/**
+	 * @brief Send several datagrams at once.
+	 * Sends the datagrams in the given order, possibly to different destinations.
+	 * On Linux it is done with a single sendmmsg() system call, on other systems
+	 * the datagrams are sent one by one.
+	 * As with single datagram Send(), each datagram is sent either completely or not sent at all.
+	 * Only first DMaxBatchSize() datagrams are sent in one call.
+	 * @param datagrams - datagrams to send.
+	 * @return number of datagrams actually sent, these are the first datagrams of the given ones.
+	 *         Returns 0 if no datagrams can be sent at the current moment.
+	 */
+	size_t SendMany(ting::Buffer<const OutgoingDatagram> datagrams);
+
+
+
+	/**
+	 * @brief Description of a datagram to receive.
+	 */
+	struct IncomingDatagram{
+		/**
+		 * @brief Buffer to store the datagram to.
+		 * If datagram does not fit the buffer, its tail is lost.
+		 */
+		ting::Buffer<std::uint8_t> buf;
+		
+		/**
+		 * @brief Output, number of bytes stored in the buffer.
+		 */
+		size_t size;
+		
+		/**
+		 * @brief Output, IP address of the sender.
+		 */
+		IPAddress sender;
+	};
+
+
+
+	/**
+	 * @brief Receive several datagrams at once.
+	 * Receives as many available datagrams as there are entries in the given buffer,
+	 * but not more than DMaxBatchSize(). Does not block.
+	 * On Linux it is done with a single recvmmsg() system call, on other systems
+	 * the datagrams are received one by one.
+	 * @param datagrams - entries to receive datagrams to. For each received datagram
+	 *                    'size' and 'sender' fields are set.
+	 * @return number of received datagrams, these fill the first entries of the given buffer.
+	 *         Returns 0 if there are no datagrams available.
+	 */
+	size_t RecvMany(ting::Buffer<IncomingDatagram> datagrams);
+
+
+
+	/**
+	 * @brief Maximum number of segments which can be sent in one SendSegmented() call.
+	 * @return maximum number of segments.
+	 */
+	static constexpr size_t DMaxNumSegments()NOEXCEPT{
+		return 64;
+	}
+
+
+
+	/**
+	 * @brief Maximum total size of segments which can be sent in one SendSegmented() call.
+	 * @return maximum number of bytes.
+	 */
+	static constexpr size_t DMaxSegmentedSize()NOEXCEPT{
+		return 65507; //maximum UDP payload over IPv4
+	}
+
+
+
+	/**
+	 * @brief Check if segmentation offload is supported.
+	 * Tells whether SendSegmented() passes the whole buffer to the kernel at once
+	 * using UDP generic segmentation offload (Linux UDP_SEGMENT option),
+	 * or falls back to sending segments as separate datagrams.
+	 * @return true if segmentation offload is supported.
+	 */
+	bool IsSegmentationOffloadSupported()const NOEXCEPT{
+		return this->gsoSupported;
+	}
+
+
+
+	/**
+	 * @brief Send buffer as a sequence of same size datagrams.
+	 * Splits the buffer to datagrams of 'segmentSize' bytes, last datagram may be shorter,
+	 * and sends them to the same destination. If segmentation offload is supported the buffer is
+	 * passed to the kernel with a single system call and is segmented as late as possible,
+	 * which cuts per-datagram processing cost considerably. Otherwise, the datagrams are
+	 * sent with SendMany().
+	 * Not more than DMaxNumSegments() segments and not more than DMaxSegmentedSize() bytes
+	 * are sent in one call. Each datagram is either sent completely or not sent at all.
+	 * @param buf - buffer with data to send.
+	 * @param segmentSize - size of one datagram, must not be 0. Datagram should fit into network MTU,
+	 *                      otherwise segmentation offload will fail with an exception.
+	 * @param destinationIP - the destination IP address to send the datagrams to.
+	 * @return number of bytes sent, 0 if nothing could be sent at the current moment.
+	 *         Unless the whole buffer was sent, it is a multiple of 'segmentSize'.
+	 */
+	size_t SendSegmented(ting::Buffer<const std::uint8_t> buf, size_t segmentSize, const IPAddress& destinationIP);
+
+
+
+	/**
+	 * @brief Enable or disable receive coalescing.
+	 * When enabled, kernel may deliver several consecutive same size datagrams from the same sender
+	 * as one coalesced buffer (Linux UDP_GRO option). Such buffers should be received with
+	 * RecvCoalesced() which reports the size of the segments, because Recv() would return
+	 * coalesced datagrams as one datagram.
+	 * @param enable - whether to enable or disable receive coalescing.
+	 * @return true if the setting was applied.
+	 * @return false if receive coalescing is not supported by the system.
+	 */
+	bool SetReceiveCoalescing(bool enable);
+
+
+
+	/**
+	 * @brief Receive possibly coalesced datagrams.
+	 * Same as Recv(), but in case receive coalescing is enabled, the received data may
+	 * consist of several datagrams. Each of the datagrams is 'out_SegmentSize' bytes long,
+	 * except the last one which can be shorter.
+	 * The buffer should be able to hold DMaxSegmentedSize() bytes, otherwise coalesced datagrams
+	 * may be truncated.
+	 * @param buf - buffer to store received data to.
+	 * @param out_SenderIP - reference to the IP-address structure where the IP-address
+	 *                       of the sender will be stored.
+	 * @param out_SegmentSize - reference to variable where the datagram size is stored. If received data
+	 *                          was not coalesced it is set to the number of received bytes.
+	 * @return number of bytes stored in the output buffer.
+	 */
+	size_t RecvCoalesced(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, size_t& out_SegmentSize);
+
+
+
+	/**
+	 * @brief Kinds of per-datagram metadata which can be received along with datagrams.
+	 * See EnableRecvMeta().
+	 */
+	enum EMetaFlags{
+		META_NONE = 0,
+		META_TIMESTAMP = 1,    ///< kernel receive timestamp (SO_TIMESTAMPNS)
+		META_DESTINATION = 2,  ///< destination address of the datagram and receiving interface (IP_PKTINFO, IPV6_PKTINFO)
+		META_TTL_TOS = 4,      ///< TTL (hop limit) and ToS (traffic class) fields of the IP header
+		META_ALL = META_TIMESTAMP | META_DESTINATION | META_TTL_TOS
+	};
+
+
+
+	/**
+	 * @brief Metadata of a received datagram.
+	 * Fields which were not enabled with EnableRecvMeta() or which were not
+	 * provided by the system are left in their 'unknown' state.
+	 */
+	struct DatagramMeta{
+		/**
+		 * @brief Kernel receive timestamp.
+		 * Nanoseconds since the Epoch (system wall clock), 0 if unknown.
+		 */
+		std::uint64_t timestampNs;
+		
+		/**
+		 * @brief Destination address of the datagram.
+		 * Useful for sockets bound to any address, e.g. to tell unicast datagrams from
+		 * multicast or broadcast ones. Only valid if 'hasDestination' is true.
+		 */
+		IPAddress::Host destination;
+		
+		/**
+		 * @brief Tells whether 'destination' and 'interfaceIndex' are valid.
+		 */
+		bool hasDestination;
+		
+		/**
+		 * @brief Index of the network interface the datagram was received on, 0 if unknown.
+		 */
+		unsigned interfaceIndex;
+		
+		/**
+		 * @brief TTL of IPv4 datagram or hop limit of IPv6 datagram, -1 if unknown.
+		 */
+		int ttl;
+		
+		/**
+		 * @brief ToS of IPv4 datagram or traffic class of IPv6 datagram, -1 if unknown.
+		 */
+		int tos;
+	};
+
+
+
+	/**
+	 * @brief Enable receiving of datagram metadata.
+	 * Asks the system to deliver metadata along with each received datagram,
+	 * the metadata is retrieved with RecvWithMeta() or RecvManyWithMeta().
+	 * Kinds of metadata which are not in the flags are disabled. Enabled metadata
+	 * costs a bit of processing per datagram, so only enable what is needed.
+	 * Currently, metadata is only supported on Linux.
+	 * @param flags - bitwise OR of EMetaFlags values.
+	 * @return flags which were actually enabled, a subset of requested flags.
+	 */
+	std::uint32_t EnableRecvMeta(std::uint32_t flags);
+
+
+
+	/**
+	 * @brief Receive datagram along with its metadata.
+	 * Same as Recv(), but also returns the metadata enabled by EnableRecvMeta().
+	 * @param buf - buffer to store received datagram to.
+	 * @param out_SenderIP - reference to the IP-address structure where the IP-address
+	 *                       of the sender will be stored.
+	 * @param out_Meta - reference to the structure where metadata of the datagram will be stored.
+	 * @return number of bytes stored in the output buffer, 0 if there are no datagrams available.
+	 */
+	size_t RecvWithMeta(ting::Buffer<std::uint8_t> buf, IPAddress &out_SenderIP, DatagramMeta& out_Meta);
+
+
+
+	/**
+	 * @brief Receive several datagrams at once along with their metadata.
+	 * Same as RecvMany(), but also returns metadata of each received datagram.
+	 * @param datagrams - entries to receive datagrams to.
+	 * @param out_Meta - entries to store metadata of the received datagrams to, n'th entry corresponds to
+	 *                   n'th datagram. Not more datagrams than there are entries in this buffer are received.
+	 * @return number of received datagrams.
+	 */
+	size_t RecvManyWithMeta(ting::Buffer<IncomingDatagram> datagrams, ting::Buffer<DatagramMeta> out_Meta);
+
+
+
+	/**
+	 * @brief Join multicast group.
+	 * After joining the group the socket receives datagrams sent to the group address
+	 * and to the port the socket is bound to. Several groups can be joined by the same socket.
+	 * Joining IPv4 group by dual stack IPv6 socket works on Linux and Windows.
+	 * @param group - IPv4 or IPv6 multicast group address.
+	 * @param interfaceIndex - index of the network interface to join the group on,
+	 *                         0 to let the system choose the interface.
+	 * @throw net::Exc - in case of error, e.g. if the address is not a multicast address.
+	 */
+	void JoinGroup(const IPAddress::Host& group, unsigned interfaceIndex = 0);
+
+
+
+	/**
+	 * @brief Leave multicast group.
+	 * @param group - multicast group address which was previously joined with JoinGroup().
+	 * @param interfaceIndex - same interface index as was passed to JoinGroup().
+	 * @throw net::Exc - in case of error, e.g. if the group was not joined.
+	 */
+	void LeaveGroup(const IPAddress::Host& group, unsigned interfaceIndex = 0);
+
+
+
+	/**
+	 * @brief Join source-specific multicast group.
+	 * Same as JoinGroup(), but only datagrams sent to the group by the given source are received.
+	 * The method can be called several times with different sources to receive from all of them.
+	 * @param group - multicast group address.
+	 * @param source - address of the source to receive datagrams from.
+	 * @param interfaceIndex - index of the network interface to join the group on,
+	 *                         0 to let the system choose the interface.
+	 * @throw net::Exc - in case of error.
+	 */
+	void JoinSourceGroup(const IPAddress::Host& group, const IPAddress::Host& source, unsigned interfaceIndex = 0);
+
+
+
+	/**
+	 * @brief Leave source-specific multicast group.
+	 * Stops receiving datagrams from the source, other sources of the group stay joined.
+	 * @param group - multicast group address.
+	 * @param source - address of the source which was previously joined with JoinSourceGroup().
+	 * @param interfaceIndex - same interface index as was passed to JoinSourceGroup().
+	 * @throw net::Exc - in case of error.
+	 */
+	void LeaveSourceGroup(const IPAddress::Host& group, const IPAddress::Host& source, unsigned interfaceIndex = 0);
+
+
+
+	/**
+	 * @brief Set outgoing interface for multicast datagrams.
+	 * @param interfaceIndex - index of the network interface to send multicast datagrams through,
+	 *                         0 to let the system choose the interface.
+	 * @throw net::Exc - in case of error.
+	 */
+	void SetMulticastInterface(unsigned interfaceIndex);
+
+
+
+	/**
+	 * @brief Enable or disable multicast loopback.
+	 * When enabled, multicast datagrams sent by the socket are also delivered to the
+	 * sockets of the local host which have joined the group. Enabled by default.
+	 * @param enable - whether to enable or disable multicast loopback.
+	 * @throw net::Exc - in case of error.
+	 */
+	void SetMulticastLoop(bool enable);
+
+
+
+	/**
+	 * @brief Set TTL of outgoing multicast datagrams.
+	 * For IPv6 it is the hop limit. Default is 1, i.e. multicast datagrams do not leave the local network.
+	 * @param ttl - time to live, from 0 to 255.
+	 * @throw net::Exc - in case of error.
+	 */
+	void SetMulticastTTL(unsigned ttl);
+
+
+
+	/**
+	 * @brief Enable or disable sending of broadcast datagrams.
+	 * Broadcast is enabled when the socket is opened.
+	 * @param enable - whether to allow or disallow sending datagrams to broadcast addresses.
+	 * @throw net::Exc - in case of error.
+	 */
+	void SetBroadcast(bool enable);
+
+
+
+private:
+	//if out_Meta is not null, it should point to array of at least datagrams.size() entries
+	size_t RecvManyTo(ting::Buffer<IncomingDatagram> datagrams, DatagramMeta* out_Meta);
+
+	//joins or leaves multicast group, 'source' is null for any-source membership
+	void ChangeMembership(int name, const IPAddress::Host& group, const IPAddress::Host* source, unsigned interfaceIndex, const char* what);
+
+	//sets IPv4 option or IPv6 option, dual stack socket gets both, because it sends IPv4 datagrams too
+	void SetIPOption(int nameIPv4, int nameIPv6, int value, const char* what);
+
+
+
 #if M_OS == M_OS_WINDOWS
 private:
 	void SetWaitingEvents(std::uint32_t flagsToWaitFor)override;
@@ -0,0 +1,146 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include "UnixSocket.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Unix domain datagram socket.
+ * Connectionless socket for exchanging datagrams between processes on the same host,
+ * the counterpart of UDPSocket for Unix domain. Unlike UDP, Unix domain datagrams
+ * are reliable and are never reordered.
+ */
+class UnixDatagramSocket : public UnixSocket{
+public:
+	/**
+	 * @brief Creates an invalid (unopened) Unix datagram socket.
+	 */
+	UnixDatagramSocket(){}
+	
+	UnixDatagramSocket(const UnixDatagramSocket&) = delete;
+	
+	UnixDatagramSocket(UnixDatagramSocket&& s) :
+			UnixSocket(std::move(s))
+	{}
+	
+	UnixDatagramSocket& operator=(const UnixDatagramSocket&) = delete;
+	
+	UnixDatagramSocket& operator=(UnixDatagramSocket&& s){
+		this->UnixSocket::operator=(std::move(s));
+		return *this;
+	}
+	
+	
+	
+	/**
+	 * @brief Open the socket.
+	 * Same as for UnixServerSocket, file system entry created for the socket is not removed
+	 * when the socket is closed.
+	 * @param path - address to bind the socket to. If empty string is passed then the socket is
+	 *               left unbound, such socket can send datagrams but the receivers will not be able to reply.
+	 * @throw net::Exc - in case of error.
+	 */
+	void Open(const std::string& path = std::string());
+	
+	
+	
+	/**
+	 * @brief Send datagram.
+	 * The datagram is either sent as a whole or not sent at all.
+	 * @param buf - buffer with data to send.
+	 * @param destination - address of the receiving socket.
+	 * @return number of bytes sent, 0 if the socket is not ready to send, e.g. if the receiver's queue is full.
+	 * @throw net::Exc - in case of error.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf, const std::string& destination){
+		return this->SendMsg(buf, ting::Buffer<const int>(), &destination, "UnixDatagramSocket::Send(): sendmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Send datagram along with file descriptors.
+	 * See UnixStreamSocket::Send() for details about file descriptors passing.
+	 * @param buf - buffer with data to send.
+	 * @param destination - address of the receiving socket.
+	 * @param fds - file descriptors to pass, not more than DMaxNumFds().
+	 * @return number of bytes sent, 0 if the socket is not ready to send.
+	 * @throw net::Exc - in case of error.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf, const std::string& destination, ting::Buffer<const int> fds){
+		return this->SendMsg(buf, fds, &destination, "UnixDatagramSocket::Send(): sendmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Receive datagram.
+	 * If the buffer is too small to fit the whole datagram the rest of the datagram is discarded.
+	 * Any file descriptors attached to the datagram are closed.
+	 * @param buf - buffer where to put received data.
+	 * @param out_Sender - returns address of the sending socket, empty string if the sender is unbound.
+	 * @return number of bytes received, 0 if there were no datagrams available.
+	 * @throw net::Exc - in case of error.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf, std::string& out_Sender){
+		size_t numFds;
+		return this->RecvMsg(buf, ting::Buffer<int>(), numFds, &out_Sender, "UnixDatagramSocket::Recv(): recvmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Receive datagram and file descriptors.
+	 * See UnixStreamSocket::Recv() for details about file descriptors passing.
+	 * @param buf - buffer where to put received data.
+	 * @param out_Sender - returns address of the sending socket, empty string if the sender is unbound.
+	 * @param out_Fds - buffer where to put received file descriptors.
+	 * @param out_NumFds - returns number of received file descriptors.
+	 * @return number of bytes received, 0 if there were no datagrams available.
+	 * @throw net::Exc - in case of error.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf, std::string& out_Sender, ting::Buffer<int> out_Fds, size_t& out_NumFds){
+		return this->RecvMsg(buf, out_Fds, out_NumFds, &out_Sender, "UnixDatagramSocket::Recv(): recvmsg() failed");
+	}
+};//~class UnixDatagramSocket
+
+
+
+}//~namespace
+}//~namespace
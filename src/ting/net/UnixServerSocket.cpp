@@ -0,0 +1,94 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "UnixServerSocket.hpp"
+
+#include <sstream>
+
+#if M_OS != M_OS_LINUX
+#	include <fcntl.h>
+#endif
+
+
+
+using namespace ting::net;
+
+
+
+void UnixServerSocket::Open(const std::string& path, std::uint16_t queueLength){
+	this->Create(SOCK_STREAM, "UnixServerSocket::Open(): could not create socket");
+	this->Bind(path, "UnixServerSocket::Open(): bind() failed");
+	
+	if(listen(this->socket, int(queueLength)) != 0){
+		int errorCode = GetLastErrorCode();
+		this->Close();
+		ThrowError("UnixServerSocket::Open(): listen() failed", errorCode);
+	}
+}
+
+
+
+UnixStreamSocket UnixServerSocket::Accept(){
+	if(!*this){
+		throw net::Exc("UnixServerSocket::Accept(): the socket is not opened");
+	}
+	
+	this->ClearCanReadFlag();
+	
+	UnixStreamSocket sock;
+	
+	while(true){
+#if M_OS == M_OS_LINUX
+		//create the socket in non-blocking mode right away, saves system calls
+		sock.socket = ::accept4(this->socket, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		sock.socket = ::accept(this->socket, 0, 0);
+#endif
+		if(sock.socket != DInvalidSocket()){
+			break;
+		}
+		
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			return sock;//no connections to be accepted, return invalid socket
+		}
+		ThrowError("UnixServerSocket::Accept(): accept() failed", errorCode);
+	}
+	
+#if M_OS != M_OS_LINUX
+	try{
+		sock.SetNonBlockingMode();
+	}catch(...){
+		sock.Close();
+		throw;
+	}
+	fcntl(sock.socket, F_SETFD, FD_CLOEXEC);
+#endif
+	
+	return sock;
+}
@@ -0,0 +1,100 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include "UnixSocket.hpp"
+#include "UnixStreamSocket.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Unix domain server socket.
+ * Listens for new connections on a Unix domain address and accepts them
+ * creating UnixStreamSocket for each connection, the counterpart of TCPServerSocket for Unix domain.
+ */
+class UnixServerSocket : public UnixSocket{
+public:
+	/**
+	 * @brief Creates an invalid (unopened) Unix server socket.
+	 */
+	UnixServerSocket(){}
+	
+	UnixServerSocket(const UnixServerSocket&) = delete;
+	
+	UnixServerSocket(UnixServerSocket&& s) :
+			UnixSocket(std::move(s))
+	{}
+	
+	UnixServerSocket& operator=(const UnixServerSocket&) = delete;
+	
+	UnixServerSocket& operator=(UnixServerSocket&& s){
+		this->UnixSocket::operator=(std::move(s));
+		return *this;
+	}
+	
+	
+	
+	/**
+	 * @brief Open listening socket.
+	 * Note, that file system entry created for the socket by this method is not removed when
+	 * the socket is closed, so it is up to user to unlink() it. Binding to the path of
+	 * already existing file system entry fails, so stale entry should be removed before opening the socket.
+	 * Abstract namespace addresses do not have this problem.
+	 * @param path - address to listen on, see UnixSocket for details.
+	 * @param queueLength - the maximum length of the queue of pending connections.
+	 * @throw net::Exc - in case of error.
+	 */
+	void Open(const std::string& path, std::uint16_t queueLength = 50);
+	
+	
+	
+	/**
+	 * @brief Accepts one of the pending connections, non-blocking.
+	 * Accepts one of the pending connections and returns a Unix stream socket object which represents
+	 * either a valid connected socket or an invalid socket object.
+	 * This function does not block if there is no any pending connections, it just returns invalid
+	 * socket object in this case.
+	 * @return UnixStreamSocket object. One of the pending connections or invalid socket object.
+	 * @throw net::Exc - in case of error.
+	 */
+	UnixStreamSocket Accept();
+};//~class UnixServerSocket
+
+
+
+}//~namespace
+}//~namespace
@@ -0,0 +1,338 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+#include "UnixSocket.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <sstream>
+
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+
+using namespace ting::net;
+
+
+
+namespace{
+
+socklen_t FillSockaddr(sockaddr_un& sa, const std::string& path, const char* what){
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	
+	bool isAbstract = path.size() != 0 && path[0] == '\0';
+	
+#if M_OS != M_OS_LINUX
+	if(isAbstract){
+		std::stringstream ss;
+		ss << what << ": abstract namespace addresses are not supported on this OS";
+		throw ting::net::Exc(ss.str());
+	}
+#endif
+	
+	//for file system paths there should be space for terminating 0
+	if(path.size() + (isAbstract ? 0 : 1) > sizeof(sa.sun_path)){
+		std::stringstream ss;
+		ss << what << ": address is too long";
+		throw ting::net::Exc(ss.str());
+	}
+	memcpy(sa.sun_path, path.c_str(), path.size());
+	
+	//length of abstract address is determined by the address size only, without terminating 0
+	return socklen_t(offsetof(sockaddr_un, sun_path) + path.size() + (isAbstract ? 0 : 1));
+}
+
+
+
+std::string AddressFromSockaddr(const sockaddr_un& sa, socklen_t len){
+	if(len <= socklen_t(offsetof(sockaddr_un, sun_path))){
+		return std::string();//unnamed socket
+	}
+	
+	size_t pathLen = len - offsetof(sockaddr_un, sun_path);
+	if(sa.sun_path[0] == '\0'){
+		return std::string(sa.sun_path, pathLen);//abstract address
+	}
+	
+	//path may or may not be 0-terminated
+	return std::string(sa.sun_path, strnlen(sa.sun_path, pathLen));
+}
+
+}//~namespace
+
+
+
+void UnixSocket::Create(int type, const char* what){
+	if(*this){
+		std::stringstream ss;
+		ss << what << ": socket already opened";
+		throw net::Exc(ss.str());
+	}
+	
+#if M_OS == M_OS_LINUX
+	this->socket = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(this->socket == DInvalidSocket()){
+		ThrowError(what, GetLastErrorCode());
+	}
+#else
+	this->socket = ::socket(AF_UNIX, type, 0);
+	if(this->socket == DInvalidSocket()){
+		ThrowError(what, GetLastErrorCode());
+	}
+	
+	try{
+		this->SetNonBlockingMode();
+	}catch(...){
+		this->Close();
+		throw;
+	}
+	fcntl(this->socket, F_SETFD, FD_CLOEXEC);
+#endif
+	
+	this->ClearAllReadinessFlags();
+}
+
+
+
+void UnixSocket::Bind(const std::string& path, const char* what){
+	sockaddr_un sa;
+	socklen_t len;
+	try{
+		len = FillSockaddr(sa, path, what);
+	}catch(...){
+		this->Close();
+		throw;
+	}
+	
+	if(bind(this->socket, reinterpret_cast<sockaddr*>(&sa), len) != 0){
+		int errorCode = GetLastErrorCode();
+		this->Close();
+		ThrowError(what, errorCode);
+	}
+}
+
+
+
+void UnixSocket::Connect(const std::string& path, const char* what){
+	sockaddr_un sa;
+	socklen_t len;
+	try{
+		len = FillSockaddr(sa, path, what);
+	}catch(...){
+		this->Close();
+		throw;
+	}
+	
+	while(true){
+		if(connect(this->socket, reinterpret_cast<sockaddr*>(&sa), len) == 0){
+			return;
+		}
+		
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEInProgress()){
+			//connection will be completed asynchronously
+			return;
+		}
+		
+		this->Close();
+		ThrowError(what, errorCode);
+	}
+}
+
+
+
+size_t UnixSocket::SendMsg(
+		ting::Buffer<const std::uint8_t> buf,
+		ting::Buffer<const int> fds,
+		const std::string* destination,
+		const char* what
+	)
+{
+	if(!*this){
+		std::stringstream ss;
+		ss << what << ": socket is not opened";
+		throw net::Exc(ss.str());
+	}
+	
+	if(fds.size() > DMaxNumFds()){
+		std::stringstream ss;
+		ss << what << ": too many file descriptors to pass";
+		throw net::Exc(ss.str());
+	}
+	
+	this->ClearCanWriteFlag();
+	
+	iovec iov;
+	iov.iov_base = const_cast<std::uint8_t*>(buf.begin());
+	iov.iov_len = buf.size();
+	
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	
+	sockaddr_un sa;
+	if(destination){
+		msg.msg_namelen = FillSockaddr(sa, *destination, what);
+		msg.msg_name = &sa;
+	}
+	
+	union{
+		char buf[CMSG_SPACE(sizeof(int) * DMaxNumFds())];
+		cmsghdr align;
+	}control;
+	
+	if(fds.size() != 0){
+		msg.msg_control = control.buf;
+		msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+		
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+		memcpy(CMSG_DATA(cmsg), fds.begin(), sizeof(int) * fds.size());
+	}
+	
+	while(true){
+		ssize_t len = sendmsg(this->socket, &msg, 0);
+		if(len >= 0){
+			return size_t(len);
+		}
+		
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//can't send more bytes, return 0 bytes sent
+			return 0;
+		}
+		ThrowError(what, errorCode);
+	}
+}
+
+
+
+size_t UnixSocket::RecvMsg(
+		ting::Buffer<std::uint8_t> buf,
+		ting::Buffer<int> out_Fds,
+		size_t& out_NumFds,
+		std::string* out_Sender,
+		const char* what
+	)
+{
+	//the 'can read' flag shall be cleared even if this function fails, see TCPSocket::Recv()
+	this->ClearCanReadFlag();
+	
+	out_NumFds = 0;
+	
+	if(!*this){
+		std::stringstream ss;
+		ss << what << ": socket is not opened";
+		throw net::Exc(ss.str());
+	}
+	
+	iovec iov;
+	iov.iov_base = buf.begin();
+	iov.iov_len = buf.size();
+	
+	sockaddr_un sa;
+	
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	
+	if(out_Sender){
+		msg.msg_name = &sa;
+		msg.msg_namelen = sizeof(sa);
+	}
+	
+	union{
+		char buf[CMSG_SPACE(sizeof(int) * DMaxNumFds())];
+		cmsghdr align;
+	}control;
+	
+	if(out_Fds.size() != 0){
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+	}
+	
+#if M_OS == M_OS_LINUX
+	//received descriptors should not leak to child processes
+	const int flags = MSG_CMSG_CLOEXEC;
+#else
+	const int flags = 0;
+#endif
+	
+	ssize_t len;
+	while(true){
+		len = recvmsg(this->socket, &msg, flags);
+		if(len >= 0){
+			break;
+		}
+		
+		int errorCode = GetLastErrorCode();
+		if(errorCode == DEIntr()){
+			continue;
+		}else if(errorCode == DEAgain()){
+			//no data available, return 0 bytes received
+			return 0;
+		}
+		ThrowError(what, errorCode);
+	}
+	
+	if(out_Sender){
+		*out_Sender = AddressFromSockaddr(sa, msg.msg_namelen);
+	}
+	
+	for(cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+		if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS){
+			continue;
+		}
+		
+		size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		std::array<int, DMaxNumFds()> fds;
+		ASSERT(num <= fds.size())
+		memcpy(&*fds.begin(), CMSG_DATA(cmsg), sizeof(int) * num);
+		
+		for(size_t i = 0; i != num; ++i){
+			if(out_NumFds != out_Fds.size()){
+				out_Fds[out_NumFds] = fds[i];
+				++out_NumFds;
+			}else{
+				close(fds[i]);//no space for the descriptor, do not leak it
+			}
+		}
+	}
+	
+	return size_t(len);
+}
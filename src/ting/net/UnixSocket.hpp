@@ -0,0 +1,121 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include <string>
+
+#include "Socket.hpp"
+#include "../Buffer.hpp"
+
+
+#if M_OS != M_OS_LINUX && M_OS != M_OS_MACOSX && M_OS != M_OS_UNIX
+#	error "Unix domain sockets are not supported on this OS"
+#endif
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Base class for Unix domain sockets.
+ * Unix domain sockets are used for communication between processes on the same host.
+ * They do not involve network protocol stack, so they are cheaper than TCP or UDP sockets over loopback.
+ * Unix domain sockets are addressed by file system paths. On Linux, addresses can also be in the
+ * abstract namespace, such addresses do not appear in the file system and vanish when all sockets
+ * bound to them are closed, see AbstractAddress().
+ * Unix domain sockets also allow passing opened file descriptors to another process (SCM_RIGHTS).
+ */
+class UnixSocket : public Socket{
+public:
+	/**
+	 * @brief Maximum number of file descriptors which can be passed with one message.
+	 */
+	static constexpr size_t DMaxNumFds()NOEXCEPT{
+		return 16;
+	}
+	
+	/**
+	 * @brief Make abstract namespace address.
+	 * Abstract namespace is Linux only.
+	 * @param name - name of the address in the abstract namespace.
+	 * @return address string which can be passed to methods of Unix domain sockets.
+	 */
+	static std::string AbstractAddress(const std::string& name){
+		return std::string(1, '\0') + name;
+	}
+	
+protected:
+	UnixSocket(){}
+	
+	UnixSocket(UnixSocket&& s) :
+			Socket(std::move(s))
+	{}
+	
+	UnixSocket& operator=(UnixSocket&& s){
+		this->Socket::operator=(std::move(s));
+		return *this;
+	}
+	
+	//creates non-blocking socket of given type (SOCK_STREAM or SOCK_DGRAM)
+	void Create(int type, const char* what);
+	
+	//binds socket to given address, closes the socket on error
+	void Bind(const std::string& path, const char* what);
+	
+	//connects socket to given address, closes the socket on error
+	void Connect(const std::string& path, const char* what);
+	
+	//returns 0 if socket is not ready, throws on error
+	size_t SendMsg(
+			ting::Buffer<const std::uint8_t> buf,
+			ting::Buffer<const int> fds,
+			const std::string* destination,
+			const char* what
+		);
+	
+	//returns 0 if there is no data available, throws on error
+	size_t RecvMsg(
+			ting::Buffer<std::uint8_t> buf,
+			ting::Buffer<int> out_Fds,
+			size_t& out_NumFds,
+			std::string* out_Sender,
+			const char* what
+		);
+};//~class UnixSocket
+
+
+
+}//~namespace
+}//~namespace
@@ -0,0 +1,146 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include "UnixSocket.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+//forward declarations
+class UnixServerSocket;
+
+
+
+/**
+ * @brief Unix domain stream socket.
+ * Connection-oriented socket for communication between processes on the same host,
+ * the counterpart of TCPSocket for Unix domain.
+ */
+class UnixStreamSocket : public UnixSocket{
+	friend class ting::net::UnixServerSocket;
+public:
+	/**
+	 * @brief Constructs an invalid Unix stream socket object.
+	 */
+	UnixStreamSocket(){}
+	
+	UnixStreamSocket(const UnixStreamSocket&) = delete;
+	
+	UnixStreamSocket(UnixStreamSocket&& s) :
+			UnixSocket(std::move(s))
+	{}
+	
+	UnixStreamSocket& operator=(const UnixStreamSocket&) = delete;
+	
+	UnixStreamSocket& operator=(UnixStreamSocket&& s){
+		this->UnixSocket::operator=(std::move(s));
+		return *this;
+	}
+	
+	
+	
+	/**
+	 * @brief Connects the socket.
+	 * Unlike TCP, connecting of Unix domain socket is completed right away, so the socket is
+	 * ready for use after this method returns.
+	 * @param path - address of the server socket, see UnixSocket for details.
+	 * @throw net::Exc - in case of error, e.g. if there is no server listening on the address
+	 *                   or if the queue of pending connections of the server is full.
+	 */
+	void Open(const std::string& path);
+	
+	
+	
+	/**
+	 * @brief Send data to connected socket.
+	 * Same as TCPSocket::Send(), does not guarantee that the whole buffer will be sent.
+	 * @param buf - buffer with data to send.
+	 * @return the number of bytes actually sent.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf){
+		return this->SendMsg(buf, ting::Buffer<const int>(), nullptr, "UnixStreamSocket::Send(): sendmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Send data along with file descriptors.
+	 * File descriptors are duplicated to the receiving process as if by dup(). The descriptors are
+	 * attached to the first byte of the data, so at least 1 byte of data must be sent, if 0 is returned then
+	 * the descriptors were not sent either. The descriptors stay opened in the sending process.
+	 * @param buf - buffer with data to send.
+	 * @param fds - file descriptors to pass, not more than DMaxNumFds().
+	 * @return the number of bytes actually sent.
+	 */
+	size_t Send(ting::Buffer<const std::uint8_t> buf, ting::Buffer<const int> fds){
+		return this->SendMsg(buf, fds, nullptr, "UnixStreamSocket::Send(): sendmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Receive data from connected socket.
+	 * Same as TCPSocket::Recv(). Any file descriptors attached to the received data are closed.
+	 * @param buf - buffer where to put received data.
+	 * @return the number of bytes written to the buffer.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf){
+		size_t numFds;
+		return this->RecvMsg(buf, ting::Buffer<int>(), numFds, nullptr, "UnixStreamSocket::Recv(): recvmsg() failed");
+	}
+	
+	
+	
+	/**
+	 * @brief Receive data and file descriptors.
+	 * Received descriptors are owned by the caller, they should be closed when not needed anymore.
+	 * If there are more descriptors received than fit into the buffer, the rest are closed.
+	 * On Linux the received descriptors have close-on-exec flag set.
+	 * @param buf - buffer where to put received data.
+	 * @param out_Fds - buffer where to put received file descriptors.
+	 * @param out_NumFds - returns number of received file descriptors.
+	 * @return the number of bytes written to the buffer.
+	 */
+	size_t Recv(ting::Buffer<std::uint8_t> buf, ting::Buffer<int> out_Fds, size_t& out_NumFds){
+		return this->RecvMsg(buf, out_Fds, out_NumFds, nullptr, "UnixStreamSocket::Recv(): recvmsg() failed");
+	}
+};//~class UnixStreamSocket
+
+
+
+}//~namespace
+}//~namespace
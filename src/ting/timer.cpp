@@ -36,126 +36,425 @@ ting::IntrusiveSingleton<Lib>::T_Instance Lib::instance;
 
 
 
-bool Lib::TimerThread::RemoveTimer_ts(Timer* timer)NOEXCEPT{
+void Timer::PendingList::PushBack(Timer* t)NOEXCEPT{
+	ASSERT(t)
+	t->pendingNext = nullptr;
+	t->pendingPrev = this->last;
+	if(this->last){
+		this->last->pendingNext = t;
+	}else{
+		this->first = t;
+	}
+	this->last = t;
+	t->pendingList = this;
+}
+
+
+
+Timer* Timer::PendingList::PopFront()NOEXCEPT{
+	Timer* ret = this->first;
+	if(ret){
+		this->Remove(ret);
+	}
+	return ret;
+}
+
+
+
+void Timer::PendingList::Remove(Timer* t)NOEXCEPT{
+	ASSERT(t)
+	ASSERT(t->pendingList == this)
+	if(t->pendingPrev){
+		t->pendingPrev->pendingNext = t->pendingNext;
+	}else{
+		this->first = t->pendingNext;
+	}
+	if(t->pendingNext){
+		t->pendingNext->pendingPrev = t->pendingPrev;
+	}else{
+		this->last = t->pendingPrev;
+	}
+	t->pendingList = nullptr;
+}
+
+
+
+namespace{
+std::atomic<unsigned> nextLibId(0);
+}
+
+
+
+Lib::Lib(unsigned numDispatchThreads, unsigned numShards) :
+		timerThread(*this),
+		id(nextLibId++),
+		nextShard(0)
+{
+	ASSERT(numShards != 0)
+	for(unsigned i = 0; i != numShards; ++i){
+		this->shards.push_back(std::unique_ptr<Shard>(new Shard(*this, i)));
+	}
+
+	for(unsigned i = 0; i != numDispatchThreads; ++i){
+		this->dispatchThreads.push_back(std::unique_ptr<DispatchThread>(new DispatchThread(*this, numShards)));
+	}
+
+	for(auto& t : this->dispatchThreads){
+		t->Start();
+	}
+
+	this->timerThread.Start();
+}
+
+
+
+Lib::~Lib()NOEXCEPT{
+#ifdef DEBUG
+	for(auto& s : this->shards){
+		std::lock_guard<decltype(s->mutex)> mutexGuard(s->mutex);
+		ASSERT(s->timers.Size() == 0)
+	}
+#endif
+	this->timerThread.quitFlag = true;
+	this->timerThread.event.Set();
+	this->timerThread.Join();
+
+	for(auto& t : this->dispatchThreads){
+		t->quitFlag = true;
+		t->event.Set();
+		t->Join();
+	}
+}
+
+
+
+unsigned Lib::CurrentThreadShard()NOEXCEPT{
+	//shard assignment of the thread is cached, it is only valid for the library instance it was made by
+	struct Assignment{
+		unsigned libId;
+		unsigned shard;
+	};
+	static thread_local Assignment assignment = {unsigned(-1), 0};
+
+	if(assignment.libId != this->id){
+		assignment.libId = this->id;
+		assignment.shard = this->nextShard++;
+	}
+	return assignment.shard % this->shards.size();
+}
+
+
+
+bool Lib::Shard::RemoveTimer_ts(Timer* timer)NOEXCEPT{
 	ASSERT(timer)
-	std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+	std::unique_lock<decltype(this->mutex)> mutexGuard(this->mutex);
 
-	if(!timer->isRunning){
-		//lock and unlock the 'expired' mutex to make sure that the timer's callback
-		//has been called if the timer has expired and is awaiting the notification callback to be called.
-		std::lock_guard<decltype(this->expiredTimersNotifyMutex)> mutexGuard(this->expiredTimersNotifyMutex);
-		return false;
+	bool ret = false;
+
+	if(timer->IsInserted()){
+		//NOTE: no need to set the event, the thread will just wake up
+		//      a bit earlier than needed and recalculate the waiting time.
+		this->timers.Remove(*timer);
+		ret = true;
+	}
+
+	if(timer->isPending){
+		//cancel OnExpired() call
+		timer->isPending = false;
+		if(timer->pendingList){
+			timer->pendingList->Remove(timer);
+		}
+		ret = true;
 	}
 
-	//if isStarted flag is set then the timer will be stopped now, so
-	//change the flag
-	timer->isRunning = false;
+	//Periodic timer is re-armed before its OnExpired() is called, so the callback may be running
+	//even if the timer was found in the wheel. In any case, make sure that the callback has returned.
+	if(timer->isCalling && timer->callingThread != ting::mt::Thread::GetCurrentThreadID()){
+		++this->numCallWaiters;
+		this->callCompletedCond.wait(mutexGuard, [timer](){return !timer->isCalling;});
+		--this->numCallWaiters;
+	}
+
+	return ret;
+}
+
 
-	ASSERT(timer->i != this->timers.end())
 
-	//if that was the first timer, signal the semaphore about timer deletion in order to recalculate the waiting time
-	if(this->timers.begin() == timer->i){
-		this->sema.Signal();
+namespace{
+
+//converts nanoseconds to wheel ticks, rounding up, so the timer never expires earlier than requested
+inline std::uint64_t ToTicksRoundUp(std::chrono::nanoseconds ns){
+	ASSERT(ns.count() >= 0)
+	return (std::uint64_t(ns.count()) + 999) / 1000;
+}
+
+inline unsigned FindLastSetBit(std::uint64_t v)NOEXCEPT{
+	ASSERT(v != 0)
+#if M_COMPILER == M_COMPILER_GCC
+	return 63 - unsigned(__builtin_clzll(v));
+#else
+	unsigned ret = 0;
+	for(; v >>= 1;){
+		++ret;
 	}
+	return ret;
+#endif
+}
 
-	this->timers.erase(timer->i);
+//Returns ticks within [deadline, deadline + slack] which has as many low bits cleared
+//as possible. This way timers with nearby deadlines tend to expire at the same ticks.
+inline std::uint64_t ApplySlack(std::uint64_t deadline, std::uint64_t slack)NOEXCEPT{
+	if(slack == 0){
+		return deadline;
+	}
 
-	//was running
-	return true;
+	std::uint64_t limit = deadline + slack;
+	if(limit < deadline){
+		return deadline;//overflow
+	}
+
+	std::uint64_t diff = deadline ^ limit;
+	ASSERT(diff != 0)
+
+	//clear all bits lower than the highest differing bit, the result is still not less than deadline
+	std::uint64_t mask = (std::uint64_t(1) << FindLastSetBit(diff)) - 1;
+	return limit & ~mask;
 }
 
+}//~namespace
+
 
 
-void Lib::TimerThread::AddTimer_ts(Timer* timer, std::uint32_t timeout){
+void Lib::Shard::AddTimer_ts(Timer* timer, std::chrono::nanoseconds timeout, std::chrono::nanoseconds period, std::chrono::nanoseconds slack){
 	ASSERT(timer)
+	ASSERT(slack.count() >= 0)
 	std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
 
-	if(timer->isRunning){
-		throw ting::Exc("Lib::TimerThread::AddTimer(): timer is already running!");
+	if(timer->IsInserted()){
+		throw ting::Exc("Lib::Shard::AddTimer(): timer is already running!");
 	}
 
-	timer->isRunning = true;
+	timer->deadline = GetTicks() + ToTicksRoundUp(timeout);
+	timer->periodTicks = period.count() == 0 ? 0 : std::max(ToTicksRoundUp(period), std::uint64_t(1));
+	timer->slackTicks = std::uint64_t(slack.count()) / 1000;
 
-	std::uint64_t stopTicks = this->GetTicks() + std::uint64_t(timeout);
+	this->InsertTimer(timer);
+
+	//set the event about new timer addition in order to recalculate the waiting time,
+	//only needed if the timer expires earlier than the timer thread is going to visit the shard.
+	if(timer->Expiration() < this->wakeTicks){
+		this->wakeTicks = timer->Expiration();
+		this->wakeRequested = true;
+		this->lib.timerThread.event.Set();
+	}
+}
 
-	timer->i = this->timers.insert(
-			std::pair<std::uint64_t, Timer*>(stopTicks, timer)
-		);
 
-	ASSERT(timer->i != this->timers.end())
-	ASSERT(timer->i->second)
 
-	//signal the semaphore about new timer addition in order to recalculate the waiting time
-	this->sema.Signal();
+void Lib::Shard::InsertTimer(Timer* timer)NOEXCEPT{
+	this->timers.Insert(*timer, ApplySlack(timer->deadline, timer->slackTicks));
 }
 
 
 
-//override
-void Lib::TimerThread::Run(){
-	M_TIMER_TRACE(<< "Lib::TimerThread::Run(): enter" << std::endl)
+void Lib::Shard::RearmPeriodicTimer(Timer* timer, std::uint64_t ticks)NOEXCEPT{
+	ASSERT(timer->periodTicks != 0)
+	ASSERT(!timer->IsInserted())
 
-	while(!this->quitFlag){
-		std::uint32_t millis;
+	//next deadline is calculated from the previous one, so that the timer does not drift
+	timer->deadline += timer->periodTicks;
+	if(timer->deadline <= ticks){
+		//skip missed periods
+		timer->deadline += ((ticks - timer->deadline) / timer->periodTicks + 1) * timer->periodTicks;
+	}
+	ASSERT(timer->deadline > ticks)
 
-		while(true){
-			std::vector<Timer*> expiredTimers;
+	this->InsertTimer(timer);
+}
 
-			{
-				std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
 
-				std::uint64_t ticks = this->GetTicks();
 
-				for(Timer::T_TimerIter b = this->timers.begin(); b != this->timers.end(); b = this->timers.begin()){
-					if(b->first > ticks){
-						break;//~for
+void Lib::Shard::Dispatch(Timer* timer)NOEXCEPT{
+	ASSERT(timer)
+	if(timer->isPending){
+		//previous expiration of the timer is not handled yet, it will be handled once for both
+		return;
+	}
+	timer->isPending = true;
+
+	if(timer->queue){
+		ASSERT(timer->queueCell)
+		std::shared_ptr<Timer*> cell = timer->queueCell;
+		unsigned index = this->index;
+		timer->queue->PushMessage(
+				[cell, index](){
+					if(!Lib::IsCreated()){
+						return;
 					}
+					Lib::Inst().GetShard(index).CallQueuedTimer_ts(cell);
+				}
+			);
+		return;
+	}
 
-					Timer *timer = b->second;
-					//add the timer to list of expired timers
-					ASSERT(timer)
-					expiredTimers.push_back(timer);
+	auto& dispatchThreads = this->lib.dispatchThreads;
+	if(dispatchThreads.size() == 0){
+		this->pendingTimers.PushBack(timer);
+		return;
+	}
+
+	//always dispatch same timer to same thread, so its OnExpired() is not called concurrently
+	std::uint64_t hash = std::uint64_t(size_t(timer)) * 0x9e3779b97f4a7c15ULL;//multiplicative hashing to spread timers evenly
+	DispatchThread& t = *dispatchThreads[size_t(hash >> 32) % dispatchThreads.size()];
+	Timer::PendingList& list = t.pendingTimers[this->index];
+	bool wasEmpty = list.IsEmpty();
+	list.PushBack(timer);
+	if(wasEmpty){
+		t.event.Set();
+	}
+}
+
+
+
+void Lib::Shard::CallOnExpired(Timer* timer, std::unique_lock<std::mutex>& mutexGuard)NOEXCEPT{
+	ASSERT(timer->isPending)
+	ASSERT(!timer->isCalling)
+	timer->isPending = false;
+	timer->isCalling = true;
+	timer->callingThread = ting::mt::Thread::GetCurrentThreadID();
+
+	bool destroyed = false;
+	timer->destroyedFlag = &destroyed;
+
+	mutexGuard.unlock();
+	timer->OnExpired();
+	mutexGuard.lock();
+
+	//timer object is allowed to be destroyed from within its OnExpired()
+	if(!destroyed){
+		timer->destroyedFlag = nullptr;
+		timer->isCalling = false;
+	}
+	if(this->numCallWaiters != 0){
+		this->callCompletedCond.notify_all();
+	}
+}
 
-					//Change the expired timer state to not running.
-					//This should be done before the expired signal of the timer will be emitted.
-					timer->isRunning = false;
 
-					this->timers.erase(b);
-				}
 
-				if(expiredTimers.size() == 0){
-					ASSERT(this->timers.size() > 0) //if we have no expired timers here, then at least one timer should be running (the half-max-ticks timer).
+void Lib::Shard::CallPendingTimers_ts(Timer::PendingList& list)NOEXCEPT{
+	std::unique_lock<decltype(this->mutex)> mutexGuard(this->mutex);
 
-					//calculate new waiting time
-					ASSERT(this->timers.begin()->first > ticks)
-					ASSERT(this->timers.begin()->first - ticks <= std::uint64_t(std::uint32_t(-1)))
-					millis = std::uint32_t(this->timers.begin()->first - ticks);
+	while(Timer* timer = list.PopFront()){
+		this->CallOnExpired(timer, mutexGuard);
+	}
+}
 
-					//zero out the semaphore for optimization purposes
-					while(this->sema.Wait(0)){}
 
-					break;//~while(true)
+
+void Lib::Shard::CallQueuedTimer_ts(const std::shared_ptr<Timer*>& cell)NOEXCEPT{
+	std::unique_lock<decltype(this->mutex)> mutexGuard(this->mutex);
+
+	Timer* timer = *cell;
+	if(!timer || !timer->isPending){
+		//timer was stopped or destroyed
+		return;
+	}
+
+	this->CallOnExpired(timer, mutexGuard);
+}
+
+
+
+//override
+void Lib::DispatchThread::Run(){
+	while(!this->quitFlag){
+		this->event.Wait();
+		for(auto& s : this->lib.shards){
+			s->CallPendingTimers_ts(this->pendingTimers[s->index]);
+		}
+	}
+}
+
+
+
+namespace{
+inline std::uint64_t DMaxWaitTicks(){
+	return std::uint64_t(1) << 32; //about 71 minutes
+}
+}
+
+
+
+bool Lib::Shard::Advance_ts(std::uint64_t ticks)NOEXCEPT{
+	std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+
+	this->timers.Advance(
+			ticks,
+			[this, ticks](TimingWheel::Node& n){
+				Timer* timer = static_cast<Timer*>(&n);
+				if(timer->periodTicks != 0){
+					this->RearmPeriodicTimer(timer, ticks);
 				}
-				
-				this->expiredTimersNotifyMutex.lock();
+				this->Dispatch(timer);
 			}
+		);
 
-			try{
-				//emit expired signal for expired timers
-				for(std::vector<Timer*>::iterator i = expiredTimers.begin(); i != expiredTimers.end(); ++i){
-					ASSERT(*i)
-					(*i)->OnExpired();
-				}
-			}catch(...){
-				//no exceptions should be thrown by this code. Especially we don't want them here because
-				//mutex locking/unlocking is used without mutex guard.
-				ASSERT(false)
+	std::uint64_t nextTicks = this->timers.NextEventTicks();
+	ASSERT(nextTicks > ticks)
+	if(nextTicks != std::uint64_t(-1)){
+		//limit waiting time to avoid overflow when converting to nanoseconds,
+		//the thread will just wake up and recalculate the waiting time.
+		nextTicks = ticks + std::min(nextTicks - ticks, DMaxWaitTicks());
+	}
+	this->wakeTicks = nextTicks;
+
+	return !this->pendingTimers.IsEmpty();
+}
+
+
+
+//override
+void Lib::TimerThread::Run(){
+	M_TIMER_TRACE(<< "Lib::TimerThread::Run(): enter" << std::endl)
+
+	while(!this->quitFlag){
+		std::uint64_t ticks = GetTicks();
+
+		//ticks at which the thread has to wake up, std::uint64_t(-1) means wait until signalled
+		std::uint64_t wakeTicks = std::uint64_t(-1);
+
+		bool hasPending = false;
+
+		for(auto& s : this->lib.shards){
+			//Clear the request before visiting the shard, so that the request made after
+			//the visit is not lost, it will be handled on next iteration since the event is set.
+			if(!s->wakeRequested.exchange(false) && s->wakeTicks > ticks){
+				//nothing to do in this shard yet, do not contend on its mutex
+				wakeTicks = std::min(wakeTicks, std::uint64_t(s->wakeTicks));
+				continue;
+			}
+
+			if(s->Advance_ts(ticks)){
+				hasPending = true;
 			}
-			
-			this->expiredTimersNotifyMutex.unlock();
+			wakeTicks = std::min(wakeTicks, std::uint64_t(s->wakeTicks));
 		}
 
-		this->sema.Wait(millis);
+		if(hasPending){
+			//call expired timers which are dispatched to this thread and check for expired timers again
+			for(auto& s : this->lib.shards){
+				s->CallPendingTimers_ts(s->pendingTimers);
+			}
+			continue;
+		}
+
+		if(wakeTicks == std::uint64_t(-1)){
+			//no running timers
+			this->event.Wait();
+		}else if(wakeTicks > ticks){
+			this->event.Wait(std::chrono::microseconds(wakeTicks - ticks));
+		}
 	}//~while(!this->quitFlag)
 
 	M_TIMER_TRACE(<< "Lib::TimerThread::Run(): exit" << std::endl)
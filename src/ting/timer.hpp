@@ -54,6 +54,7 @@ THE SOFTWARE. */
 
 #elif M_OS == M_OS_MACOSX
 #	include<sys/time.h>
+#	include <mach/mach_time.h>
 
 #elif M_OS == M_OS_LINUX
 #include <ctime>
@@ -64,16 +65,22 @@ THE SOFTWARE. */
 
 
 #include <vector>
-#include <map>
+#include <chrono>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "debug.hpp"
 #include "types.hpp"
 #include "Singleton.hpp"
 #include "math.hpp"
+#include "TimingWheel.hpp"
 
 #include "mt/Thread.hpp"
-#include "mt/Semaphore.hpp"
+#include "mt/Event.hpp"
+#include "mt/Queue.hpp"
 
 
 
@@ -120,29 +127,121 @@ inline std::uint32_t GetTicks(){
 
 
 
+/**
+ * @brief Get constantly increasing nanosecond ticks.
+ * Unlike GetTicks(), returned value is 64 bit, so in practice it never wraps around.
+ * The ticks come from monotonic clock, i.e. they are not affected by system time adjustments.
+ * It is not guaranteed that the ticks counting started at the system start.
+ * @return constantly increasing nanosecond ticks.
+ */
+inline std::uint64_t GetNanoTicks(){
+#if M_OS == M_OS_WINDOWS
+	static LARGE_INTEGER perfCounterFreq = {{0, 0}};
+	if(perfCounterFreq.QuadPart == 0){
+		if(QueryPerformanceFrequency(&perfCounterFreq) == FALSE){
+			//looks like the system does not support high resolution tick counter
+			return std::uint64_t(GetTickCount64()) * 1000000;
+		}
+	}
+	LARGE_INTEGER ticks;
+	if(QueryPerformanceCounter(&ticks) == FALSE){
+		return std::uint64_t(GetTickCount64()) * 1000000;
+	}
+
+	//split the conversion to avoid overflow of intermediate multiplication
+	std::uint64_t freq = std::uint64_t(perfCounterFreq.QuadPart);
+	std::uint64_t t = std::uint64_t(ticks.QuadPart);
+	return (t / freq) * 1000000000 + ((t % freq) * 1000000000) / freq;
+#elif M_OS == M_OS_MACOSX
+	static mach_timebase_info_data_t timebase = {0, 0};
+	if(timebase.denom == 0){
+		mach_timebase_info(&timebase);
+	}
+	std::uint64_t t = mach_absolute_time();
+	return (t / timebase.denom) * timebase.numer + ((t % timebase.denom) * timebase.numer) / timebase.denom;
+#elif M_OS == M_OS_LINUX
+	timespec ts;
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) == -1){
+		throw ting::Exc("GetNanoTicks(): clock_gettime() returned error");
+	}
+
+	return std::uint64_t(ts.tv_sec) * 1000000000 + std::uint64_t(ts.tv_nsec);
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
 /**
  * @brief General purpose timer.
- * This is a class representing a timer. Its accuracy is not expected to be high,
- * approximately it is tens of milliseconds, i.e. 0.01 second.
+ * This is a class representing a timer. Timeouts are measured using monotonic nanosecond
+ * clock (see GetNanoTicks()) and are kept with microsecond resolution, so the accuracy is
+ * mostly limited by the scheduling latency of the system, which is typically tens of microseconds.
  * Before using the timers it is necessary to initialize the timer library, see
  * description of ting::TimerLib class for details.
+ * Running timers are kept in a hierarchical timing wheel, so starting and stopping
+ * a timer costs O(1) and does not allocate memory.
+ * Timer can be one-shot (see Start()) or periodic (see StartPeriodic()).
+ * Both kinds of timers accept a slack, i.e. the amount of time by which the expiration
+ * can be delayed. Timer library uses the slack to expire timers with nearby deadlines
+ * at the same moment, thus reducing the number of timer thread wakeups.
  */
-class Timer{
+class Timer : private TimingWheel::Node{
 	friend class Lib;
 
-	//This constant is for testing purposes.
-	//Should be set to std::uint32_t(-1) in release.
-	inline static std::uint32_t DMaxTicks(){
-		return std::uint32_t(-1);
-	}
-	
-	bool isRunning = false;//true if timer has been started and has not stopped yet
+	//Intrusive list of expired timers waiting for their OnExpired() to be called.
+	class PendingList{
+		Timer* first = nullptr;
+		Timer* last = nullptr;
+	public:
+		bool IsEmpty()const NOEXCEPT{
+			return this->first == nullptr;
+		}
 
-private:
-	typedef std::multimap<std::uint64_t, Timer*> T_TimerList;
-	typedef T_TimerList::iterator T_TimerIter;
+		void PushBack(Timer* t)NOEXCEPT;
 
-	T_TimerIter i;//if timer is running, this is the iterator into the map of timers
+		Timer* PopFront()NOEXCEPT;
+
+		void Remove(Timer* t)NOEXCEPT;
+	};
+
+	//Index of the timer library shard the timer belongs to, assigned on first Start().
+	//Timer stays in the same shard for its whole life time.
+	std::atomic<unsigned> shardIndex;
+
+	//All the following fields are protected by the mutex of the shard.
+
+	//deadline of the timer in wheel ticks, without slack applied
+	std::uint64_t deadline;
+
+	//period in wheel ticks, 0 for one-shot timer
+	std::uint64_t periodTicks = 0;
+
+	//slack in wheel ticks
+	std::uint64_t slackTicks = 0;
+
+	//true if timer has expired and its OnExpired() has not been called yet
+	bool isPending = false;
+
+	//pending list the timer is in, in case it is pending and is not dispatched to a queue
+	PendingList* pendingList = nullptr;
+	Timer* pendingPrev;
+	Timer* pendingNext;
+
+	//true while OnExpired() is being called
+	bool isCalling = false;
+	ting::mt::Thread::T_ThreadID callingThread;
+
+	//points to flag which is set if timer is destroyed from within its OnExpired()
+	bool* destroyedFlag = nullptr;
+
+	//queue to dispatch expiration to, if any
+	ting::mt::Queue* queue = nullptr;
+
+	//Messages posted to the queue refer to the timer through this cell, since
+	//the timer may be stopped and destroyed before the message is handled.
+	std::shared_ptr<Timer*> queueCell;
 
 public:
 
@@ -151,16 +250,15 @@ public:
 	 * This method is called when timer expires.
 	 * Note, that the method is called from a separate thread, so user should
 	 * do all the necessary synchronization when implementing this method.
-	 * Also, note that expired methods from different timers are called sequentially,
-	 * that means that, for example, if two timers have expired simultaneously then
-	 * the expired method of the first timer is called first, and only after it returns
-	 * the expired method of the second timer is called.
-	 * That means, that one should handle the timer expiration as fast as possible to
-	 * avoid inaccuracy of other timers which have expired at the same time, since
-	 * the longer your expired handler method is executed, the latter expired method of those other timers will be called.
-	 * Do not do any heavy calculations or logics in the expired handler method. Do just
-	 * quick initiation of the action which should be taken on timer expiration,
-	 * for example, post a message to the message queue of another thread to be handled by that another thread.
+	 * The thread calling this method depends on how the timer library was initialized
+	 * and how the timer was constructed. By default, expired methods of all timers are called
+	 * sequentially from the timer thread. That means, that one should handle the timer expiration
+	 * as fast as possible to avoid inaccuracy of other timers which have expired at the same time.
+	 * If the timer library was created with dispatch threads, then expired methods are called from those
+	 * threads, so slow handler only delays timers dispatched to the same thread.
+	 * If the timer was constructed with a message queue, then expired method is called from the thread
+	 * handling messages of that queue.
+	 * In any case, expired method of the same timer is never called concurrently.
 	 */
 	virtual void OnExpired()NOEXCEPT = 0;
 
@@ -168,8 +266,27 @@ public:
 	 * @brief Constructor for new Timer instance.
 	 * The newly created timer is initially not running.
 	 */
-	inline Timer(){
-		ASSERT(!this->isRunning)
+	inline Timer() :
+			shardIndex(unsigned(-1))
+	{
+		ASSERT(!this->IsInserted())
+	}
+
+	/**
+	 * @brief Constructor for new Timer instance dispatching to a message queue.
+	 * The newly created timer is initially not running.
+	 * When the timer expires, a message is posted to the given queue and OnExpired()
+	 * is called from the thread which handles that message. This way the expiration
+	 * is handled in the thread owning the queue and no additional synchronization is needed.
+	 * @param queue - message queue to post expiration messages to. The queue shall
+	 *                outlive the timer object.
+	 */
+	inline Timer(ting::mt::Queue& queue) :
+			shardIndex(unsigned(-1)),
+			queue(&queue),
+			queueCell(std::make_shared<Timer*>(this))
+	{
+		ASSERT(!this->IsInserted())
 	}
 
 	virtual ~Timer()NOEXCEPT;
@@ -183,24 +300,69 @@ public:
 	 * If the timer is already running (i.e. it was already started before and has not expired yet)
 	 * the ting::Exc exception will be thrown.
 	 * This method is thread-safe.
+	 * Upon first start, the timer is assigned to the timer library shard of the calling thread,
+	 * see ting::timer::Lib for details.
+	 * @param timeout - timer timeout. Timeout is rounded up to whole microseconds.
+	 * @param slack - amount of time by which the expiration is allowed to be delayed.
+	 *                Timer expires somewhere within [timeout, timeout + slack] interval, at the moment
+	 *                which it is likely to share with other timers, so that they are handled in one wakeup.
+	 */
+	void Start(std::chrono::nanoseconds timeout, std::chrono::nanoseconds slack = std::chrono::nanoseconds::zero()){
+		this->Arm(timeout, std::chrono::nanoseconds::zero(), slack);
+	}
+
+	/**
+	 * @brief Start timer.
+	 * Same as Start(std::chrono::nanoseconds), but timeout is given in milliseconds.
 	 * @param millisec - timer timeout in milliseconds.
 	 */
-	inline void Start(std::uint32_t millisec);
+	void Start(std::uint32_t millisec){
+		this->Start(std::chrono::milliseconds(millisec));
+	}
+
+	/**
+	 * @brief Start periodic timer.
+	 * Timer expires for the first time after the given period and then keeps expiring
+	 * with the same period until stopped. Expirations are scheduled relatively to the previous
+	 * deadline rather than to the moment the timer was handled, so the timer does not drift.
+	 * If the timer is late for more than a period, e.g. because OnExpired() takes too long,
+	 * then missed expirations are skipped and OnExpired() is called only once for them.
+	 * Stop() stops the periodic timer. Same as for Start(), if the timer is already
+	 * running the ting::Exc exception will be thrown.
+	 * This method is thread-safe.
+	 * @param period - timer period. Should be non-zero. Period is rounded up to whole microseconds.
+	 * @param slack - amount of time by which each expiration is allowed to be delayed, see Start().
+	 *                The slack does not accumulate, i.e. it does not cause the timer to drift.
+	 * @throw ting::Exc - if the timer is already running or if the period is zero.
+	 */
+	void StartPeriodic(std::chrono::nanoseconds period, std::chrono::nanoseconds slack = std::chrono::nanoseconds::zero()){
+		if(period.count() <= 0){
+			throw ting::Exc("Timer::StartPeriodic(): period should be greater than zero");
+		}
+		this->Arm(period, period, slack);
+	}
 
 	/**
 	 * @brief Stop the timer.
 	 * Stops the timer if it was started before. In case it was not started
 	 * or it has already expired this method does nothing.
+	 * If the timer has expired, but its OnExpired() has not been called yet, then the call is cancelled.
+	 * If OnExpired() is being called at the moment from another thread, then this method waits until it returns.
 	 * This method is thread-safe.
 	 * After this method has returned you may be sure that the OnExpired() callback
 	 * will not be called anymore, unless the timer was not started again from within the callback
 	 * if the callback was called before returning from Stop() method.
 	 * Such case can be caught by checking the return value of the method.
+	 * It is allowed to call Stop() from within the OnExpired() of the same timer, in that case it does
+	 * not wait for the OnExpired() to return.
 	 * @return true if timer was running and was stopped.
 	 * @return false if timer was not running already when the Stop() method was called. I.e.
 	 *         the timer has expired already or was not started.
 	 */
 	inline bool Stop()NOEXCEPT;
+
+private:
+	inline void Arm(std::chrono::nanoseconds timeout, std::chrono::nanoseconds period, std::chrono::nanoseconds slack);
 };
 
 
@@ -211,6 +373,11 @@ public:
  * timers (see ting::Timer class). Before using timers one needs to initialize
  * the timer library, this is done just by creating the singleton object of
  * the timer library class.
+ * Timer library can be split into several shards, each shard has its own mutex and timing wheel.
+ * Threads starting the timers are assigned to shards in round-robin manner and each timer belongs
+ * to the shard of the thread which has started it for the first time. This way, threads working with
+ * their own timers do not contend with each other. All the shards are serviced by one timer thread,
+ * which only visits the shards having expired timers or changes requested.
  */
 class Lib : public IntrusiveSingleton<Lib>{
 	friend class IntrusiveSingleton<Lib>;
@@ -218,136 +385,210 @@ class Lib : public IntrusiveSingleton<Lib>{
 	
 	friend class ting::timer::Timer;
 
+	class Shard;
+
+	class DispatchThread : public ting::mt::Thread{
+	public:
+		Lib& lib;
+
+		volatile bool quitFlag = false;
+
+		ting::mt::Event event;
+
+		//one list per shard, each list is protected by the mutex of its shard
+		std::vector<Timer::PendingList> pendingTimers;
+
+		DispatchThread(Lib& lib, unsigned numShards) :
+				lib(lib),
+				pendingTimers(numShards)
+		{}
+
+		//override
+		void Run();
+	};
+
 	class TimerThread : public ting::mt::Thread{
 	public:
+		Lib& lib;
+
 		volatile bool quitFlag = false;
 
+		//signalled when a shard requests the thread to wake up earlier than planned
+		ting::mt::Event event;
+
+		TimerThread(Lib& lib) :
+				lib(lib)
+		{}
+
+		//override
+		void Run();
+	};
+
+	class Shard{
+	public:
+		Lib& lib;
+
+		const unsigned index;//index of the shard
+
 		std::mutex mutex;
-		ting::mt::Semaphore sema;
 
-		//mutex used to make sure that after Timer::Stop() method is called the
-		//expired notification callback will not be called
-		std::mutex expiredTimersNotifyMutex;
-		
-		//map requires key uniqueness, but in our case the key is a stop ticks,
-		//so, use std::multimap to allow similar keys.
-		Timer::T_TimerList timers;
+		//used to wait for OnExpired() call completion in Timer::Stop()
+		std::condition_variable callCompletedCond;
+		unsigned numCallWaiters = 0;
 
+		//wheel ticks are microseconds
+		TimingWheel timers;
 
+		//Ticks at which the timer thread has to visit the shard. Used to avoid waking up the
+		//timer thread when newly started timer does not expire earlier than that, and to let the timer
+		//thread skip the shard. Written with the mutex locked, read by the timer thread without it.
+		std::atomic<std::uint64_t> wakeTicks;
 
-		std::uint64_t ticks = 0;
-		bool incTicks = false;//flag indicates that high word of ticks needs increment
+		//set along with signalling the timer thread event, tells the timer thread to visit the shard
+		std::atomic<bool> wakeRequested;
 
-		//This function should be called at least once in 16 days (half of std::uint32_t(-1) milliseconds)
-		//in order to function properly.
-		//This is achieved by having a repeating timer set to 16 days, which will do nothing but
-		//calling this function.
-		inline std::uint64_t GetTicks();
+		//expired timers to be called from the timer thread
+		Timer::PendingList pendingTimers;
 
 
 
-		TimerThread(){
-			ASSERT(!this->quitFlag)
-		}
+		Shard(Lib& lib, unsigned index) :
+				lib(lib),
+				index(index),
+				timers(GetTicks()),
+				wakeTicks(0),
+				wakeRequested(false)
+		{}
 
-		~TimerThread()NOEXCEPT{
+		~Shard()NOEXCEPT{
 			//at the time of TimerLib destroying there should be no active timers
-			ASSERT(this->timers.size() == 0)
+			ASSERT(this->timers.Size() == 0)
 		}
 
-		void AddTimer_ts(Timer* timer, std::uint32_t timeout);
+		void AddTimer_ts(Timer* timer, std::chrono::nanoseconds timeout, std::chrono::nanoseconds period, std::chrono::nanoseconds slack);
+
+		//mutex should be locked when calling this method
+		void InsertTimer(Timer* timer)NOEXCEPT;
+
+		//mutex should be locked when calling this method
+		void RearmPeriodicTimer(Timer* timer, std::uint64_t ticks)NOEXCEPT;
 
 		bool RemoveTimer_ts(Timer* timer)NOEXCEPT;
 
-		inline void SetQuitFlagAndSignalSemaphore()NOEXCEPT{
-			this->quitFlag = true;
-			this->sema.Signal();
-		}
+		//mutex should be locked when calling this method
+		void Dispatch(Timer* timer)NOEXCEPT;
 
-		//override
-		void Run();
+		//mutex should be locked when calling this method, it is unlocked during the call to OnExpired()
+		void CallOnExpired(Timer* timer, std::unique_lock<std::mutex>& mutexGuard)NOEXCEPT;
 
-	} thread;
+		void CallPendingTimers_ts(Timer::PendingList& list)NOEXCEPT;
 
-	class HalfMaxTicksTimer : public Timer{
-	public:
-		//override
-		void OnExpired()NOEXCEPT{
-			try{
-				this->Start(Timer::DMaxTicks() / 2);
-			}catch(...){
-				ASSERT(false)
-			}
-		}
-	} halfMaxTicksTimer;
+		void CallQueuedTimer_ts(const std::shared_ptr<Timer*>& cell)NOEXCEPT;
 
-public:
-	inline Lib(){
-		this->thread.Start();
+		//Expires timers and updates wakeTicks, called by the timer thread.
+		//Returns true if there are expired timers to be called from the timer thread.
+		bool Advance_ts(std::uint64_t ticks)NOEXCEPT;
+	};
+
+
+
+	//returns current ticks of the wheel
+	static std::uint64_t GetTicks(){
+		return ting::timer::GetNanoTicks() / 1000;
+	}
+
+	std::vector<std::unique_ptr<Shard>> shards;
+
+	std::vector<std::unique_ptr<DispatchThread>> dispatchThreads;
+
+	TimerThread timerThread;
 
-		//start timer for half of the max ticks
-		this->halfMaxTicksTimer.OnExpired();
+	//identifies the library instance for caching shard assignment of the threads
+	const unsigned id;
+
+	//round-robin cursor for assigning threads to shards
+	std::atomic<unsigned> nextShard;
+
+	//returns shard of the calling thread
+	unsigned CurrentThreadShard()NOEXCEPT;
+
+	Shard& GetShard(unsigned index)NOEXCEPT{
+		return *this->shards[index % this->shards.size()];
 	}
 
+
+public:
+	/**
+	 * @brief Constructor.
+	 * Starts the timer library.
+	 * @param numDispatchThreads - number of threads to call OnExpired() of expired timers from.
+	 *                             If 0, then OnExpired() of all timers is called from the timer thread.
+	 *                             Otherwise, each timer is always dispatched to the same thread of these,
+	 *                             so that slow OnExpired() of one timer does not delay timers dispatched
+	 *                             to other threads.
+	 *                             Timers constructed with a message queue are always dispatched to that queue.
+	 *                             Dispatch threads are shared by all the shards.
+	 * @param numShards - number of shards. Should be non-zero.
+	 */
+	Lib(unsigned numDispatchThreads = 0, unsigned numShards = 1);
+
 	/**
 	 * @brief Destructor.
 	 * Note, that before destroying the timer library singleton object all the
 	 * timers should be stopped. Otherwise, in debug mode it will result in assertion failure.
 	 */
-	~Lib()NOEXCEPT{
-		//stop half max ticks timer
-		while(!this->halfMaxTicksTimer.Stop()){
-			ting::mt::Thread::Sleep(10);
-		}
-#ifdef DEBUG
-		{
-			std::lock_guard<decltype(this->thread.mutex)> mutexGuard(this->thread.mutex);
-			ASSERT(this->thread.timers.size() == 0)
-		}
-#endif
-		this->thread.SetQuitFlagAndSignalSemaphore();
-		this->thread.Join();
-	}
+	~Lib()NOEXCEPT;
 };
 
 
 
 inline Timer::~Timer()NOEXCEPT{
-	ASSERT_INFO(!this->isRunning, "trying to destroy running timer. Stop the timer first and make sure its OnExpired() method will not be called, then destroy the timer object.")
+	//in case the timer is destroyed from within its OnExpired(), notify the caller
+	if(this->destroyedFlag){
+		*this->destroyedFlag = true;
+	}
+
+	if(this->queueCell && Lib::IsCreated()){
+		unsigned index = this->shardIndex;
+		if(index != unsigned(-1)){
+			auto& mutex = Lib::Inst().GetShard(index).mutex;
+			std::lock_guard<decltype(mutex)> mutexGuard(mutex);
+			*this->queueCell = nullptr;
+		}
+	}
+
+	ASSERT_INFO(!this->IsInserted() && !this->isPending, "trying to destroy running timer. Stop the timer first and make sure its OnExpired() method will not be called, then destroy the timer object.")
 }
 
 
 
-inline void Timer::Start(std::uint32_t millisec){
+inline void Timer::Arm(std::chrono::nanoseconds timeout, std::chrono::nanoseconds period, std::chrono::nanoseconds slack){
 	ASSERT_INFO(Lib::IsCreated(), "Timer library is not initialized, you need to create TimerLib singletone object first")
 
-	Lib::Inst().thread.AddTimer_ts(this, millisec);
-}
-
+	Lib& lib = Lib::Inst();
 
+	unsigned index = this->shardIndex;
+	if(index == unsigned(-1)){
+		//first start of the timer, assign it to the shard of current thread
+		unsigned newIndex = lib.CurrentThreadShard();
+		if(this->shardIndex.compare_exchange_strong(index, newIndex)){
+			index = newIndex;
+		}
+	}
 
-inline bool Timer::Stop()NOEXCEPT{
-	ASSERT(Lib::IsCreated())
-	return Lib::Inst().thread.RemoveTimer_ts(this);
+	lib.GetShard(index).AddTimer_ts(this, timeout, period, slack);
 }
 
 
 
-inline std::uint64_t Lib::TimerThread::GetTicks(){
-	std::uint32_t ticks = ting::timer::GetTicks() % Timer::DMaxTicks();
+inline bool Timer::Stop()NOEXCEPT{
+	ASSERT(Lib::IsCreated())
 
-	if(this->incTicks){
-		if(ticks < Timer::DMaxTicks() / 2){
-			this->incTicks = false;
-			this->ticks += (std::uint64_t(Timer::DMaxTicks()) + 1); //update 64 bit ticks counter
-		}
-	}else{
-		if(ticks > Timer::DMaxTicks() / 2){
-			this->incTicks = true;
-		}
+	unsigned index = this->shardIndex;
+	if(index == unsigned(-1)){
+		return false;//timer was never started
 	}
-
-	return this->ticks + std::uint64_t(ticks);
+	return Lib::Inst().GetShard(index).RemoveTimer_ts(this);
 }
 
 
@@ -19,5 +19,19 @@ inline void TestTingThread(){
 //	TRACE(<< "running TestNestedJoin" << std::endl)
 	TestNestedJoin::Run();
 
+	TestSemaphore::Run();
+
+	TestEvent::Run();
+
+	TestSpinLock::Run();
+
+	TestStartOptions::Run();
+
+	TestReadWriteLocks::Run();
+
+	ReadScalingBenchmark::Run();
+
+	TestEpochReclamation::Run();
+
 	TRACE_ALWAYS(<< "[PASSED]: Thread test" << std::endl)
 }
@@ -1,11 +1,30 @@
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/mt/Thread.hpp"
+#include "../../src/ting/mt/Semaphore.hpp"
+#include "../../src/ting/mt/Event.hpp"
+#include "../../src/ting/mt/SpinLock.hpp"
+#include "../../src/ting/mt/RWSpinLock.hpp"
+#include "../../src/ting/mt/SeqLock.hpp"
+#include "../../src/ting/mt/Epoch.hpp"
+#include "../../src/ting/PoolStored.hpp"
 #include "../../src/ting/mt/MsgThread.hpp"
 #include "../../src/ting/Buffer.hpp"
 #include "../../src/ting/types.hpp"
 #include "../../src/ting/config.hpp"
 #include "../../src/ting/WaitSet.hpp"
 
+#if M_OS == M_OS_LINUX
+#	include <sched.h>
+#	include <pthread.h>
+#endif
+
 #include "tests.hpp"
 
 
@@ -190,3 +209,655 @@ void Run(){
 
 
 }//~namespace
+
+
+
+namespace TestSemaphore{
+
+class SignallingThread : public ting::mt::Thread{
+public:
+	ting::mt::Semaphore& sema;
+	unsigned num;
+
+	SignallingThread(ting::mt::Semaphore& sema, unsigned num) :
+			sema(sema),
+			num(num)
+	{}
+
+	//override
+	void Run(){
+		for(unsigned i = 0; i != this->num; ++i){
+			this->sema.Signal();
+		}
+	}
+};
+
+
+
+void Run(){
+	//values are counted
+	{
+		ting::mt::Semaphore sema(1);
+		ASSERT_ALWAYS(sema.Wait(0))
+		ASSERT_ALWAYS(!sema.Wait(0))
+
+		sema.Signal();
+		sema.Signal();
+		ASSERT_ALWAYS(sema.Wait(0))
+		ASSERT_ALWAYS(sema.Wait(std::chrono::nanoseconds::zero()))
+		ASSERT_ALWAYS(!sema.Wait(0))
+	}
+
+	//wait times out not earlier than requested
+	{
+		ting::mt::Semaphore sema;
+
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_ALWAYS(!sema.Wait(std::chrono::milliseconds(20)))
+		ASSERT_ALWAYS(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20))
+
+		start = std::chrono::steady_clock::now();
+		ASSERT_ALWAYS(!sema.Wait(20))
+		ASSERT_ALWAYS(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20))
+	}
+
+	//no signals are lost between threads
+	{
+		const unsigned num = 100000;
+
+		ting::mt::Semaphore sema;
+		SignallingThread t(sema, num);
+		t.Start();
+
+		for(unsigned i = 0; i != num; ++i){
+			ASSERT_ALWAYS(sema.Wait(5000))
+		}
+		ASSERT_ALWAYS(!sema.Wait(0))
+
+		t.Join();
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestEvent{
+
+class PingPongThread : public ting::mt::Thread{
+public:
+	ting::mt::Event& ping;
+	ting::mt::Event& pong;
+	unsigned num;
+
+	PingPongThread(ting::mt::Event& ping, ting::mt::Event& pong, unsigned num) :
+			ping(ping),
+			pong(pong),
+			num(num)
+	{}
+
+	//override
+	void Run(){
+		for(unsigned i = 0; i != this->num; ++i){
+			this->ping.Wait();
+			this->pong.Set();
+		}
+	}
+};
+
+
+
+void Run(){
+	//several sets release one wait
+	{
+		ting::mt::Event event;
+		ASSERT_ALWAYS(!event.Wait(std::chrono::nanoseconds::zero()))
+
+		event.Set();
+		event.Set();
+		ASSERT_ALWAYS(event.Wait(std::chrono::nanoseconds::zero()))
+		ASSERT_ALWAYS(!event.Wait(std::chrono::nanoseconds::zero()))
+
+		ting::mt::Event initiallySet(true);
+		ASSERT_ALWAYS(initiallySet.Wait(std::chrono::nanoseconds::zero()))
+	}
+
+	//wait times out not earlier than requested
+	{
+		ting::mt::Event event;
+
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_ALWAYS(!event.Wait(std::chrono::milliseconds(20)))
+		ASSERT_ALWAYS(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20))
+	}
+
+	//wake ups are not lost between threads
+	{
+		const unsigned num = 10000;
+
+		ting::mt::Event ping, pong;
+		PingPongThread t(ping, pong, num);
+		t.Start();
+
+		auto start = std::chrono::steady_clock::now();
+		for(unsigned i = 0; i != num; ++i){
+			ping.Set();
+			ASSERT_ALWAYS(pong.Wait(std::chrono::seconds(5)))
+		}
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+		t.Join();
+
+		TRACE_ALWAYS(<< "\tEvent ping-pong round trip: " << (double(elapsed.count()) / num) << " us" << std::endl)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestSpinLock{
+
+template <class T_Lock> class IncrementingThread : public ting::mt::Thread{
+public:
+	T_Lock& lock;
+	std::uint64_t& counter;
+	unsigned num;
+
+	IncrementingThread(T_Lock& lock, std::uint64_t& counter, unsigned num) :
+			lock(lock),
+			counter(counter),
+			num(num)
+	{}
+
+	//override
+	void Run(){
+		for(unsigned i = 0; i != this->num; ++i){
+			std::lock_guard<T_Lock> guard(this->lock);
+			++this->counter;
+		}
+	}
+};
+
+
+
+template <class T_Lock> std::uint64_t IncrementConcurrently(T_Lock& lock, unsigned numThreads, unsigned numPerThread){
+	std::uint64_t counter = 0;
+
+	std::vector<std::unique_ptr<IncrementingThread<T_Lock>>> threads;
+	for(unsigned i = 0; i != numThreads; ++i){
+		threads.push_back(std::unique_ptr<IncrementingThread<T_Lock>>(new IncrementingThread<T_Lock>(lock, counter, numPerThread)));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for(auto& t : threads){
+		t->Start();
+	}
+	for(auto& t : threads){
+		t->Join();
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+	TRACE_ALWAYS(<< "\tSpinLock: " << numThreads << " threads, " << (numThreads * numPerThread) << " increments: " << elapsed.count() << " ms" << std::endl)
+
+	return counter;
+}
+
+
+
+void Run(){
+	const unsigned numThreads = 4;
+	const unsigned numPerThread = 200000;
+
+	{
+		ting::mt::SpinLock lock;
+		ASSERT_ALWAYS(lock.try_lock())
+		ASSERT_ALWAYS(!lock.try_lock())
+		lock.unlock();
+
+		ASSERT_ALWAYS(IncrementConcurrently(lock, numThreads, numPerThread) == numThreads * numPerThread)
+	}
+
+	{
+		ting::mt::CountingSpinLock lock;
+
+		ASSERT_ALWAYS(IncrementConcurrently(lock, numThreads, numPerThread) == numThreads * numPerThread)
+
+		ASSERT_ALWAYS(lock.NumAcquisitions() == numThreads * numPerThread)
+		ASSERT_ALWAYS(lock.NumContentions() <= lock.NumAcquisitions())
+		TRACE_ALWAYS(<< "\tCountingSpinLock: " << lock.NumContentions() << " contentions of " << lock.NumAcquisitions() << " acquisitions" << std::endl)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestStartOptions{
+
+class PlacementThread : public ting::mt::Thread{
+public:
+	std::vector<unsigned> cpus;
+	std::string name;
+
+	//override
+	void Run(){
+#if M_OS == M_OS_LINUX
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		ASSERT_ALWAYS(sched_getaffinity(0, sizeof(set), &set) == 0)
+		for(unsigned i = 0; i != CPU_SETSIZE; ++i){
+			if(CPU_ISSET(i, &set)){
+				this->cpus.push_back(i);
+			}
+		}
+
+		char buf[16];
+		ASSERT_ALWAYS(pthread_getname_np(pthread_self(), buf, sizeof(buf)) == 0)
+		this->name = buf;
+#endif
+	}
+};
+
+
+
+void Run(){
+#if M_OS == M_OS_LINUX
+	cpu_set_t available;
+	CPU_ZERO(&available);
+	ASSERT_ALWAYS(sched_getaffinity(0, sizeof(available), &available) == 0)
+
+	//pin the thread to each of the available CPUs in turn
+	for(unsigned c = 0; c != CPU_SETSIZE; ++c){
+		if(!CPU_ISSET(c, &available)){
+			continue;
+		}
+
+		ting::mt::Thread::StartOptions options;
+		options.cpus.push_back(c);
+		options.name = "ting test thread with long name";
+
+		PlacementThread t;
+		t.Start(options);
+		t.Join();
+
+		ASSERT_ALWAYS(t.cpus.size() == 1)
+		ASSERT_INFO_ALWAYS(t.cpus[0] == c, "t.cpus[0] = " << t.cpus[0] << ", c = " << c)
+		ASSERT_INFO_ALWAYS(t.name == "ting test threa", "t.name = " << t.name)
+	}
+
+	//options which cannot be applied make Start() throw and Run() is not called
+	{
+		ting::mt::Thread::StartOptions options;
+		options.cpus.push_back(CPU_SETSIZE);
+
+		PlacementThread t;
+		bool thrown = false;
+		try{
+			t.Start(options);
+		}catch(ting::mt::Thread::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+		ASSERT_ALWAYS(t.name.size() == 0)
+	}
+
+	//non-real-time scheduling policy does not need privileges
+	{
+		ting::mt::Thread::StartOptions options;
+		options.schedPolicy = ting::mt::Thread::StartOptions::BATCH;
+
+		PlacementThread t;
+		t.Start(options);
+		t.Join();
+	}
+
+	//node 0 exists on NUMA and non-NUMA systems, but kernel may be built without NUMA support
+	{
+		ting::mt::Thread::StartOptions options;
+		options.numaNode = 0;
+
+		PlacementThread t;
+		try{
+			t.Start(options);
+			t.Join();
+		}catch(ting::mt::Thread::Exc& e){
+			TRACE_ALWAYS(<< "\tNUMA binding is not supported: " << e.What() << std::endl)
+		}
+	}
+#endif
+}
+
+}//~namespace
+
+
+
+namespace TestReadWriteLocks{
+
+//writers keep all the fields equal, readers check that they never see torn value
+struct Snapshot{
+	std::uint64_t a;
+	std::uint64_t b;
+	std::uint32_t c;
+};
+
+
+
+template <class T_Reader> class ThreadRunner : public ting::mt::Thread{
+public:
+	T_Reader func;
+
+	ThreadRunner(T_Reader func) :
+			func(func)
+	{}
+
+	//override
+	void Run(){
+		this->func();
+	}
+};
+
+template <class T_Func> std::unique_ptr<ting::mt::Thread> MakeThread(T_Func func){
+	return std::unique_ptr<ting::mt::Thread>(new ThreadRunner<T_Func>(func));
+}
+
+
+
+void Run(){
+	const unsigned numReaders = 3;
+	const unsigned numIterations = 100000;
+
+	//RWSpinLock
+	{
+		ting::mt::RWSpinLock lock;
+		Snapshot value = {0, 0, 0};
+
+		std::vector<std::unique_ptr<ting::mt::Thread>> threads;
+		for(unsigned i = 0; i != numReaders; ++i){
+			threads.push_back(MakeThread([&lock, &value](){
+				for(unsigned j = 0; j != numIterations; ++j){
+					ting::mt::RWSpinLock::SharedGuard guard(lock);
+					ASSERT_ALWAYS(value.a == value.b && value.b == value.c)
+				}
+			}));
+		}
+		threads.push_back(MakeThread([&lock, &value](){
+			for(unsigned j = 1; j != numIterations; ++j){
+				std::lock_guard<ting::mt::RWSpinLock> guard(lock);
+				value.a = j;
+				value.b = j;
+				value.c = j;
+			}
+		}));
+
+		for(auto& t : threads){
+			t->Start();
+		}
+		for(auto& t : threads){
+			t->Join();
+		}
+
+		ASSERT_ALWAYS(lock.try_lock_shared())
+		ASSERT_ALWAYS(lock.try_lock_shared())
+		ASSERT_ALWAYS(!lock.try_lock())
+		lock.unlock_shared();
+		lock.unlock_shared();
+		ASSERT_ALWAYS(lock.try_lock())
+		ASSERT_ALWAYS(!lock.try_lock_shared())
+		lock.unlock();
+	}
+
+	//SeqLock
+	{
+		Snapshot initial = {0, 0, 0};
+		ting::mt::SeqLock<Snapshot> lock(initial);
+
+		std::vector<std::unique_ptr<ting::mt::Thread>> threads;
+		for(unsigned i = 0; i != numReaders; ++i){
+			threads.push_back(MakeThread([&lock](){
+				for(unsigned j = 0; j != numIterations; ++j){
+					Snapshot v = lock.Read();
+					ASSERT_ALWAYS(v.a == v.b && v.b == v.c)
+				}
+			}));
+		}
+		threads.push_back(MakeThread([&lock](){
+			for(unsigned j = 1; j != numIterations; ++j){
+				Snapshot v = {j, j, j};
+				lock.Write(v);
+			}
+		}));
+
+		for(auto& t : threads){
+			t->Start();
+		}
+		for(auto& t : threads){
+			t->Join();
+		}
+
+		//read-modify-write under the writer lock
+		{
+			std::lock_guard<decltype(lock)> guard(lock);
+			Snapshot v = lock.Load();
+			ASSERT_ALWAYS(v.a == numIterations - 1)
+			++v.a;
+			lock.Store(v);
+		}
+		ASSERT_ALWAYS(lock.Read().a == numIterations)
+	}
+}
+
+}//~namespace
+
+
+
+namespace ReadScalingBenchmark{
+
+struct Config{
+	std::uint32_t address;
+	std::uint16_t port;
+	std::uint32_t timeout;
+};
+
+
+
+template <class T_Func> double MeasureReads(unsigned numThreads, T_Func read){
+	const unsigned numReads = 1000000;
+
+	std::vector<std::unique_ptr<ting::mt::Thread>> threads;
+	for(unsigned i = 0; i != numThreads; ++i){
+		threads.push_back(TestReadWriteLocks::MakeThread([read](){
+			std::uint32_t sum = 0;
+			for(unsigned j = 0; j != numReads; ++j){
+				sum += read();
+			}
+			ASSERT_ALWAYS(sum == numReads * 80)
+		}));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for(auto& t : threads){
+		t->Start();
+	}
+	for(auto& t : threads){
+		t->Join();
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	//millions of reads per second, total for all threads
+	return double(numReads) * numThreads / (elapsed.count() == 0 ? 1 : elapsed.count());
+}
+
+
+
+void Run(){
+	Config initial = {0x7f000001, 80, 1000};
+
+	std::mutex mutex;
+	Config mutexValue = initial;
+
+	ting::mt::RWSpinLock rwLock;
+	Config rwValue = initial;
+
+	ting::mt::SeqLock<Config> seqLock(initial);
+
+	unsigned maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	TRACE_ALWAYS(<< "\tRead scaling, millions of reads per second (std::mutex / RWSpinLock / SeqLock):" << std::endl)
+	for(unsigned n = 1; n <= maxThreads; n *= 2){
+		double m = MeasureReads(n, [&mutex, &mutexValue](){
+			std::lock_guard<std::mutex> guard(mutex);
+			return mutexValue.port;
+		});
+		double rw = MeasureReads(n, [&rwLock, &rwValue](){
+			ting::mt::RWSpinLock::SharedGuard guard(rwLock);
+			return rwValue.port;
+		});
+		double seq = MeasureReads(n, [&seqLock](){
+			return seqLock.Read().port;
+		});
+		TRACE_ALWAYS(<< "\t\t" << n << " threads: " << m << " / " << rw << " / " << seq << std::endl)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestEpochReclamation{
+
+std::atomic<int> numAlive(0);
+
+struct Node : public ting::PoolStored<Node, 32>{
+	static const std::uint32_t DMagic = 0x600d600d;
+
+	std::uint32_t magic = DMagic;
+	unsigned value;
+
+	Node(unsigned value) :
+			value(value)
+	{
+		++numAlive;
+	}
+
+	~Node()NOEXCEPT{
+		this->magic = 0xdeaddead;
+		--numAlive;
+	}
+};
+
+
+
+class ReaderThread : public ting::mt::Thread{
+public:
+	ting::mt::EpochDomain& domain;
+	std::atomic<Node*>& shared;
+	volatile bool& quitFlag;
+
+	unsigned numReads = 0;
+
+	ReaderThread(ting::mt::EpochDomain& domain, std::atomic<Node*>& shared, volatile bool& quitFlag) :
+			domain(domain),
+			shared(shared),
+			quitFlag(quitFlag)
+	{}
+
+	//override
+	void Run(){
+		ting::mt::EpochDomain::Participant participant(this->domain);
+		while(!this->quitFlag){
+			ting::mt::EpochDomain::Participant::Guard guard(participant);
+			Node* n = this->shared.load(std::memory_order_acquire);
+			ASSERT_ALWAYS(n->magic == Node::DMagic)
+			ting::mt::Thread::Sleep(0);
+			ASSERT_ALWAYS(n->magic == Node::DMagic)
+			++this->numReads;
+		}
+	}
+};
+
+
+
+void Run(){
+	const unsigned numReaders = 3;
+	const unsigned numUpdates = 20000;
+
+	//readers never see freed nodes and all retired nodes are eventually freed
+	{
+		ting::mt::EpochDomain domain;
+
+		std::atomic<Node*> shared(new Node(0));
+		volatile bool quitFlag = false;
+
+		std::vector<std::unique_ptr<ReaderThread>> readers;
+		for(unsigned i = 0; i != numReaders; ++i){
+			readers.push_back(std::unique_ptr<ReaderThread>(new ReaderThread(domain, shared, quitFlag)));
+			readers.back()->Start();
+		}
+
+		{
+			ting::mt::EpochDomain::Participant writer(domain);
+			for(unsigned i = 1; i != numUpdates; ++i){
+				Node* old = shared.exchange(new Node(i), std::memory_order_acq_rel);
+				writer.Retire(old);
+
+				//let readers make progress on systems with few CPUs
+				if(i % 100 == 0){
+					ting::mt::Thread::Sleep(1);
+				}
+			}
+
+			//retired nodes are being freed while updating
+			ASSERT_INFO_ALWAYS(writer.NumRetired() < numUpdates / 2, "writer.NumRetired() = " << writer.NumRetired())
+
+			quitFlag = true;
+			for(auto& r : readers){
+				r->Join();
+				ASSERT_ALWAYS(r->numReads != 0)
+			}
+		}
+
+		delete shared.load();
+	}
+	ASSERT_INFO_ALWAYS(numAlive == 0, "numAlive = " << numAlive)
+
+	//nodes retired in critical section are not freed until it is left
+	{
+		ting::mt::EpochDomain domain;
+		ting::mt::EpochDomain::Participant reader(domain);
+		ting::mt::EpochDomain::Participant writer(domain);
+
+		Node* n = new Node(1);
+
+		reader.Enter();
+		writer.Retire(n);
+		for(unsigned i = 0; i != 10; ++i){
+			writer.Collect();
+		}
+		ASSERT_ALWAYS(numAlive == 1)
+		ASSERT_ALWAYS(n->magic == Node::DMagic)
+		reader.Leave();
+
+		writer.Collect();
+		writer.Collect();
+		ASSERT_ALWAYS(numAlive == 0)
+		ASSERT_ALWAYS(writer.NumRetired() == 0)
+	}
+
+	//retired objects go back to the memory pool
+	{
+		ting::MemoryPool<sizeof(Node), 8> pool;
+		ting::mt::EpochDomain domain;
+		{
+			ting::mt::EpochDomain::Participant writer(domain);
+			for(unsigned i = 0; i != 100; ++i){
+				Node* n = ::new(pool.Alloc_ts()) Node(i);
+				writer.Retire(n, pool);
+			}
+		}
+		//remaining objects are freed by the domain
+	}
+	ASSERT_INFO_ALWAYS(numAlive == 0, "numAlive = " << numAlive)
+}
+
+}//~namespace
@@ -23,3 +23,31 @@ void Run();
 namespace TestNestedJoin{
 void Run();
 }//~namespace
+
+namespace TestSemaphore{
+void Run();
+}//~namespace
+
+namespace TestEvent{
+void Run();
+}//~namespace
+
+namespace TestSpinLock{
+void Run();
+}//~namespace
+
+namespace TestStartOptions{
+void Run();
+}//~namespace
+
+namespace TestReadWriteLocks{
+void Run();
+}//~namespace
+
+namespace ReadScalingBenchmark{
+void Run();
+}//~namespace
+
+namespace TestEpochReclamation{
+void Run();
+}//~namespace
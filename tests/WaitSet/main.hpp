@@ -9,6 +9,7 @@
 inline void TestTingWaitSet(){
 	test_general::Run();
 	test_message_queue_as_waitable::Run();
+	test_waitable_timer::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]: WaitSet test" << std::endl)
 }
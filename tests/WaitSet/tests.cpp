@@ -3,6 +3,8 @@
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/WaitSet.hpp"
 #include "../../src/ting/mt/MsgThread.hpp"
+#include "../../src/ting/WaitableTimer.hpp"
+#include "../../src/ting/timer.hpp"
 
 #include "tests.hpp"
 
@@ -111,3 +113,70 @@ void Run(){
 	ws.Remove(q2);
 }
 }//~namespace
+
+
+
+namespace test_waitable_timer{
+void Run(){
+	ting::WaitSet ws(1);
+
+	ting::WaitableTimer t;
+
+	ws.Add(t, ting::Waitable::READ);
+
+	std::array<ting::Waitable*, 1> buf;
+
+	//not started timer should not trigger
+	ASSERT_ALWAYS(ws.WaitWithTimeout(100) == 0)
+	ASSERT_ALWAYS(t.NumExpirations() == 0)
+
+	//one-shot timer
+	{
+		std::uint32_t startTicks = ting::timer::GetTicks();
+		t.Start(std::chrono::milliseconds(100));
+
+		ASSERT_ALWAYS(ws.WaitWithTimeout(1000, buf) == 1)
+		ASSERT_ALWAYS(buf[0] == &t)
+		ASSERT_ALWAYS(t.CanRead())
+
+		std::uint32_t elapsed = ting::timer::GetTicks() - startTicks;
+		ASSERT_INFO_ALWAYS(elapsed >= 90, "elapsed = " << elapsed)
+
+		ASSERT_ALWAYS(t.NumExpirations() == 1)
+		ASSERT_ALWAYS(!t.CanRead())
+
+		//one-shot timer should not trigger anymore
+		ASSERT_ALWAYS(ws.WaitWithTimeout(200) == 0)
+	}
+
+	//periodic timer
+	{
+		t.Start(std::chrono::milliseconds(10), std::chrono::milliseconds(10));
+
+		ting::mt::Thread::Sleep(205);
+
+		ASSERT_ALWAYS(ws.WaitWithTimeout(0) == 1)
+		std::uint64_t num = t.NumExpirations();
+		ASSERT_INFO_ALWAYS(15 <= num && num <= 21, "num = " << num)
+
+		ASSERT_ALWAYS(ws.WaitWithTimeout(1000) == 1)
+		num = t.NumExpirations();
+		ASSERT_INFO_ALWAYS(1 <= num && num <= 3, "num = " << num)
+	}
+
+	//stopping timer discards pending expirations
+	{
+		t.Start(std::chrono::microseconds(500), std::chrono::microseconds(500));
+
+		ting::mt::Thread::Sleep(10);
+
+		t.Stop();
+
+		ASSERT_ALWAYS(!t.CanRead())
+		ASSERT_ALWAYS(ws.WaitWithTimeout(100) == 0)
+		ASSERT_ALWAYS(t.NumExpirations() == 0)
+	}
+
+	ws.Remove(t);
+}
+}//~namespace
@@ -9,3 +9,7 @@ void Run();
 namespace test_general{
 void Run();
 }//~namespace
+
+namespace test_waitable_timer{
+void Run();
+}//~namespace
@@ -14,8 +14,26 @@ inline void TestTingSocket(){
 	BasicClientServerTest::Run();
 	BasicUDPSocketsTest::Run();
 	TestUDPSocketWaitForWriting::Run();
+	TestUDPBatch::Run();
+	UDPBatchBenchmark::Run();
+	TestUDPSegmentation::Run();
 	SendDataContinuouslyWithWaitSet::Run();
 	SendDataContinuously::Run();
+	TestScatterGather::Run();
+	TestSendFile::Run();
+	TestZeroCopy::Run();
+	ZeroCopyBenchmark::Run();
+	TestAcceptMany::Run();
+	AcceptBenchmark::Run();
+	TestListenerGroup::Run();
+	TestSocketOptions::Run();
+	TestBufferedStream::Run();
+	TestErrorCodes::Run();
+	TestConnect::Run();
+	TestUnixSockets::Run();
+	UnixLatencyBenchmark::Run();
+	TestUDPMeta::Run();
+	TestMulticast::Run();
 
 	TestSimpleDNSLookup::Run();
 	TestRequestFromCallback::Run();
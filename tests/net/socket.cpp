@@ -1,13 +1,31 @@
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <ctime>
+
 #include "../../src/ting/timer.hpp"
 #include "../../src/ting/mt/Thread.hpp"
 #include "../../src/ting/mt/MsgThread.hpp"
 #include "../../src/ting/net/TCPSocket.hpp"
 #include "../../src/ting/net/TCPServerSocket.hpp"
+#include "../../src/ting/net/TCPListenerGroup.hpp"
 #include "../../src/ting/net/UDPSocket.hpp"
+#include "../../src/ting/net/BufferedStream.hpp"
+#if M_OS != M_OS_WINDOWS
+#	include "../../src/ting/net/UnixStreamSocket.hpp"
+#	include "../../src/ting/net/UnixServerSocket.hpp"
+#	include "../../src/ting/net/UnixDatagramSocket.hpp"
+#	include <unistd.h>
+#	include <net/if.h>
+#	include <sys/resource.h>
+#endif
 #include "../../src/ting/WaitSet.hpp"
 #include "../../src/ting/Buffer.hpp"
 #include "../../src/ting/config.hpp"
 #include "../../src/ting/util.hpp"
+#include "../../src/ting/fs/FSFile.hpp"
+#include "../../src/ting/fs/MemoryFile.hpp"
 
 #include "socket.hpp"
 
@@ -758,3 +776,1656 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+namespace TestScatterGather{
+
+void Run(){
+	ting::net::TCPServerSocket serverSock;
+
+	serverSock.Open(13666);
+
+	ting::net::TCPSocket sockS;
+	{
+		ting::net::IPAddress ip("127.0.0.1", 13666);
+		sockS.Open(ip);
+	}
+
+	ting::net::TCPSocket sockR;
+	for(unsigned i = 0; i < 20 && !sockR; ++i){
+		ting::mt::Thread::Sleep(100);
+		sockR = serverSock.Accept();
+	}
+
+	ASSERT_ALWAYS(sockS)
+	ASSERT_ALWAYS(sockR)
+
+	//each message is a 4 byte header followed by payload, header and payload are in separate buffers
+	const unsigned numMessages = 200;
+	std::vector<std::uint8_t> payload(0x3000);
+
+	//sending side state
+	unsigned numSent = 0;
+	size_t sentOffset = 0; //offset within the current message, including header
+	std::array<std::uint8_t, 4> sendHeader;
+
+	//receiving side state
+	unsigned numReceived = 0;
+	size_t receivedOffset = 0;
+	std::array<std::uint8_t, 4> recvHeader;
+	std::vector<std::uint8_t> recvPayload(payload.size());
+
+	std::uint32_t startTime = ting::timer::GetTicks();
+
+	while(numReceived != numMessages){
+		ASSERT_ALWAYS(ting::timer::GetTicks() - startTime < 10000)
+
+		if(numSent != numMessages){
+			ting::util::Serialize32BE(numSent, &*sendHeader.begin());
+			for(auto& b : payload){
+				b = std::uint8_t(numSent);
+			}
+
+			//skip what has already been sent of this message
+			std::array<ting::Buffer<const std::uint8_t>, 2> bufs;
+			if(sentOffset < sendHeader.size()){
+				bufs[0] = ting::Buffer<const std::uint8_t>(&*sendHeader.begin() + sentOffset, sendHeader.size() - sentOffset);
+				bufs[1] = payload;
+			}else{
+				bufs[1] = ting::Buffer<const std::uint8_t>(&*payload.begin() + (sentOffset - sendHeader.size()), payload.size() - (sentOffset - sendHeader.size()));
+			}
+
+			sentOffset += sockS.Send(bufs);
+			ASSERT_ALWAYS(sentOffset <= sendHeader.size() + payload.size())
+			if(sentOffset == sendHeader.size() + payload.size()){
+				sentOffset = 0;
+				++numSent;
+			}
+		}
+
+		std::array<ting::Buffer<std::uint8_t>, 2> bufs;
+		if(receivedOffset < recvHeader.size()){
+			bufs[0] = ting::Buffer<std::uint8_t>(&*recvHeader.begin() + receivedOffset, recvHeader.size() - receivedOffset);
+			bufs[1] = recvPayload;
+		}else{
+			bufs[1] = ting::Buffer<std::uint8_t>(&*recvPayload.begin() + (receivedOffset - recvHeader.size()), recvPayload.size() - (receivedOffset - recvHeader.size()));
+		}
+
+		size_t res = sockR.Recv(bufs);
+		if(res == 0){
+			ting::mt::Thread::Sleep(1);
+			continue;
+		}
+		receivedOffset += res;
+		ASSERT_ALWAYS(receivedOffset <= recvHeader.size() + recvPayload.size())
+		if(receivedOffset == recvHeader.size() + recvPayload.size()){
+			ASSERT_ALWAYS(ting::util::Deserialize32BE(&*recvHeader.begin()) == numReceived)
+			for(auto b : recvPayload){
+				ASSERT_INFO_ALWAYS(b == std::uint8_t(numReceived), "b = " << unsigned(b) << " numReceived = " << numReceived)
+			}
+			receivedOffset = 0;
+			++numReceived;
+		}
+	}
+
+	ASSERT_ALWAYS(numSent == numMessages)
+}
+
+}//~namespace
+
+
+
+namespace TestUDPBatch{
+
+void Run(){
+	ting::net::UDPSocket recvSock;
+	recvSock.Open(13667);
+
+	ting::net::UDPSocket sendSock;
+	sendSock.Open();
+
+	ting::net::IPAddress addr(
+			IsIPv6SupportedByOS() ? "::1" : "127.0.0.1",
+			13667
+		);
+
+	const unsigned numDatagrams = 10;
+
+	std::array<std::array<std::uint8_t, 4>, numDatagrams> data;
+	std::array<ting::net::UDPSocket::OutgoingDatagram, numDatagrams> out;
+	for(unsigned i = 0; i != numDatagrams; ++i){
+		ting::util::Serialize32BE(i, &*data[i].begin());
+		out[i].data = data[i];
+		out[i].destination = addr;
+	}
+
+	unsigned numSent = 0;
+	for(unsigned i = 0; i < 10 && numSent != numDatagrams; ++i){
+		numSent += sendSock.SendMany(ting::Buffer<const ting::net::UDPSocket::OutgoingDatagram>(&*out.begin() + numSent, out.size() - numSent));
+		ASSERT_ALWAYS(numSent <= numDatagrams)
+		ting::mt::Thread::Sleep(10);
+	}
+	ASSERT_INFO_ALWAYS(numSent == numDatagrams, "numSent = " << numSent)
+
+	std::array<std::array<std::uint8_t, 16>, numDatagrams + 6> bufs;
+	std::array<ting::net::UDPSocket::IncomingDatagram, numDatagrams + 6> in;
+	for(unsigned i = 0; i != in.size(); ++i){
+		in[i].buf = bufs[i];
+	}
+
+	unsigned numReceived = 0;
+	for(unsigned i = 0; i < 10 && numReceived != numDatagrams; ++i){
+		size_t res = recvSock.RecvMany(ting::Buffer<ting::net::UDPSocket::IncomingDatagram>(&*in.begin() + numReceived, in.size() - numReceived));
+		numReceived += unsigned(res);
+		ASSERT_ALWAYS(numReceived <= numDatagrams)
+		ting::mt::Thread::Sleep(10);
+	}
+	ASSERT_INFO_ALWAYS(numReceived == numDatagrams, "numReceived = " << numReceived)
+
+	for(unsigned i = 0; i != numDatagrams; ++i){
+		ASSERT_ALWAYS(in[i].size == 4)
+		ASSERT_ALWAYS(ting::util::Deserialize32BE(&*in[i].buf.begin()) == i)
+		ASSERT_ALWAYS(in[i].sender.port == sendSock.GetLocalPort())
+	}
+
+	//nothing more to receive
+	ASSERT_ALWAYS(recvSock.RecvMany(in) == 0)
+}
+
+}//~namespace
+
+
+
+namespace UDPBatchBenchmark{
+
+//returns number of datagrams per second passed through the loopback
+template <class T_Send, class T_Recv> unsigned Measure(T_Send&& send, T_Recv&& recv){
+	const unsigned batchSize = 32;
+
+	unsigned numReceived = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = std::chrono::steady_clock::duration::zero();
+
+	while(elapsed < std::chrono::milliseconds(500)){
+		unsigned sent = send(batchSize);
+
+		//drain the receiving socket, datagrams which are lost (e.g. due to receive buffer overflow) are not counted
+		for(unsigned left = sent; left != 0;){
+			unsigned res = recv(left);
+			if(res == 0){
+				break;
+			}
+			left -= res;
+			numReceived += res;
+		}
+
+		elapsed = std::chrono::steady_clock::now() - start;
+	}
+
+	return unsigned(numReceived * 1000000ull / std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+void Run(){
+	ting::net::UDPSocket recvSock;
+	recvSock.Open(13667);
+
+	ting::net::UDPSocket sendSock;
+	sendSock.Open();
+
+	ting::net::IPAddress addr("127.0.0.1", 13667);
+
+	std::array<std::uint8_t, 64> data;
+	data.fill(0xa5);
+
+	std::array<std::array<std::uint8_t, 128>, ting::net::UDPSocket::DMaxBatchSize()> bufs;
+
+	unsigned single = Measure(
+			[&](unsigned n){
+				unsigned ret = 0;
+				for(; ret != n; ++ret){
+					if(sendSock.Send(data, addr) == 0){
+						break;
+					}
+				}
+				return ret;
+			},
+			[&](unsigned n){
+				ting::net::IPAddress ip;
+				unsigned ret = 0;
+				for(; ret != n; ++ret){
+					if(recvSock.Recv(bufs[0], ip) == 0){
+						break;
+					}
+				}
+				return ret;
+			}
+		);
+
+	std::array<ting::net::UDPSocket::OutgoingDatagram, ting::net::UDPSocket::DMaxBatchSize()> out;
+	for(auto& d : out){
+		d.data = data;
+		d.destination = addr;
+	}
+
+	std::array<ting::net::UDPSocket::IncomingDatagram, ting::net::UDPSocket::DMaxBatchSize()> in;
+	for(unsigned i = 0; i != in.size(); ++i){
+		in[i].buf = bufs[i];
+	}
+
+	unsigned batch = Measure(
+			[&](unsigned n){
+				return unsigned(sendSock.SendMany(ting::Buffer<const ting::net::UDPSocket::OutgoingDatagram>(&*out.begin(), n)));
+			},
+			[&](unsigned n){
+				return unsigned(recvSock.RecvMany(ting::Buffer<ting::net::UDPSocket::IncomingDatagram>(&*in.begin(), n)));
+			}
+		);
+
+	TRACE_ALWAYS(<< "\tUDP loopback, datagrams per second (Send/Recv / SendMany/RecvMany): " << single << " / " << batch << std::endl)
+}
+
+}//~namespace
+
+
+
+namespace TestUDPSegmentation{
+
+void Run(bool coalesce){
+	ting::net::UDPSocket recvSock;
+	recvSock.Open(13668);
+
+	//disabling shall always succeed
+	bool applied = recvSock.SetReceiveCoalescing(coalesce);
+	ASSERT_ALWAYS(applied || coalesce)
+	bool coalescing = coalesce && applied;
+
+	ting::net::UDPSocket sendSock;
+	sendSock.Open();
+
+	ting::net::IPAddress addr("127.0.0.1", 13668);
+
+	//9 full segments and a short one
+	const size_t segmentSize = 1000;
+	std::vector<std::uint8_t> data(segmentSize * 9 + segmentSize / 2);
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i / segmentSize);
+	}
+
+	size_t numSent = 0;
+	for(unsigned i = 0; i < 10 && numSent != data.size(); ++i){
+		numSent += sendSock.SendSegmented(ting::Buffer<const std::uint8_t>(&*data.begin() + numSent, data.size() - numSent), segmentSize, addr);
+		ASSERT_ALWAYS(numSent <= data.size())
+		ASSERT_ALWAYS(numSent == data.size() || numSent % segmentSize == 0)
+	}
+	ASSERT_INFO_ALWAYS(numSent == data.size(), "numSent = " << numSent)
+
+	std::vector<std::uint8_t> buf(ting::net::UDPSocket::DMaxSegmentedSize());
+
+	size_t numReceived = 0;
+	unsigned numCalls = 0;
+	for(unsigned i = 0; i < 100 && numReceived != data.size(); ++i){
+		ting::net::IPAddress ip;
+		size_t segSize;
+		size_t res = recvSock.RecvCoalesced(buf, ip, segSize);
+		if(res == 0){
+			ting::mt::Thread::Sleep(10);
+			continue;
+		}
+		++numCalls;
+
+		ASSERT_INFO_ALWAYS(segSize == segmentSize || (segSize == res && res == segmentSize / 2), "segSize = " << segSize << " res = " << res)
+		ASSERT_ALWAYS(ip.port == sendSock.GetLocalPort())
+
+		//datagrams are received in order over loopback
+		for(size_t j = 0; j != res; ++j){
+			ASSERT_ALWAYS(buf[j] == data[numReceived + j])
+		}
+		numReceived += res;
+	}
+	ASSERT_INFO_ALWAYS(numReceived == data.size(), "numReceived = " << numReceived)
+
+	if(!coalescing){
+		ASSERT_ALWAYS(numCalls == 10)
+	}
+}
+
+void Run(){
+	Run(false);
+	Run(true);
+}
+
+}//~namespace
+
+
+
+namespace TestSendFile{
+
+void SendAndCheck(const ting::fs::File& file, const std::vector<std::uint8_t>& data, size_t offset, size_t length){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666);
+
+	ting::net::TCPSocket sockS;
+	sockS.Open(ting::net::IPAddress("127.0.0.1", 13666));
+
+	ting::net::TCPSocket sockR;
+	for(unsigned i = 0; i < 20 && !sockR; ++i){
+		ting::mt::Thread::Sleep(100);
+		sockR = serverSock.Accept();
+	}
+
+	ASSERT_ALWAYS(sockS)
+	ASSERT_ALWAYS(sockR)
+
+	std::vector<std::uint8_t> received;
+
+	size_t numSent = 0;
+	std::uint32_t startTime = ting::timer::GetTicks();
+	while(received.size() != length){
+		ASSERT_ALWAYS(ting::timer::GetTicks() - startTime < 10000)
+
+		if(numSent != length){
+			numSent += sockS.SendFile(file, offset + numSent, length - numSent);
+			ASSERT_ALWAYS(numSent <= length)
+		}
+
+		std::array<std::uint8_t, 0x2000> buf;
+		size_t res = sockR.Recv(buf);
+		if(res == 0){
+			ting::mt::Thread::Sleep(1);
+			continue;
+		}
+		received.insert(received.end(), buf.begin(), buf.begin() + res);
+		ASSERT_ALWAYS(received.size() <= length)
+	}
+
+	ASSERT_ALWAYS(std::equal(received.begin(), received.end(), data.begin() + offset))
+
+	//nothing is sent beyond the end of file
+	ASSERT_ALWAYS(sockS.SendFile(file, data.size(), 100) == 0)
+}
+
+void Run(){
+	std::vector<std::uint8_t> data(300000);
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i * 7 + i / 256);
+	}
+
+	//file system file
+	{
+		ting::fs::FSFile file("sendfile_test.tmp");
+		file.Open(ting::fs::File::E_Mode::CREATE);
+		file.Write(data);
+
+		//data written but not flushed yet is also sent
+		SendAndCheck(file, data, 1000, data.size() - 2000);
+
+		file.Close();
+		std::remove(file.Path().c_str());
+	}
+
+	//file which does not support sendfile()
+	{
+		ting::fs::MemoryFile file;
+		file.Open(ting::fs::File::E_Mode::CREATE);
+		file.Write(data);
+		SendAndCheck(file, data, 1000, data.size() - 2000);
+		file.Close();
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestZeroCopy{
+
+//connects a pair of sockets over loopback
+void Connect(ting::net::TCPSocket& sockS, ting::net::TCPSocket& sockR){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666);
+
+	sockS.Open(ting::net::IPAddress("127.0.0.1", 13666));
+
+	for(unsigned i = 0; i < 20 && !sockR; ++i){
+		ting::mt::Thread::Sleep(100);
+		sockR = serverSock.Accept();
+	}
+
+	ASSERT_ALWAYS(sockS)
+	ASSERT_ALWAYS(sockR)
+}
+
+void Run(){
+	ting::net::TCPSocket sockS, sockR;
+	Connect(sockS, sockR);
+
+	//zero-copy sending is refused until enabled, otherwise no completions would ever be reported
+	{
+		std::array<std::uint8_t, 4> buf = {{1, 2, 3, 4}};
+		std::uint32_t id;
+		bool thrown = false;
+		try{
+			sockS.SendZeroCopy(buf, id);
+		}catch(ting::net::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	if(!sockS.EnableZeroCopy()){
+		TRACE_ALWAYS(<< "\tzero-copy sending is not supported, skipping test" << std::endl)
+		return;
+	}
+
+	std::vector<std::uint8_t> data(0x100000);
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i * 13 + i / 256);
+	}
+
+	size_t numSent = 0;
+	std::uint32_t numSends = 0;
+	std::vector<std::uint8_t> received;
+
+	std::uint32_t startTime = ting::timer::GetTicks();
+	while(received.size() != data.size()){
+		ASSERT_ALWAYS(ting::timer::GetTicks() - startTime < 10000)
+
+		if(numSent != data.size()){
+			std::uint32_t id;
+			size_t res = sockS.SendZeroCopy(ting::Buffer<const std::uint8_t>(&*data.begin() + numSent, data.size() - numSent), id);
+			if(res != 0){
+				ASSERT_ALWAYS(id == numSends)
+				++numSends;
+			}
+			numSent += res;
+		}
+
+		std::array<std::uint8_t, 0x4000> buf;
+		size_t res = sockR.Recv(buf);
+		if(res == 0){
+			ting::mt::Thread::Sleep(1);
+			continue;
+		}
+		received.insert(received.end(), buf.begin(), buf.begin() + res);
+	}
+	ASSERT_ALWAYS(received == data)
+
+	//wait for all completions, they are signalled as error condition
+	ting::WaitSet waitSet(1);
+	waitSet.Add(sockS, ting::Waitable::READ);
+
+	std::uint32_t numCompleted = 0;
+	while(numCompleted != numSends){
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+		ASSERT_ALWAYS(sockS.ErrorCondition())
+
+		std::array<ting::net::TCPSocket::ZeroCopyCompletion, 16> completions;
+		size_t num = sockS.RecvZeroCopyCompletions(completions);
+		for(size_t i = 0; i != num; ++i){
+			//completions of sends over one socket come in order
+			ASSERT_INFO_ALWAYS(completions[i].first == numCompleted, "first = " << completions[i].first << " numCompleted = " << numCompleted)
+			ASSERT_ALWAYS(completions[i].last >= completions[i].first)
+			numCompleted = completions[i].last + 1;
+		}
+		ASSERT_ALWAYS(numCompleted <= numSends)
+	}
+
+	waitSet.Remove(sockS);
+}
+
+}//~namespace
+
+
+
+namespace ZeroCopyBenchmark{
+
+struct Result{
+	unsigned megabytesPerSecond;
+	unsigned cpuMillisecondsPerGigabyte;
+};
+
+template <class T_Send> Result Measure(ting::net::TCPSocket& sockS, ting::net::TCPSocket& sockR, T_Send&& send){
+	const size_t totalSize = 0x10000000; //256 megabytes
+
+	std::clock_t cpuStart = std::clock();
+	auto start = std::chrono::steady_clock::now();
+
+	size_t numSent = 0;
+	size_t numReceived = 0;
+	std::vector<std::uint8_t> buf(0x40000);
+	while(numReceived != totalSize){
+		if(numSent != totalSize){
+			numSent += send(sockS, std::min(totalSize - numSent, size_t(0x100000)));
+		}
+		numReceived += sockR.Recv(buf);
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	std::clock_t cpu = std::clock() - cpuStart;
+
+	Result ret;
+	ret.megabytesPerSecond = unsigned((totalSize >> 20) * 1000000ull / std::max(elapsed.count(), decltype(elapsed.count())(1)));
+	ret.cpuMillisecondsPerGigabyte = unsigned(std::uint64_t(cpu) * 1000 / CLOCKS_PER_SEC * (1 << 30) / totalSize);
+	return ret;
+}
+
+void Run(){
+	ting::net::TCPSocket sockS, sockR;
+	TestZeroCopy::Connect(sockS, sockR);
+
+	if(!sockS.EnableZeroCopy()){
+		TRACE_ALWAYS(<< "\tzero-copy sending is not supported, skipping benchmark" << std::endl)
+		return;
+	}
+
+	//the data is never modified, so it is ok to send same buffer again while previous sends are not completed yet
+	std::vector<std::uint8_t> data(0x100000, 0x5a);
+
+	Result copying = Measure(sockS, sockR, [&data](ting::net::TCPSocket& s, size_t size){
+		return s.Send(ting::Buffer<const std::uint8_t>(&*data.begin(), size));
+	});
+
+	std::uint32_t lastId = 0;
+	Result zeroCopy = Measure(sockS, sockR, [&data, &lastId](ting::net::TCPSocket& s, size_t size){
+		std::array<ting::net::TCPSocket::ZeroCopyCompletion, 64> completions;
+		s.RecvZeroCopyCompletions(completions);
+		return s.SendZeroCopy(ting::Buffer<const std::uint8_t>(&*data.begin(), size), lastId);
+	});
+
+	TRACE_ALWAYS(<< "\tTCP loopback, MB per second / CPU ms per GB (Send / SendZeroCopy): "
+			<< copying.megabytesPerSecond << " / " << copying.cpuMillisecondsPerGigabyte << ", "
+			<< zeroCopy.megabytesPerSecond << " / " << zeroCopy.cpuMillisecondsPerGigabyte << std::endl
+		)
+}
+
+}//~namespace
+
+
+
+namespace TestAcceptMany{
+
+void Run(){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666, true);
+
+	const unsigned numConnections = 10;
+
+	std::array<ting::net::TCPSocket, numConnections> clients;
+	for(auto& s : clients){
+		s.Open(ting::net::IPAddress("127.0.0.1", 13666));
+	}
+
+	std::array<ting::net::TCPSocket, numConnections + 5> accepted;
+	size_t numAccepted = 0;
+	for(unsigned i = 0; i < 20 && numAccepted != numConnections; ++i){
+		ting::mt::Thread::Sleep(50);
+		numAccepted += serverSock.AcceptMany(ting::Buffer<ting::net::TCPSocket>(&*accepted.begin() + numAccepted, accepted.size() - numAccepted));
+	}
+	ASSERT_INFO_ALWAYS(numAccepted == numConnections, "numAccepted = " << numAccepted)
+
+	for(size_t i = 0; i != accepted.size(); ++i){
+		ASSERT_ALWAYS(bool(accepted[i]) == (i < numConnections))
+	}
+
+	//accepted sockets are non-blocking
+	std::array<std::uint8_t, 4> buf;
+	ASSERT_ALWAYS(accepted[0].Recv(buf) == 0)
+
+	//zero-copy send IDs start from 0 when a socket object is reused for a newly accepted connection
+	if(accepted[0].EnableZeroCopy()){
+		std::uint32_t id;
+		ASSERT_ALWAYS(accepted[0].SendZeroCopy(buf, id) == buf.size())
+		ASSERT_ALWAYS(id == 0)
+		ASSERT_ALWAYS(accepted[0].SendZeroCopy(buf, id) == buf.size())
+		ASSERT_ALWAYS(id == 1)
+
+		ting::net::TCPSocket client;
+		client.Open(ting::net::IPAddress("127.0.0.1", 13666));
+
+		numAccepted = 0;
+		for(unsigned i = 0; i < 20 && numAccepted == 0; ++i){
+			ting::mt::Thread::Sleep(50);
+			numAccepted = serverSock.AcceptMany(ting::Buffer<ting::net::TCPSocket>(&*accepted.begin(), 1));
+		}
+		ASSERT_ALWAYS(numAccepted == 1)
+
+		//zero-copy sending has to be enabled again for the new connection
+		bool thrown = false;
+		try{
+			accepted[0].SendZeroCopy(buf, id);
+		}catch(ting::net::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+
+		ASSERT_ALWAYS(accepted[0].EnableZeroCopy())
+		ASSERT_ALWAYS(accepted[0].SendZeroCopy(buf, id) == buf.size())
+		ASSERT_INFO_ALWAYS(id == 0, "id = " << id)
+	}else{
+		TRACE_ALWAYS(<< "\tzero-copy sending is not supported, skipping zero-copy ID check" << std::endl)
+	}
+
+	ASSERT_ALWAYS(serverSock.AcceptMany(accepted) == 0)
+
+#if M_OS == M_OS_LINUX
+	//error which stops accepting is reported, the connection stays pending
+	{
+		ting::net::TCPSocket client;
+		client.Open(ting::net::IPAddress("127.0.0.1", 13666));
+		ting::mt::Thread::Sleep(100);
+
+		//limit the number of file descriptors so that the next one cannot be allocated
+		int lowestFreeFd = dup(0);
+		ASSERT_ALWAYS(lowestFreeFd >= 0)
+		close(lowestFreeFd);
+
+		rlimit oldLimit;
+		ASSERT_ALWAYS(getrlimit(RLIMIT_NOFILE, &oldLimit) == 0)
+		rlimit limit = oldLimit;
+		limit.rlim_cur = rlim_t(lowestFreeFd);
+		ASSERT_ALWAYS(setrlimit(RLIMIT_NOFILE, &limit) == 0)
+
+		int errorCode = 0;
+		size_t num = serverSock.AcceptMany(accepted, errorCode);
+
+		ASSERT_ALWAYS(setrlimit(RLIMIT_NOFILE, &oldLimit) == 0)
+
+		ASSERT_INFO_ALWAYS(num == 0, "num = " << num)
+		ASSERT_INFO_ALWAYS(errorCode == EMFILE, "errorCode = " << errorCode)
+
+		num = serverSock.AcceptMany(accepted, errorCode);
+		ASSERT_INFO_ALWAYS(num == 1, "num = " << num)
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+	}
+#endif
+}
+
+}//~namespace
+
+
+
+namespace AcceptBenchmark{
+
+//returns number of connections per second
+template <class T_Accept> unsigned Measure(T_Accept&& accept){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666, true, 128);
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(serverSock, ting::Waitable::READ);
+
+	const unsigned batchSize = 64;
+	const unsigned numConnections = batchSize * 32;
+
+	std::array<ting::net::TCPSocket, batchSize> clients;
+	std::array<ting::net::TCPSocket, batchSize> accepted;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for(unsigned n = 0; n != numConnections; n += batchSize){
+		for(auto& s : clients){
+			s.Close();
+			s.Open(ting::net::IPAddress("127.0.0.1", 13666));
+		}
+
+		for(size_t numAccepted = 0; numAccepted != clients.size();){
+			ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+			numAccepted += accept(serverSock, ting::Buffer<ting::net::TCPSocket>(&*accepted.begin() + numAccepted, accepted.size() - numAccepted));
+		}
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	waitSet.Remove(serverSock);
+
+	return unsigned(std::uint64_t(numConnections) * 1000000 / std::max(elapsed.count(), decltype(elapsed.count())(1)));
+}
+
+void Run(){
+	//accept one connection per WaitSet notification
+	unsigned single = Measure([](ting::net::TCPServerSocket& s, ting::Buffer<ting::net::TCPSocket> sockets){
+		sockets[0] = s.Accept();
+		return sockets[0] ? 1 : 0;
+	});
+
+	//drain the backlog per WaitSet notification
+	unsigned batch = Measure([](ting::net::TCPServerSocket& s, ting::Buffer<ting::net::TCPSocket> sockets){
+		return s.AcceptMany(sockets);
+	});
+
+	TRACE_ALWAYS(<< "\tTCP loopback, connections per second (Accept / AcceptMany): " << single << " / " << batch << std::endl)
+}
+
+}//~namespace
+
+
+
+namespace TestListenerGroup{
+
+void Test(bool steerByCpu){
+	const size_t numListeners = 4;
+
+	ting::net::TCPListenerGroup group;
+	group.Open(0, numListeners, steerByCpu, true);
+	ASSERT_ALWAYS(group.Size() == numListeners)
+
+	std::uint16_t port = group.GetLocalPort();
+	for(size_t i = 0; i != group.Size(); ++i){
+		ASSERT_ALWAYS(group[i].GetLocalPort() == port)
+	}
+
+	ting::WaitSet waitSet(numListeners);
+	for(size_t i = 0; i != group.Size(); ++i){
+		waitSet.Add(group[i], ting::Waitable::READ);
+	}
+
+	const unsigned numConnections = 40;
+
+	std::array<ting::net::TCPSocket, numConnections> clients;
+	for(auto& s : clients){
+		s.Open(ting::net::IPAddress("127.0.0.1", port));
+	}
+
+	std::array<ting::net::TCPSocket, numConnections> accepted;
+	std::array<size_t, numListeners> numAcceptedBy;
+	numAcceptedBy.fill(0);
+
+	size_t numAccepted = 0;
+	while(numAccepted != numConnections){
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+		for(size_t i = 0; i != group.Size(); ++i){
+			size_t n = group[i].AcceptMany(ting::Buffer<ting::net::TCPSocket>(&*accepted.begin() + numAccepted, accepted.size() - numAccepted));
+			numAccepted += n;
+			numAcceptedBy[i] += n;
+		}
+	}
+
+	unsigned numUsedListeners = 0;
+	for(auto n : numAcceptedBy){
+		if(n != 0){
+			++numUsedListeners;
+		}
+	}
+	TRACE_ALWAYS(<< "\tlistener group, steerByCpu = " << steerByCpu << ", listeners used: " << numUsedListeners << " of " << numListeners << std::endl)
+
+	if(!steerByCpu){
+		//connections are distributed by hash of the addresses, it is very unlikely all of them go to the same listener
+		ASSERT_INFO_ALWAYS(numUsedListeners > 1, "numUsedListeners = " << numUsedListeners)
+	}
+
+	for(size_t i = 0; i != group.Size(); ++i){
+		waitSet.Remove(group[i]);
+	}
+}
+
+void Run(){
+	Test(false);
+
+#if M_OS == M_OS_LINUX
+	Test(true);
+#endif
+}
+
+}//~namespace
+
+
+
+namespace TestSocketOptions{
+
+void Run(){
+	ting::net::SocketOptions serverOptions;
+	serverOptions.disableNaggle = true;
+	serverOptions.recvBufferSize = 0x20000;
+	serverOptions.keepAlive = true;
+	serverOptions.keepAliveIdle = 60;
+	serverOptions.keepAliveInterval = 10;
+	serverOptions.keepAliveCount = 3;
+#if M_OS == M_OS_LINUX
+	serverOptions.fastOpen = true;
+	serverOptions.notSentLowWatermark = 0x4000;
+	serverOptions.busyPoll = 50;
+#endif
+
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666, serverOptions);
+	ASSERT_ALWAYS(serverSock.GetRecvBufferSize() >= serverOptions.recvBufferSize)
+
+	ting::net::SocketOptions clientOptions;
+	clientOptions.sendBufferSize = 0x20000;
+	clientOptions.lingerTimeout = 0;//reset connection on close
+#if M_OS == M_OS_LINUX
+	clientOptions.fastOpen = true;
+#endif
+
+	ting::net::TCPSocket sockS;
+	sockS.Open(ting::net::IPAddress("127.0.0.1", 13666), clientOptions);
+	ASSERT_ALWAYS(sockS.GetSendBufferSize() >= clientOptions.sendBufferSize)
+
+	//with TCP Fast Open the connection is established by first data sent
+	std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+	std::array<std::uint8_t, 4> received;
+	size_t numSent = 0;
+	size_t numReceived = 0;
+
+	ting::net::TCPSocket sockR;
+
+#if M_OS == M_OS_LINUX
+	sockS.SetCork(true);
+#endif
+
+	for(unsigned i = 0; i < 40 && numReceived != data.size(); ++i){
+		if(numSent != data.size()){
+			//send by one byte, hinting that more data follows
+			numSent += sockS.Send(ting::Buffer<const std::uint8_t>(&*data.begin() + numSent, 1), numSent + 1 != data.size());
+#if M_OS == M_OS_LINUX
+			if(numSent == data.size()){
+				sockS.SetCork(false);
+			}
+#endif
+		}
+
+		ting::mt::Thread::Sleep(50);
+
+		if(!sockR){
+			sockR = serverSock.Accept();
+			if(!sockR){
+				continue;
+			}
+			ASSERT_ALWAYS(sockR.GetRecvBufferSize() >= serverOptions.recvBufferSize)
+#if M_OS == M_OS_LINUX
+			sockR.SetQuickAck(true);
+#endif
+		}
+
+		numReceived += sockR.Recv(ting::Buffer<std::uint8_t>(&*received.begin() + numReceived, received.size() - numReceived));
+	}
+	ASSERT_INFO_ALWAYS(numReceived == data.size(), "numReceived = " << numReceived)
+	ASSERT_ALWAYS(received == data)
+
+	//zero linger timeout, so closing resets the connection
+	sockS.Close();
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(sockR, ting::Waitable::READ);
+	ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+	waitSet.Remove(sockR);
+
+	bool isReset = false;
+	try{
+		sockR.Recv(received);
+	}catch(ting::net::Exc&){
+		isReset = true;
+	}
+	ASSERT_ALWAYS(isReset)
+}
+
+}//~namespace
+
+
+
+namespace TestBufferedStream{
+
+void Run(){
+	ting::net::TCPSocket sockS, sockR;
+	TestZeroCopy::Connect(sockS, sockR);
+
+	//small buffers, so that frames are wrapped around the ring buffers
+	ting::net::BufferedStream streamS(sockS, 100, 100);
+	ting::net::BufferedStream streamR(sockR, 100, 100);
+
+	ting::net::BufferedStream::LengthPrefixFramer lengthFramerS, lengthFramerR(90);
+
+	std::array<std::uint8_t, 2> delimiter = {{'\r', '\n'}};
+	ting::net::BufferedStream::DelimiterFramer delimiterFramerS(delimiter), delimiterFramerR(delimiter);
+
+	ting::WaitSet waitSet(2);
+	waitSet.Add(sockS, streamS.WaitingFlags());
+	waitSet.Add(sockR, streamR.WaitingFlags());
+
+	const unsigned numFrames = 1000;
+
+	//frame number i has payload of i % 90 bytes, every byte equals to i % 256, except delimiter frames which have no '\r' bytes
+	auto makePayload = [](unsigned i, bool delimited){
+		std::vector<std::uint8_t> ret(i % 90);
+		std::uint8_t v = std::uint8_t(i);
+		if(delimited && v == '\r'){
+			v = 0;
+		}
+		std::fill(ret.begin(), ret.end(), v);
+		return ret;
+	};
+
+	//first half of frames is length-prefixed, second half is delimited
+	unsigned numSent = 0;
+	unsigned numReceived = 0;
+
+	std::uint32_t startTime = ting::timer::GetTicks();
+	while(numReceived != numFrames){
+		ASSERT_ALWAYS(ting::timer::GetTicks() - startTime < 10000)
+
+		while(numSent != numFrames){
+			bool delimited = numSent >= numFrames / 2;
+			if(!streamS.WriteFrame(delimited ? static_cast<ting::net::BufferedStream::Framer&>(delimiterFramerS) : lengthFramerS, makePayload(numSent, delimited))){
+				break;
+			}
+			++numSent;
+		}
+
+		ting::Buffer<const std::uint8_t> payload;
+		while(streamR.RecvFrame(numReceived >= numFrames / 2 ? static_cast<ting::net::BufferedStream::Framer&>(delimiterFramerR) : lengthFramerR, payload)){
+			std::vector<std::uint8_t> expected = makePayload(numReceived, numReceived >= numFrames / 2);
+			ASSERT_INFO_ALWAYS(payload.size() == expected.size(), "frame #" << numReceived << ", payload.size() = " << payload.size())
+			ASSERT_INFO_ALWAYS(std::equal(payload.begin(), payload.end(), expected.begin()), "frame #" << numReceived)
+			++numReceived;
+		}
+
+		waitSet.Change(sockS, streamS.WaitingFlags());
+		waitSet.Change(sockR, streamR.WaitingFlags());
+
+		if(waitSet.WaitWithTimeout(1000) == 0){
+			continue;
+		}
+
+		streamS.HandleReadiness();
+		streamR.HandleReadiness();
+	}
+
+	ASSERT_ALWAYS(!streamS.HasPendingOutput())
+	ASSERT_ALWAYS(streamR.NumBytesAvailable() == 0)
+
+	//frames too big for the receiver are detected
+	{
+		std::vector<std::uint8_t> big(95);
+		ASSERT_ALWAYS(streamS.WriteFrame(lengthFramerS, big))
+
+		bool thrown = false;
+		ting::Buffer<const std::uint8_t> payload;
+		for(unsigned i = 0; i != 20 && !thrown; ++i){
+			ting::mt::Thread::Sleep(50);
+			streamS.Flush();
+			streamR.Fill();
+			try{
+				streamR.RecvFrame(lengthFramerR, payload);
+			}catch(ting::net::Exc&){
+				thrown = true;
+			}
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	//peer closing is detected
+	waitSet.Remove(sockS);
+	sockS.Close();
+	for(unsigned i = 0; i != 20 && !streamR.IsPeerClosed(); ++i){
+		//discard the rest of the too big frame
+		std::array<std::uint8_t, 100> buf;
+		streamR.Read(buf);
+
+		waitSet.Change(sockR, streamR.WaitingFlags());
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(1000) != 0)
+		streamR.HandleReadiness();
+	}
+	ASSERT_ALWAYS(streamR.IsPeerClosed())
+
+	waitSet.Remove(sockR);
+}
+
+}//~namespace
+
+
+
+namespace TestErrorCodes{
+
+void Run(){
+	//no pending connections is not an error
+	{
+		ting::net::TCPServerSocket serverSock;
+		serverSock.Open(13666);
+		int errorCode = -1;
+		ting::net::TCPSocket s = serverSock.Accept(errorCode);
+		ASSERT_ALWAYS(!s)
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+	}
+
+	//successful UDP send and receive
+	{
+		ting::net::UDPSocket sockS, sockR;
+		sockS.Open();
+		sockR.Open(13667);
+
+		std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+		std::array<std::uint8_t, 10> buf;
+		ting::net::IPAddress ip;
+
+		int errorCode = -1;
+		ASSERT_ALWAYS(sockR.Recv(buf, ip, errorCode) == 0)
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+
+		errorCode = -1;
+		ASSERT_ALWAYS(sockS.Send(data, ting::net::IPAddress("127.0.0.1", 13667), errorCode) == data.size())
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+
+		size_t numReceived = 0;
+		for(unsigned i = 0; i != 20 && numReceived == 0; ++i){
+			ting::mt::Thread::Sleep(50);
+			numReceived = sockR.Recv(buf, ip, errorCode);
+			ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+		}
+		ASSERT_ALWAYS(numReceived == data.size())
+	}
+
+	//connection reset by peer is reported without exception
+	{
+		ting::net::TCPSocket sockS, sockR;
+		TestZeroCopy::Connect(sockS, sockR);
+
+		std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+		int errorCode = -1;
+		ASSERT_ALWAYS(sockR.Send(data, false, errorCode) == data.size())
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+
+		sockS.SetLinger(0);
+		sockS.Close();
+
+		ting::WaitSet waitSet(1);
+		waitSet.Add(sockR, ting::Waitable::READ);
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+		waitSet.Remove(sockR);
+
+		std::array<std::uint8_t, 10> buf;
+		ASSERT_ALWAYS(sockR.Recv(buf, errorCode) == 0)
+		ASSERT_INFO_ALWAYS(errorCode != 0, "errorCode = " << errorCode)
+
+		ASSERT_ALWAYS(sockR.Send(data, false, errorCode) == 0)
+		ASSERT_INFO_ALWAYS(errorCode != 0, "errorCode = " << errorCode)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestConnect{
+
+void Run(){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13666);
+
+	//successful connection
+	{
+		ting::net::TCPSocket s;
+		s.Open(ting::net::IPAddress("127.0.0.1", 13666));
+
+		int errorCode = -1;
+		ASSERT_ALWAYS(s.WaitForConnect(3000, errorCode) == ting::net::TCPSocket::CONNECTED)
+		ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+		ASSERT_ALWAYS(s.CheckConnect(errorCode) == ting::net::TCPSocket::CONNECTED)
+	}
+
+	//refused connection, nobody listens on the port
+	{
+		ting::net::TCPSocket s;
+		s.Open(ting::net::IPAddress("127.0.0.1", 13669));
+
+		int errorCode = 0;
+		ASSERT_ALWAYS(s.WaitForConnect(3000, errorCode) == ting::net::TCPSocket::FAILED)
+		ASSERT_INFO_ALWAYS(errorCode != 0, "errorCode = " << errorCode)
+	}
+
+	//failure is reported by every CheckConnect() call, not only by the first one
+	{
+		ting::net::TCPSocket s;
+		s.Open(ting::net::IPAddress("127.0.0.1", 13669));
+
+		ting::WaitSet waitSet(1);
+		waitSet.Add(s, ting::Waitable::WRITE);
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+		waitSet.Remove(s);
+
+		int errorCode = 0;
+		ASSERT_ALWAYS(s.CheckConnect(errorCode) == ting::net::TCPSocket::FAILED)
+		ASSERT_INFO_ALWAYS(errorCode != 0, "errorCode = " << errorCode)
+
+		int errorCode2 = 0;
+		ASSERT_ALWAYS(s.CheckConnect(errorCode2) == ting::net::TCPSocket::FAILED)
+		ASSERT_INFO_ALWAYS(errorCode2 == errorCode, "errorCode = " << errorCode << " errorCode2 = " << errorCode2)
+	}
+
+	//happy eyeballs skips failing addresses
+	{
+		std::array<ting::net::IPAddress, 3> addresses = {{
+			ting::net::IPAddress("::1", 13669),
+			ting::net::IPAddress("127.0.0.1", 13669),
+			ting::net::IPAddress("127.0.0.1", 13666)
+		}};
+
+		ting::net::TCPSocket s = ting::net::TCPSocket::ConnectHappyEyeballs(addresses, 3000, 1000);
+		ASSERT_ALWAYS(s)
+		int errorCode;
+		ASSERT_ALWAYS(s.CheckConnect(errorCode) == ting::net::TCPSocket::CONNECTED)
+
+		bool thrown = false;
+		try{
+			ting::net::TCPSocket::ConnectHappyEyeballs(ting::Buffer<const ting::net::IPAddress>(&*addresses.begin(), 2), 3000);
+		}catch(ting::net::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+#if M_OS == M_OS_LINUX
+	//With TCP Fast Open the connection may be deferred until the first data is sent,
+	//the socket is writable right away and such connection counts as established.
+	{
+		ting::net::SocketOptions options;
+		options.fastOpen = true;
+
+		ting::net::TCPServerSocket fastOpenServerSock;
+		fastOpenServerSock.Open(13670, options);
+
+		ting::net::IPAddress address("127.0.0.1", 13670);
+
+		//first connection obtains fast open cookie, the following ones are deferred if the system allows it
+		for(unsigned i = 0; i != 3; ++i){
+			ting::net::TCPSocket s;
+			if(i == 2){
+				s = ting::net::TCPSocket::ConnectHappyEyeballs(ting::Buffer<const ting::net::IPAddress>(&address, 1), 3000, 250, options);
+				ASSERT_ALWAYS(s)
+			}else{
+				s.Open(address, options);
+
+				auto start = std::chrono::steady_clock::now();
+				int errorCode = -1;
+				ASSERT_ALWAYS(s.WaitForConnect(3000, errorCode) == ting::net::TCPSocket::CONNECTED)
+				ASSERT_INFO_ALWAYS(errorCode == 0, "errorCode = " << errorCode)
+				ASSERT_ALWAYS(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000))
+			}
+
+			int errorCode = -1;
+			ASSERT_ALWAYS(s.CheckConnect(errorCode) == ting::net::TCPSocket::CONNECTED)
+
+			std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+			ASSERT_ALWAYS(s.Send(data) == data.size())
+
+			ting::net::TCPSocket sockR;
+			std::array<std::uint8_t, 4> received;
+			size_t numReceived = 0;
+			for(unsigned j = 0; j < 40 && numReceived != received.size(); ++j){
+				ting::mt::Thread::Sleep(50);
+				if(!sockR){
+					sockR = fastOpenServerSock.Accept();
+					if(!sockR){
+						continue;
+					}
+				}
+				numReceived += sockR.Recv(ting::Buffer<std::uint8_t>(&*received.begin() + numReceived, received.size() - numReceived));
+			}
+			ASSERT_INFO_ALWAYS(numReceived == data.size(), "numReceived = " << numReceived)
+			ASSERT_ALWAYS(received == data)
+		}
+	}
+#endif
+}
+
+}//~namespace
+
+
+
+namespace TestUnixSockets{
+
+#if M_OS != M_OS_WINDOWS
+
+//checks that descriptor received from the socket refers to the same pipe
+void CheckPassedFd(int writeEnd, int receivedFd){
+	ASSERT_ALWAYS(receivedFd >= 0)
+	ASSERT_ALWAYS(receivedFd != writeEnd)
+
+	const std::uint8_t data = 0x5a;
+	ASSERT_ALWAYS(write(receivedFd, &data, 1) == 1)
+	close(receivedFd);
+}
+
+void TestStream(const std::string& address){
+	ting::net::UnixServerSocket serverSock;
+	serverSock.Open(address);
+
+	ting::net::UnixStreamSocket sockS;
+	sockS.Open(address);
+
+	ting::net::UnixStreamSocket sockR;
+	for(unsigned i = 0; i < 20 && !sockR; ++i){
+		ting::mt::Thread::Sleep(100);
+		sockR = serverSock.Accept();
+	}
+	ASSERT_ALWAYS(sockR)
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(sockR, ting::Waitable::READ);
+
+	//plain data
+	{
+		std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+		ASSERT_ALWAYS(sockS.Send(data) == data.size())
+
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) == 1)
+		ASSERT_ALWAYS(sockR.CanRead())
+
+		std::array<std::uint8_t, 16> buf;
+		ASSERT_ALWAYS(sockR.Recv(buf) == data.size())
+		ASSERT_ALWAYS(std::equal(data.begin(), data.end(), buf.begin()))
+	}
+
+	//file descriptor passing
+	{
+		int pipeFds[2];
+		ASSERT_ALWAYS(pipe(pipeFds) == 0)
+
+		const std::uint8_t data = 0xab;
+		ASSERT_ALWAYS(sockS.Send(ting::Buffer<const std::uint8_t>(&data, 1), ting::Buffer<const int>(&pipeFds[1], 1)) == 1)
+
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) == 1)
+
+		std::array<std::uint8_t, 16> buf;
+		std::array<int, 2> fds;
+		size_t numFds;
+		ASSERT_ALWAYS(sockR.Recv(buf, fds, numFds) == 1)
+		ASSERT_ALWAYS(buf[0] == data)
+		ASSERT_INFO_ALWAYS(numFds == 1, "numFds = " << numFds)
+
+		CheckPassedFd(pipeFds[1], fds[0]);
+		close(pipeFds[1]);
+
+		std::uint8_t b = 0;
+		ASSERT_ALWAYS(read(pipeFds[0], &b, 1) == 1)
+		ASSERT_ALWAYS(b == 0x5a)
+		close(pipeFds[0]);
+	}
+
+	waitSet.Remove(sockR);
+}
+
+void TestDatagram(const std::string& addressR, const std::string& addressS){
+	ting::net::UnixDatagramSocket sockR;
+	sockR.Open(addressR);
+
+	ting::net::UnixDatagramSocket sockS;
+	sockS.Open(addressS);
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(sockR, ting::Waitable::READ);
+
+	int pipeFds[2];
+	ASSERT_ALWAYS(pipe(pipeFds) == 0)
+
+	std::array<std::uint8_t, 3> data = {{7, 8, 9}};
+	ASSERT_ALWAYS(sockS.Send(data, addressR, ting::Buffer<const int>(&pipeFds[1], 1)) == data.size())
+
+	ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) == 1)
+
+	std::array<std::uint8_t, 16> buf;
+	std::string sender;
+	std::array<int, 2> fds;
+	size_t numFds;
+	ASSERT_ALWAYS(sockR.Recv(buf, sender, fds, numFds) == data.size())
+	ASSERT_ALWAYS(std::equal(data.begin(), data.end(), buf.begin()))
+	ASSERT_ALWAYS(sender == addressS)
+	ASSERT_INFO_ALWAYS(numFds == 1, "numFds = " << numFds)
+
+	CheckPassedFd(pipeFds[1], fds[0]);
+	close(pipeFds[1]);
+	close(pipeFds[0]);
+
+	//reply to the sender
+	ASSERT_ALWAYS(sockR.Send(ting::Buffer<const std::uint8_t>(&*data.begin(), 1), sender) == 1)
+	ASSERT_ALWAYS(sockS.Recv(buf, sender) == 1)
+	ASSERT_ALWAYS(sender == addressR)
+
+	waitSet.Remove(sockR);
+}
+
+void Run(){
+	const char* pathS = "/tmp/ting_test_unix_socket_s";
+	const char* pathR = "/tmp/ting_test_unix_socket_r";
+
+	unlink(pathS);
+	unlink(pathR);
+	TestStream(pathR);
+	unlink(pathR);
+	TestDatagram(pathR, pathS);
+	unlink(pathS);
+	unlink(pathR);
+
+#	if M_OS == M_OS_LINUX
+	TestStream(ting::net::UnixSocket::AbstractAddress("ting_test_stream"));
+	TestDatagram(
+			ting::net::UnixSocket::AbstractAddress("ting_test_dgram_r"),
+			ting::net::UnixSocket::AbstractAddress("ting_test_dgram_s")
+		);
+#	endif
+}
+
+#else
+
+void Run(){}
+
+#endif
+
+}//~namespace
+
+
+
+namespace UnixLatencyBenchmark{
+
+#if M_OS != M_OS_WINDOWS
+
+//returns average round trip time in nanoseconds
+template <class T_Socket> unsigned Measure(T_Socket& sockS, T_Socket& sockR){
+	ting::WaitSet waitSet(2);
+	waitSet.Add(sockS, ting::Waitable::READ);
+	waitSet.Add(sockR, ting::Waitable::READ);
+
+	const unsigned numRoundTrips = 10000;
+
+	std::array<std::uint8_t, 64> buf;
+	buf.fill(0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	for(unsigned i = 0; i != numRoundTrips; ++i){
+		ASSERT_ALWAYS(sockS.Send(buf) == buf.size())
+
+		for(size_t numReceived = 0; numReceived != buf.size();){
+			ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+			numReceived += sockR.Recv(ting::Buffer<std::uint8_t>(&*buf.begin() + numReceived, buf.size() - numReceived));
+		}
+
+		ASSERT_ALWAYS(sockR.Send(buf) == buf.size())
+
+		for(size_t numReceived = 0; numReceived != buf.size();){
+			ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) != 0)
+			numReceived += sockS.Recv(ting::Buffer<std::uint8_t>(&*buf.begin() + numReceived, buf.size() - numReceived));
+		}
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+	waitSet.Remove(sockR);
+	waitSet.Remove(sockS);
+
+	return unsigned(elapsed.count() / numRoundTrips);
+}
+
+void Run(){
+	unsigned tcp;
+	{
+		//small messages, so disable Naggle on both ends
+		ting::net::TCPServerSocket serverSock;
+		serverSock.Open(13666, true);
+
+		ting::net::TCPSocket sockS, sockR;
+		sockS.Open(ting::net::IPAddress("127.0.0.1", 13666), true);
+		for(unsigned i = 0; i < 20 && !sockR; ++i){
+			ting::mt::Thread::Sleep(100);
+			sockR = serverSock.Accept();
+		}
+		ASSERT_ALWAYS(sockR)
+
+		tcp = Measure(sockS, sockR);
+	}
+
+	unsigned local;
+	{
+		const char* path = "/tmp/ting_test_unix_latency";
+		unlink(path);
+
+		ting::net::UnixServerSocket serverSock;
+		serverSock.Open(path);
+
+		ting::net::UnixStreamSocket sockS, sockR;
+		sockS.Open(path);
+		for(unsigned i = 0; i < 20 && !sockR; ++i){
+			ting::mt::Thread::Sleep(100);
+			sockR = serverSock.Accept();
+		}
+		ASSERT_ALWAYS(sockR)
+
+		local = Measure(sockS, sockR);
+
+		unlink(path);
+	}
+
+	TRACE_ALWAYS(<< "\tping-pong round trip, ns (TCP loopback / Unix domain stream): " << tcp << " / " << local << std::endl)
+}
+
+#else
+
+void Run(){}
+
+#endif
+
+}//~namespace
+
+
+
+namespace TestUDPMeta{
+
+void Test(const char* ip){
+	ting::net::UDPSocket recvSock;
+	recvSock.Open(13667);
+
+#if M_OS == M_OS_LINUX
+	ASSERT_ALWAYS(recvSock.EnableRecvMeta(ting::net::UDPSocket::META_ALL) == ting::net::UDPSocket::META_ALL)
+#else
+	if(recvSock.EnableRecvMeta(ting::net::UDPSocket::META_ALL) != ting::net::UDPSocket::META_ALL){
+		TRACE_ALWAYS(<< "\tdatagram metadata is not supported, skipping test" << std::endl)
+		return;
+	}
+#endif
+
+	ting::net::UDPSocket sendSock;
+	sendSock.Open();
+
+	ting::net::IPAddress addr(ip, 13667);
+
+	const unsigned numDatagrams = 4;
+
+	std::uint64_t before = std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()
+		).count());
+
+	std::array<std::uint8_t, 4> data;
+	for(unsigned i = 0; i != numDatagrams; ++i){
+		ting::util::Serialize32BE(i, &*data.begin());
+		ASSERT_ALWAYS(sendSock.Send(data, addr) == data.size())
+	}
+
+	auto check = [&addr, before](const ting::net::UDPSocket::DatagramMeta& meta){
+		//allow some difference between the clocks
+		ASSERT_INFO_ALWAYS(meta.timestampNs + 1000000000 > before, "timestampNs = " << meta.timestampNs << " before = " << before)
+		ASSERT_INFO_ALWAYS(meta.timestampNs < before + 10000000000ull, "timestampNs = " << meta.timestampNs << " before = " << before)
+		ASSERT_ALWAYS(meta.hasDestination)
+		ASSERT_ALWAYS(addr.host == meta.destination)
+		ASSERT_ALWAYS(meta.interfaceIndex != 0)
+		ASSERT_INFO_ALWAYS(meta.ttl > 0, "ttl = " << meta.ttl)
+		ASSERT_INFO_ALWAYS(meta.tos == 0, "tos = " << meta.tos)
+	};
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(recvSock, ting::Waitable::READ);
+
+	//receive first datagram alone
+	{
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(3000) == 1)
+
+		std::array<std::uint8_t, 16> buf;
+		ting::net::IPAddress sender;
+		ting::net::UDPSocket::DatagramMeta meta;
+		ASSERT_ALWAYS(recvSock.RecvWithMeta(buf, sender, meta) == data.size())
+		ASSERT_ALWAYS(ting::util::Deserialize32BE(&*buf.begin()) == 0)
+		ASSERT_ALWAYS(sender.port == sendSock.GetLocalPort())
+		check(meta);
+	}
+
+	//receive the rest in a batch
+	{
+		std::array<std::array<std::uint8_t, 16>, numDatagrams> bufs;
+		std::array<ting::net::UDPSocket::IncomingDatagram, numDatagrams> in;
+		for(unsigned i = 0; i != in.size(); ++i){
+			in[i].buf = bufs[i];
+		}
+		std::array<ting::net::UDPSocket::DatagramMeta, numDatagrams> meta;
+
+		unsigned numReceived = 0;
+		for(unsigned i = 0; i < 10 && numReceived != numDatagrams - 1; ++i){
+			numReceived += unsigned(recvSock.RecvManyWithMeta(
+					ting::Buffer<ting::net::UDPSocket::IncomingDatagram>(&*in.begin() + numReceived, in.size() - numReceived),
+					ting::Buffer<ting::net::UDPSocket::DatagramMeta>(&*meta.begin() + numReceived, meta.size() - numReceived)
+				));
+			ting::mt::Thread::Sleep(10);
+		}
+		ASSERT_INFO_ALWAYS(numReceived == numDatagrams - 1, "numReceived = " << numReceived)
+
+		for(unsigned i = 0; i != numReceived; ++i){
+			ASSERT_ALWAYS(in[i].size == 4)
+			ASSERT_ALWAYS(ting::util::Deserialize32BE(&*in[i].buf.begin()) == i + 1)
+			check(meta[i]);
+		}
+	}
+
+	waitSet.Remove(recvSock);
+
+	//disabling metadata
+	ASSERT_ALWAYS(recvSock.EnableRecvMeta(ting::net::UDPSocket::META_NONE) == ting::net::UDPSocket::META_NONE)
+	ASSERT_ALWAYS(sendSock.Send(data, addr) == data.size())
+	ting::mt::Thread::Sleep(100);
+	{
+		std::array<std::uint8_t, 16> buf;
+		ting::net::IPAddress sender;
+		ting::net::UDPSocket::DatagramMeta meta;
+		ASSERT_ALWAYS(recvSock.RecvWithMeta(buf, sender, meta) == data.size())
+		ASSERT_ALWAYS(meta.timestampNs == 0)
+		ASSERT_ALWAYS(!meta.hasDestination)
+		ASSERT_ALWAYS(meta.ttl == -1)
+	}
+}
+
+void Run(){
+	Test("127.0.0.1");
+	if(IsIPv6SupportedByOS()){
+		Test("::1");
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestMulticast{
+
+#if M_OS == M_OS_LINUX
+
+//returns true if datagram was received within the timeout
+bool Receive(ting::WaitSet& waitSet, ting::net::UDPSocket& sock, ting::net::IPAddress& out_Sender, unsigned timeoutMillis){
+	if(waitSet.WaitWithTimeout(timeoutMillis) == 0){
+		return false;
+	}
+	std::array<std::uint8_t, 16> buf;
+	return sock.Recv(buf, out_Sender) != 0;
+}
+
+void Run(){
+	unsigned loopback = if_nametoindex("lo");
+	ASSERT_ALWAYS(loopback != 0)
+
+	ting::net::IPAddress::Host group = ting::net::IPAddress("239.1.2.3", 0).host;
+
+	ting::net::UDPSocket recvSock;
+	recvSock.Open(13670);
+
+	ting::WaitSet waitSet(1);
+	waitSet.Add(recvSock, ting::Waitable::READ);
+
+	ting::net::UDPSocket sendSock;
+	sendSock.Open();
+	sendSock.SetMulticastInterface(loopback);
+	sendSock.SetMulticastLoop(true);
+	sendSock.SetMulticastTTL(1);
+
+	std::array<std::uint8_t, 4> data = {{1, 2, 3, 4}};
+	ting::net::IPAddress groupAddr(group, 13670);
+
+	ting::net::IPAddress sender;
+
+	//any-source membership
+	recvSock.JoinGroup(group, loopback);
+	ASSERT_ALWAYS(sendSock.Send(data, groupAddr) == data.size())
+	ASSERT_ALWAYS(Receive(waitSet, recvSock, sender, 3000))
+	ASSERT_ALWAYS(sender.port == sendSock.GetLocalPort())
+
+	//joining the same group twice is an error
+	{
+		bool thrown = false;
+		try{
+			recvSock.JoinGroup(group, loopback);
+		}catch(ting::net::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	recvSock.LeaveGroup(group, loopback);
+	ASSERT_ALWAYS(sendSock.Send(data, groupAddr) == data.size())
+	ASSERT_ALWAYS(!Receive(waitSet, recvSock, sender, 200))
+
+	//source-specific membership, datagrams from other sources are not received
+	ting::net::IPAddress::Host source = sender.host;
+	recvSock.JoinSourceGroup(group, ting::net::IPAddress("10.11.12.13", 0).host, loopback);
+	ASSERT_ALWAYS(sendSock.Send(data, groupAddr) == data.size())
+	ASSERT_ALWAYS(!Receive(waitSet, recvSock, sender, 200))
+
+	recvSock.JoinSourceGroup(group, source, loopback);
+	ASSERT_ALWAYS(sendSock.Send(data, groupAddr) == data.size())
+	ASSERT_ALWAYS(Receive(waitSet, recvSock, sender, 3000))
+	ASSERT_ALWAYS(sender.port == sendSock.GetLocalPort())
+
+	recvSock.LeaveSourceGroup(group, source, loopback);
+	recvSock.LeaveSourceGroup(group, ting::net::IPAddress("10.11.12.13", 0).host, loopback);
+
+	waitSet.Remove(recvSock);
+
+	//address families of group and source should match
+	{
+		bool thrown = false;
+		try{
+			recvSock.JoinSourceGroup(ting::net::IPAddress("ff02::1:3", 0).host, source, loopback);
+		}catch(ting::net::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	//IPv6 group membership
+	recvSock.JoinGroup(ting::net::IPAddress("ff02::1:3", 0).host, loopback);
+	recvSock.LeaveGroup(ting::net::IPAddress("ff02::1:3", 0).host, loopback);
+
+	//broadcast is enabled by default, when disabled sending to broadcast address fails
+	{
+		sendSock.SetBroadcast(false);
+		int errorCode;
+		ASSERT_ALWAYS(sendSock.Send(data, ting::net::IPAddress("255.255.255.255", 13670), errorCode) == 0)
+		ASSERT_INFO_ALWAYS(errorCode == EACCES, "errorCode = " << errorCode)
+		sendSock.SetBroadcast(true);
+	}
+}
+
+#else
+
+void Run(){
+	TRACE_ALWAYS(<< "\tmulticast test is only implemented for Linux, skipping test" << std::endl)
+}
+
+#endif
+
+}//~namespace
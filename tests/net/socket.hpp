@@ -49,3 +49,147 @@ namespace TestUDPSocketWaitForWriting{
 void Run();
 
 }//~namespace
+
+
+
+namespace TestScatterGather{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestUDPBatch{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace UDPBatchBenchmark{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestUDPSegmentation{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestSendFile{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestZeroCopy{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace ZeroCopyBenchmark{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestAcceptMany{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace AcceptBenchmark{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestListenerGroup{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestSocketOptions{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestBufferedStream{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestErrorCodes{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestConnect{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestUnixSockets{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace UnixLatencyBenchmark{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestUDPMeta{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestMulticast{
+
+void Run();
+
+}//~namespace
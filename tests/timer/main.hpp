@@ -7,11 +7,28 @@
 
 
 inline void TestTingTimer(){
-	ting::timer::Lib timerLib;
+	{
+		ting::timer::Lib timerLib;
 
-	BasicTimerTest::Run();
-	SeveralTimersForTheSameInterval::Run();
-	StoppingTimers::Run();
+		BasicTimerTest::Run();
+		SeveralTimersForTheSameInterval::Run();
+		StoppingTimers::Run();
+		QueueDispatchTest::Run();
+		MicrosecondTimerTest::Run();
+		PeriodicTimerTest::Run();
+	}
+
+	{
+		ting::timer::Lib timerLib(4);
+
+		ParallelDispatchTest::Run();
+	}
+
+	ShardsTest::Run();
+
+	TimingWheelTest::Run();
+	TimingWheelBenchmark::Run();
+	StartStopStormBenchmark::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]: Timer test" << std::endl)
 }
@@ -1,7 +1,19 @@
 #include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <string>
 
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/timer.hpp"
+#include "../../src/ting/TimingWheel.hpp"
+#include "../../src/ting/WaitSet.hpp"
+#include "../../src/ting/mt/Semaphore.hpp"
 
 #include "tests.hpp"
 
@@ -180,3 +192,689 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+
+namespace TimingWheelTest{
+
+struct Node : public ting::timer::TimingWheel::Node{
+	std::uint64_t expectedExpiration;
+	bool expired = false;
+};
+
+
+
+void Run(){
+	std::mt19937_64 rnd(123);
+
+	//start not from zero to test wrapping of the levels
+	const std::uint64_t DStartTicks = 0xfffffff0;
+
+	ting::timer::TimingWheel wheel(DStartTicks);
+
+	std::vector<Node> nodes(10000);
+
+	for(auto& n : nodes){
+		//timeouts of very different magnitudes
+		unsigned bits = unsigned(rnd() % 40);
+		std::uint64_t timeout = rnd() & ((std::uint64_t(1) << bits) - 1);
+		n.expectedExpiration = DStartTicks + std::max(timeout, std::uint64_t(1));
+		wheel.Insert(n, DStartTicks + timeout);
+	}
+
+	//remove some nodes
+	for(unsigned i = 0; i < nodes.size(); i += 10){
+		wheel.Remove(nodes[i]);
+		ASSERT_ALWAYS(!nodes[i].IsInserted())
+	}
+
+	ASSERT_ALWAYS(wheel.Size() == nodes.size() - nodes.size() / 10)
+
+	std::uint64_t prevTicks = wheel.Ticks();
+	std::uint64_t lastExpiration = 0;
+	for(unsigned step = 0; wheel.Size() != 0; ++step){
+		ASSERT_ALWAYS(step < 100000)
+
+		//advance by random steps of different magnitudes
+		std::uint64_t ticks = prevTicks + 1 + (rnd() & ((std::uint64_t(1) << (rnd() % 36)) - 1));
+
+		wheel.Advance(
+				ticks,
+				[&](ting::timer::TimingWheel::Node& node){
+					Node& n = static_cast<Node&>(node);
+					ASSERT_ALWAYS(!n.IsInserted())
+					ASSERT_ALWAYS(!n.expired)
+					ASSERT_INFO_ALWAYS(n.Expiration() == n.expectedExpiration, "n.Expiration() = " << n.Expiration() << ", expected = " << n.expectedExpiration)
+					ASSERT_ALWAYS(prevTicks < n.Expiration() && n.Expiration() <= ticks)
+					ASSERT_ALWAYS(lastExpiration <= n.Expiration())
+					lastExpiration = n.Expiration();
+					n.expired = true;
+				}
+			);
+		ASSERT_ALWAYS(wheel.Ticks() == ticks)
+		prevTicks = ticks;
+	}
+
+	for(unsigned i = 0; i != nodes.size(); ++i){
+		ASSERT_ALWAYS(nodes[i].expired == (i % 10 != 0))
+	}
+}
+
+}//~namespace
+
+
+
+namespace TimingWheelBenchmark{
+
+void Run(){
+	const unsigned DNumTimers = 1000000;
+
+	TRACE_ALWAYS(<< "\tRunning TimingWheelBenchmark with " << DNumTimers << " timers..." << std::endl)
+
+	std::mt19937 rnd(321);
+
+	//timeouts up to 10 minutes
+	std::vector<std::uint64_t> timeouts(DNumTimers);
+	for(auto& t : timeouts){
+		t = 1 + rnd() % 600000;
+	}
+
+	typedef std::chrono::steady_clock T_Clock;
+
+	auto ms = [](T_Clock::duration d){
+		return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+	};
+
+	//timing wheel
+	{
+		std::vector<ting::timer::TimingWheel::Node> nodes(DNumTimers);
+
+		ting::timer::TimingWheel wheel;
+
+		auto start = T_Clock::now();
+		for(unsigned i = 0; i != DNumTimers; ++i){
+			wheel.Insert(nodes[i], timeouts[i]);
+		}
+		auto inserted = T_Clock::now();
+		for(unsigned i = 0; i < DNumTimers; i += 2){
+			wheel.Remove(nodes[i]);
+		}
+		auto removed = T_Clock::now();
+
+		//expire rest of the timers, advancing by 1 millisecond
+		unsigned numExpired = 0;
+		for(std::uint64_t t = 1; wheel.Size() != 0; ++t){
+			wheel.Advance(t, [&numExpired](ting::timer::TimingWheel::Node&){++numExpired;});
+		}
+		auto expired = T_Clock::now();
+		ASSERT_ALWAYS(numExpired == DNumTimers / 2)
+
+		TRACE_ALWAYS(<< "\t- TimingWheel: start = " << ms(inserted - start)
+				<< " ms, stop = " << ms(removed - inserted)
+				<< " ms, expire = " << ms(expired - removed) << " ms" << std::endl)
+	}
+
+	//std::multimap, as it was used before the timing wheel
+	{
+		typedef std::multimap<std::uint64_t, void*> T_Map;
+		T_Map map;
+		std::vector<T_Map::iterator> iters(DNumTimers);
+
+		auto start = T_Clock::now();
+		for(unsigned i = 0; i != DNumTimers; ++i){
+			iters[i] = map.insert(std::make_pair(timeouts[i], static_cast<void*>(&iters[i])));
+		}
+		auto inserted = T_Clock::now();
+		for(unsigned i = 0; i < DNumTimers; i += 2){
+			map.erase(iters[i]);
+		}
+		auto removed = T_Clock::now();
+
+		unsigned numExpired = 0;
+		for(std::uint64_t t = 1; map.size() != 0; ++t){
+			for(auto b = map.begin(); b != map.end() && b->first <= t; b = map.begin()){
+				++numExpired;
+				map.erase(b);
+			}
+		}
+		auto expired = T_Clock::now();
+		ASSERT_ALWAYS(numExpired == DNumTimers / 2)
+
+		TRACE_ALWAYS(<< "\t- std::multimap: start = " << ms(inserted - start)
+				<< " ms, stop = " << ms(removed - inserted)
+				<< " ms, expire = " << ms(expired - removed) << " ms" << std::endl)
+	}
+}
+
+}//~namespace
+
+
+
+
+namespace QueueDispatchTest{
+
+struct TestTimer : public ting::timer::Timer{
+	ting::mt::Thread::T_ThreadID threadID = 0;
+	unsigned numCalls = 0;
+
+	TestTimer(ting::mt::Queue& queue) :
+			ting::timer::Timer(queue)
+	{}
+
+	//override
+	void OnExpired()NOEXCEPT{
+		this->threadID = ting::mt::Thread::GetCurrentThreadID();
+		++this->numCalls;
+	}
+};
+
+
+
+void Run(){
+	ting::mt::Queue queue;
+
+	TestTimer timer(queue);
+
+	{
+		ting::WaitSet ws(1);
+		ws.Add(queue, ting::Waitable::READ);
+
+		timer.Start(100);
+
+		ASSERT_ALWAYS(ws.WaitWithTimeout(1000) == 1)
+
+		ws.Remove(queue);
+	}
+
+	//OnExpired() is called only when the message is handled
+	ASSERT_ALWAYS(timer.numCalls == 0)
+
+	{
+		ting::mt::Queue::T_Message m = queue.PeekMsg();
+		ASSERT_ALWAYS(m)
+		m();
+	}
+	ASSERT_ALWAYS(timer.numCalls == 1)
+	ASSERT_ALWAYS(timer.threadID == ting::mt::Thread::GetCurrentThreadID())
+	ASSERT_ALWAYS(!timer.Stop())
+
+	//stopping of expired timer, whose expiration is not handled yet, cancels the OnExpired() call
+	timer.Start(10);
+	ting::mt::Thread::Sleep(200);
+	ASSERT_ALWAYS(timer.Stop())
+
+	{
+		ting::mt::Queue::T_Message m = queue.PeekMsg();
+		ASSERT_ALWAYS(m)
+		m();
+	}
+	ASSERT_ALWAYS(timer.numCalls == 1)
+	ASSERT_ALWAYS(!queue.PeekMsg())
+}
+
+}//~namespace
+
+
+
+namespace ParallelDispatchTest{
+
+struct SlowTimer : public ting::timer::Timer{
+	volatile bool finished = false;
+
+	//override
+	void OnExpired()NOEXCEPT{
+		ting::mt::Thread::Sleep(500);
+		this->finished = true;
+	}
+};
+
+
+
+struct FastTimer : public ting::timer::Timer{
+	std::atomic<unsigned>& counter;
+
+	FastTimer(std::atomic<unsigned>& counter) :
+			counter(counter)
+	{}
+
+	//override
+	void OnExpired()NOEXCEPT{
+		++this->counter;
+	}
+};
+
+
+
+void Run(){
+	TRACE_ALWAYS(<< "\tRunning ParallelDispatchTest, it will take about 1 second..." << std::endl)
+
+	SlowTimer slowTimer;
+	slowTimer.Start(10);
+
+	std::atomic<unsigned> counter(0);
+
+	const unsigned DNumTimers = 20;
+
+	std::vector<std::unique_ptr<FastTimer> > timers;
+	for(unsigned i = 0; i != DNumTimers; ++i){
+		timers.push_back(std::unique_ptr<FastTimer>(new FastTimer(counter)));
+		timers.back()->Start(50);
+	}
+
+	ting::mt::Thread::Sleep(200);
+
+	//slow timer handler is still running, but timers dispatched to other threads have fired
+	ASSERT_ALWAYS(!slowTimer.finished)
+	ASSERT_ALWAYS(counter != 0)
+
+	//Stop() should wait for the handler to return
+	ASSERT_ALWAYS(!slowTimer.Stop())
+	ASSERT_ALWAYS(slowTimer.finished)
+
+	ting::mt::Thread::Sleep(200);
+	ASSERT_ALWAYS(counter == DNumTimers)
+}
+
+}//~namespace
+
+
+
+
+namespace StartStopStormBenchmark{
+
+struct TestTimer : public ting::timer::Timer{
+	//override
+	void OnExpired()NOEXCEPT{}
+};
+
+
+
+class StormThread : public ting::mt::Thread{
+public:
+	std::atomic<bool>& go;
+
+	StormThread(std::atomic<bool>& go) :
+			go(go)
+	{}
+
+	//override
+	void Run(){
+		std::array<TestTimer, 100> timers;
+
+		while(!this->go){
+			ting::mt::Thread::Sleep(1);
+		}
+
+		for(unsigned i = 0; i != 2000; ++i){
+			for(auto& t : timers){
+				t.Start(10000);
+			}
+			for(auto& t : timers){
+				ASSERT_ALWAYS(t.Stop())
+			}
+		}
+	}
+};
+
+
+
+void Run(unsigned numShards){
+	const unsigned DNumThreads = 4;
+
+	ting::timer::Lib timerLib(0, numShards);
+
+	std::atomic<bool> go(false);
+
+	std::vector<std::unique_ptr<StormThread> > threads;
+	for(unsigned i = 0; i != DNumThreads; ++i){
+		threads.push_back(std::unique_ptr<StormThread>(new StormThread(go)));
+		threads.back()->Start();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	go = true;
+
+	for(auto& t : threads){
+		t->Join();
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	TRACE_ALWAYS(<< "\t- " << DNumThreads << " threads, " << numShards << " shard(s): 800000 start/stop pairs in " << elapsed << " ms" << std::endl)
+}
+
+void Run(){
+	TRACE_ALWAYS(<< "\tRunning StartStopStormBenchmark..." << std::endl)
+
+	Run(1);
+	Run(4);
+}
+
+}//~namespace
+
+
+
+namespace ShardsTest{
+
+//returns number of threads in the process, 0 if unknown
+unsigned NumThreads(){
+#if M_OS == M_OS_LINUX
+	std::ifstream f("/proc/self/status");
+	std::string key;
+	while(f >> key){
+		if(key == "Threads:"){
+			unsigned ret;
+			f >> ret;
+			return ret;
+		}
+	}
+#endif
+	return 0;
+}
+
+
+
+struct TestTimer : public ting::timer::Timer{
+	std::atomic<bool> fired;
+
+	TestTimer() :
+			fired(false)
+	{}
+
+	//override
+	void OnExpired()NOEXCEPT{
+		this->fired = true;
+	}
+};
+
+
+
+class StartThread : public ting::mt::Thread{
+public:
+	TestTimer timer;
+
+	std::uint32_t timeout;
+
+	StartThread(std::uint32_t timeout) :
+			timeout(timeout)
+	{}
+
+	//override
+	void Run(){
+		this->timer.Start(this->timeout);
+	}
+};
+
+
+
+void Run(){
+	TRACE_ALWAYS(<< "\tRunning ShardsTest..." << std::endl)
+
+	const unsigned DNumShards = 4;
+	const unsigned DNumDispatchThreads = 2;
+
+	unsigned numThreadsBefore = NumThreads();
+
+	ting::timer::Lib timerLib(DNumDispatchThreads, DNumShards);
+
+	//all shards are serviced by one timer thread, dispatch threads are shared by the shards
+	if(numThreadsBefore != 0){
+		ASSERT_INFO_ALWAYS(
+				NumThreads() == numThreadsBefore + 1 + DNumDispatchThreads,
+				"before = " << numThreadsBefore << " after = " << NumThreads()
+			)
+	}
+
+	//start timers from different threads, so they get to different shards
+	std::vector<std::unique_ptr<StartThread> > threads;
+	for(unsigned i = 0; i != DNumShards * 2; ++i){
+		threads.push_back(std::unique_ptr<StartThread>(new StartThread(20 + 10 * i)));
+		threads.back()->Start();
+		threads.back()->Join();
+	}
+
+	ting::mt::Thread::Sleep(500);
+
+	for(auto& t : threads){
+		ASSERT_ALWAYS(t->timer.fired)
+		ASSERT_ALWAYS(!t->timer.Stop())
+	}
+}
+
+}//~namespace
+
+
+
+namespace MicrosecondTimerTest{
+
+struct TestTimer : public ting::timer::Timer{
+	ting::mt::Semaphore sema;
+	std::uint64_t expiredAt = 0;
+
+	//override
+	void OnExpired()NOEXCEPT{
+		this->expiredAt = ting::timer::GetNanoTicks();
+		this->sema.Signal();
+	}
+};
+
+
+
+void Run(){
+	//nanosecond ticks are monotonic
+	{
+		std::uint64_t prev = ting::timer::GetNanoTicks();
+		for(unsigned i = 0; i != 1000; ++i){
+			std::uint64_t cur = ting::timer::GetNanoTicks();
+			ASSERT_ALWAYS(cur >= prev)
+			prev = cur;
+		}
+	}
+
+	TestTimer timer;
+
+	const std::chrono::microseconds timeout(500);
+	const unsigned numIterations = 20;
+
+	std::uint64_t total = 0;
+	std::uint64_t maxLatency = 0;
+
+	for(unsigned i = 0; i != numIterations; ++i){
+		std::uint64_t startedAt = ting::timer::GetNanoTicks();
+		timer.Start(timeout);
+		ASSERT_ALWAYS(timer.sema.Wait(1000))
+
+		std::uint64_t elapsed = timer.expiredAt - startedAt;
+		ASSERT_INFO_ALWAYS(elapsed >= std::uint64_t(std::chrono::nanoseconds(timeout).count()), "elapsed = " << elapsed)
+
+		total += elapsed;
+		maxLatency = std::max(maxLatency, elapsed - std::chrono::nanoseconds(timeout).count());
+	}
+
+	std::uint64_t average = total / numIterations;
+	TRACE_ALWAYS(<< "\t500 us timer: average time to expire = " << (average / 1000) << " us, max latency = " << (maxLatency / 1000) << " us" << std::endl)
+
+	//accuracy should be much better than the old tens of milliseconds, allow big margin for loaded systems
+	ASSERT_INFO_ALWAYS(average < 5000000, "average = " << average)
+}
+
+}//~namespace
+
+
+
+
+namespace PeriodicTimerTest{
+
+struct TestTimer : public ting::timer::Timer{
+	std::mutex mutex;
+	std::vector<std::uint64_t> expirations;
+
+	//override
+	void OnExpired()NOEXCEPT{
+		std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+		this->expirations.push_back(ting::timer::GetNanoTicks());
+	}
+
+	size_t NumExpirations(){
+		std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+		return this->expirations.size();
+	}
+};
+
+
+
+struct BlockingTimer : public ting::timer::Timer{
+	std::atomic<bool> entered;
+	std::atomic<bool> finished;
+	ting::mt::Semaphore release;
+
+	BlockingTimer() :
+			entered(false),
+			finished(false)
+	{}
+
+	//override
+	void OnExpired()NOEXCEPT{
+		if(this->entered){
+			return;
+		}
+		this->entered = true;
+		this->release.Wait();
+		this->finished = true;
+	}
+};
+
+
+
+class StopThread : public ting::mt::Thread{
+public:
+	ting::timer::Timer& timer;
+	std::atomic<bool> returned;
+	bool result = false;
+
+	StopThread(ting::timer::Timer& timer) :
+			timer(timer),
+			returned(false)
+	{}
+
+	//override
+	void Run(){
+		this->result = this->timer.Stop();
+		this->returned = true;
+	}
+};
+
+
+
+void Run(){
+	//Stop() waits for OnExpired() of periodic timer, which is already re-armed while OnExpired() runs
+	{
+		BlockingTimer timer;
+		timer.StartPeriodic(std::chrono::milliseconds(10));
+
+		for(unsigned i = 0; i != 200 && !timer.entered; ++i){
+			ting::mt::Thread::Sleep(10);
+		}
+		ASSERT_ALWAYS(timer.entered)
+
+		StopThread stopThread(timer);
+		stopThread.Start();
+
+		ting::mt::Thread::Sleep(100);
+		ASSERT_ALWAYS(!stopThread.returned)
+
+		timer.release.Signal();
+		stopThread.Join();
+
+		ASSERT_ALWAYS(stopThread.returned)
+		ASSERT_ALWAYS(stopThread.result)
+		ASSERT_ALWAYS(timer.finished)
+	}
+
+	//periodic timer does not drift
+	{
+		TestTimer timer;
+
+		const std::uint64_t period = 5000000;//5 ms
+		const size_t numExpirations = 50;
+
+		std::uint64_t startedAt = ting::timer::GetNanoTicks();
+		timer.StartPeriodic(std::chrono::nanoseconds(period));
+
+		//starting running timer is an error
+		{
+			bool thrown = false;
+			try{
+				timer.StartPeriodic(std::chrono::nanoseconds(period));
+			}catch(ting::Exc&){
+				thrown = true;
+			}
+			ASSERT_ALWAYS(thrown)
+		}
+
+		for(unsigned i = 0; i != 200 && timer.NumExpirations() < numExpirations; ++i){
+			ting::mt::Thread::Sleep(10);
+		}
+
+		ASSERT_ALWAYS(timer.Stop())
+
+		size_t num = timer.NumExpirations();
+		ASSERT_INFO_ALWAYS(num >= numExpirations, "num = " << num)
+
+		//k-th expiration is never earlier than k periods since start, missed periods are skipped
+		for(size_t k = 0; k != num; ++k){
+			ASSERT_INFO_ALWAYS(timer.expirations[k] >= startedAt + (k + 1) * period, "k = " << k)
+		}
+
+		std::uint64_t lateness = timer.expirations[numExpirations - 1] - (startedAt + numExpirations * period);
+		TRACE_ALWAYS(<< "\tperiodic timer: " << numExpirations << "th expiration is late by " << (lateness / 1000) << " us" << std::endl)
+		ASSERT_INFO_ALWAYS(lateness < 20000000, "lateness = " << lateness)
+
+		//timer does not expire after it is stopped
+		ting::mt::Thread::Sleep(20);
+		ASSERT_ALWAYS(timer.NumExpirations() == num)
+		ASSERT_ALWAYS(!timer.Stop())
+	}
+
+	//timers with nearby deadlines and enough slack are expired together
+	{
+		const unsigned numTimers = 10;
+		const std::uint64_t timeout = 50000000;//50 ms
+		const std::uint64_t step = 100000;//100 us
+		const std::uint64_t slack = 10000000;//10 ms
+
+		std::vector<std::unique_ptr<TestTimer>> timers;
+		std::vector<std::uint64_t> startedAt;
+
+		for(unsigned i = 0; i != numTimers; ++i){
+			timers.push_back(std::unique_ptr<TestTimer>(new TestTimer()));
+			startedAt.push_back(ting::timer::GetNanoTicks());
+			timers.back()->Start(std::chrono::nanoseconds(timeout + i * step), std::chrono::nanoseconds(slack));
+		}
+
+		ting::mt::Thread::Sleep(200);
+
+		std::vector<std::uint64_t> times;
+		for(unsigned i = 0; i != numTimers; ++i){
+			ASSERT_ALWAYS(timers[i]->NumExpirations() == 1)
+			std::uint64_t t = timers[i]->expirations[0];
+			std::uint64_t deadline = startedAt[i] + timeout + i * step;
+			ASSERT_ALWAYS(t >= deadline)
+			ASSERT_INFO_ALWAYS(t - deadline < slack + 20000000, "t - deadline = " << (t - deadline))
+			times.push_back(t);
+		}
+
+		std::sort(times.begin(), times.end());
+		unsigned numWakeups = 1;
+		for(unsigned i = 1; i != times.size(); ++i){
+			if(times[i] - times[i - 1] > 1000000){
+				++numWakeups;
+			}
+		}
+		TRACE_ALWAYS(<< "\t" << numTimers << " timers with slack expired in " << numWakeups << " wakeups" << std::endl)
+		ASSERT_INFO_ALWAYS(numWakeups <= 3, "numWakeups = " << numWakeups)
+	}
+}
+
+}//~namespace
@@ -13,3 +13,35 @@ void Run();
 namespace StoppingTimers{
 void Run();
 }//~namespace
+
+namespace TimingWheelTest{
+void Run();
+}//~namespace
+
+namespace TimingWheelBenchmark{
+void Run();
+}//~namespace
+
+namespace QueueDispatchTest{
+void Run();
+}//~namespace
+
+namespace ParallelDispatchTest{
+void Run();
+}//~namespace
+
+namespace StartStopStormBenchmark{
+void Run();
+}//~namespace
+
+namespace MicrosecondTimerTest{
+void Run();
+}//~namespace
+
+namespace PeriodicTimerTest{
+void Run();
+}//~namespace
+
+namespace ShardsTest{
+void Run();
+}//~namespace